@@ -0,0 +1,414 @@
+#include "agent_protocol.h"
+#include "sha256.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/mount.h>
+#endif
+
+// ============================================================================
+// salamander-agent - Device-side helper for batched plugin operations
+// ============================================================================
+//
+// Started by salamander over its persistent SSH session (stdin/stdout are the
+// channel, see agent_protocol.h) and kept running until the session closes.
+// Handles every request in-process, so a batch of deletes, renames, hashes
+// and a sync costs one round trip and no fork/exec. Build it with the same
+// toolchain as the plugins; it needs nothing beyond libc.
+
+#define AGENT_READ_CHUNK (64 * 1024)
+
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static Buffer g_in = {0};       // Request bytes not yet handled
+static Buffer g_out = {0};      // Replies not yet written
+static size_t g_replyStart = 0; // Header offset of the reply being built
+
+static void Reserve(Buffer *b, size_t extra) {
+    if (b->length + extra <= b->capacity) return;
+    size_t capacity = b->capacity ? b->capacity : AGENT_READ_CHUNK;
+    while (capacity < b->length + extra) capacity *= 2;
+    unsigned char *grown = realloc(b->data, capacity);
+    if (!grown) {
+        fprintf(stderr, "salamander-agent: out of memory\n");
+        exit(1);
+    }
+    b->data = grown;
+    b->capacity = capacity;
+}
+
+// ============================================================================
+// Replies
+// ============================================================================
+
+static void BeginReply(void) {
+    Reserve(&g_out, AGENT_HEADER_SIZE);
+    g_replyStart = g_out.length;
+    g_out.length += AGENT_HEADER_SIZE;
+}
+
+static void AppendReply(const void *data, size_t len) {
+    Reserve(&g_out, len);
+    memcpy(g_out.data + g_out.length, data, len);
+    g_out.length += len;
+}
+
+static void AppendText(const char *text) {
+    AppendReply(text, strlen(text));
+}
+
+static void EndReply(int status) {
+    AgentPutU32(g_out.data + g_replyStart, (uint32_t)(g_out.length - g_replyStart - 4));
+    g_out.data[g_replyStart + 4] = (unsigned char)(status > 255 ? EIO : status);
+}
+
+static void Reply(int status) {
+    BeginReply();
+    EndReply(status);
+}
+
+static void FlushReplies(void) {
+    size_t sent = 0;
+    while (sent < g_out.length) {
+        ssize_t n = write(STDOUT_FILENO, g_out.data + sent, g_out.length - sent);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) exit(0);    // Client went away
+        sent += (size_t)n;
+    }
+    g_out.length = 0;
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+// Next NUL-terminated string in a payload (NULL if it runs off the end)
+static const char *TakeString(const unsigned char **p, const unsigned char *end) {
+    const unsigned char *nul = memchr(*p, '\0', (size_t)(end - *p));
+    if (!nul) return NULL;
+    const char *s = (const char *)*p;
+    *p = nul + 1;
+    return s;
+}
+
+static bool EndsWithSo(const char *name) {
+    size_t len = strlen(name);
+    return len > 3 && strcmp(name + len - 3, ".so") == 0;
+}
+
+static void HandleInventory(const unsigned char *p, const unsigned char *end) {
+    if (p == end) {
+        Reply(EINVAL);
+        return;
+    }
+    bool withHashes = *p++ != 0;
+    const char *dir = TakeString(&p, end);
+    if (!dir) {
+        Reply(EINVAL);
+        return;
+    }
+
+    BeginReply();
+
+    // Same identity line the shell listing prints
+    char id[256] = "";
+    FILE *fp = fopen("/etc/machine-id", "r");
+    if (fp) {
+        if (!fgets(id, sizeof(id), fp)) id[0] = '\0';
+        fclose(fp);
+    }
+    id[strcspn(id, "\n")] = '\0';
+    if (id[0] == '\0' && gethostname(id, sizeof(id) - 1) != 0) id[0] = '\0';
+    AppendText("I ");
+    AppendText(id);
+    AppendText("\n");
+
+    DIR *d = opendir(dir);
+    if (!d) {
+        EndReply(AGENT_OK);
+        return;
+    }
+
+    // F lines first, then H lines, like stat followed by sha256sum
+    size_t hashStart = 0;
+    Buffer names = {0};
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (!EndsWithSo(entry->d_name)) continue;
+
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        char line[512];
+        snprintf(line, sizeof(line), "F %lld %lld ", (long long)st.st_size, (long long)st.st_mtime);
+        AppendText(line);
+        AppendText(entry->d_name);
+        AppendText("\n");
+
+        if (withHashes) {
+            size_t len = strlen(entry->d_name) + 1;
+            Reserve(&names, len);
+            memcpy(names.data + names.length, entry->d_name, len);
+            names.length += len;
+        }
+    }
+    closedir(d);
+
+    while (hashStart < names.length) {
+        const char *name = (const char *)names.data + hashStart;
+        hashStart += strlen(name) + 1;
+
+        char path[4096];
+        char hex[SHA256_HEX_SIZE];
+        snprintf(path, sizeof(path), "%s/%s", dir, name);
+        if (!Sha256File(path, hex)) continue;
+        AppendText("H ");
+        AppendText(hex);
+        AppendText("  ");
+        AppendText(name);
+        AppendText("\n");
+    }
+    free(names.data);
+    EndReply(AGENT_OK);
+}
+
+static void HandleHash(const unsigned char *p, const unsigned char *end) {
+    const char *path = TakeString(&p, end);
+    char hex[SHA256_HEX_SIZE];
+    if (!path) {
+        Reply(EINVAL);
+    } else if (!Sha256File(path, hex)) {
+        Reply(errno ? errno : EIO);
+    } else {
+        BeginReply();
+        AppendText(hex);
+        EndReply(AGENT_OK);
+    }
+}
+
+static void HandleStat(const unsigned char *p, const unsigned char *end) {
+    const char *path = TakeString(&p, end);
+    struct stat st;
+    if (!path) {
+        Reply(EINVAL);
+    } else if (stat(path, &st) != 0) {
+        Reply(errno);
+    } else {
+        char line[64];
+        snprintf(line, sizeof(line), "%lld %lld", (long long)st.st_size, (long long)st.st_mtime);
+        BeginReply();
+        AppendText(line);
+        EndReply(AGENT_OK);
+    }
+}
+
+static void HandleWrite(const unsigned char *p, const unsigned char *end) {
+    if (p == end) {
+        Reply(EINVAL);
+        return;
+    }
+    bool append = *p++ != 0;
+    const char *path = TakeString(&p, end);
+    if (!path) {
+        Reply(EINVAL);
+        return;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    if (fd < 0) {
+        Reply(errno);
+        return;
+    }
+    int status = AGENT_OK;
+    while (p < end) {
+        ssize_t n = write(fd, p, (size_t)(end - p));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            status = n < 0 ? errno : ENOSPC;
+            break;
+        }
+        p += n;
+    }
+    if (close(fd) != 0 && status == AGENT_OK) status = errno;
+    Reply(status);
+}
+
+static void HandleRename(const unsigned char *p, const unsigned char *end) {
+    const char *from = TakeString(&p, end);
+    const char *to = from ? TakeString(&p, end) : NULL;
+    if (!to) {
+        Reply(EINVAL);
+    } else {
+        Reply(rename(from, to) == 0 ? AGENT_OK : errno);
+    }
+}
+
+static int RemoveTree(const char *path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) return errno == ENOENT ? AGENT_OK : errno;
+    if (!S_ISDIR(st.st_mode)) return unlink(path) == 0 ? AGENT_OK : errno;
+
+    DIR *d = opendir(path);
+    if (!d) return errno;
+    int status = AGENT_OK;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        char child[4096];
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        int childStatus = RemoveTree(child);
+        if (status == AGENT_OK) status = childStatus;
+    }
+    closedir(d);
+    if (rmdir(path) != 0 && status == AGENT_OK) status = errno;
+    return status;
+}
+
+static void HandleDelete(const unsigned char *p, const unsigned char *end) {
+    if (p == end) {
+        Reply(EINVAL);
+        return;
+    }
+    bool recursive = *p++ != 0;
+    const char *path = TakeString(&p, end);
+    if (!path) {
+        Reply(EINVAL);
+    } else if (recursive) {
+        Reply(RemoveTree(path));
+    } else {
+        Reply(unlink(path) == 0 || errno == ENOENT ? AGENT_OK : errno);
+    }
+}
+
+static void HandleMkdir(const unsigned char *p, const unsigned char *end) {
+    const char *path = TakeString(&p, end);
+    char partial[4096];
+    if (!path || strlen(path) >= sizeof(partial)) {
+        Reply(EINVAL);
+        return;
+    }
+
+    snprintf(partial, sizeof(partial), "%s", path);
+    for (char *slash = partial + 1; ; slash++) {
+        bool last = (*slash == '\0');
+        if (*slash != '/' && !last) continue;
+        *slash = '\0';
+        if (mkdir(partial, 0755) != 0 && errno != EEXIST) {
+            Reply(errno);
+            return;
+        }
+        if (last) break;
+        *slash = '/';
+    }
+    Reply(AGENT_OK);
+}
+
+static void HandleRemount(const unsigned char *p, const unsigned char *end) {
+    const char *mountPoint = TakeString(&p, end);
+    if (!mountPoint) {
+        Reply(EINVAL);
+        return;
+    }
+#ifdef __linux__
+    Reply(mount(NULL, mountPoint, NULL, MS_REMOUNT, NULL) == 0 ? AGENT_OK : errno);
+#else
+    Reply(ENOSYS);
+#endif
+}
+
+static void HandleReload(const unsigned char *p, const unsigned char *end) {
+    const char *fifo = TakeString(&p, end);
+    if (!fifo) {
+        Reply(EINVAL);
+        return;
+    }
+
+    // Write-only and non-blocking: fails with ENXIO when nobody reads
+    int fd = open(fifo, O_WRONLY | O_NONBLOCK);
+    if (fd < 0) {
+        Reply(errno);
+        return;
+    }
+    int status = AGENT_OK;
+    if (write(fd, p, (size_t)(end - p)) != (ssize_t)(end - p)) status = errno ? errno : EIO;
+    close(fd);
+    Reply(status);
+}
+
+static void HandleFrame(int op, const unsigned char *p, const unsigned char *end) {
+    errno = 0;
+    switch (op) {
+        case AGENT_OP_HELLO: {
+            char hello[64];
+            snprintf(hello, sizeof(hello), "salamander-agent %d", AGENT_PROTOCOL_VERSION);
+            BeginReply();
+            AppendText(hello);
+            EndReply(AGENT_OK);
+            break;
+        }
+        case AGENT_OP_INVENTORY: HandleInventory(p, end); break;
+        case AGENT_OP_HASH:      HandleHash(p, end); break;
+        case AGENT_OP_STAT:      HandleStat(p, end); break;
+        case AGENT_OP_WRITE:     HandleWrite(p, end); break;
+        case AGENT_OP_RENAME:    HandleRename(p, end); break;
+        case AGENT_OP_DELETE:    HandleDelete(p, end); break;
+        case AGENT_OP_MKDIR:     HandleMkdir(p, end); break;
+        case AGENT_OP_REMOUNT:   HandleRemount(p, end); break;
+        case AGENT_OP_SYNC:      sync(); Reply(AGENT_OK); break;
+        case AGENT_OP_RELOAD:    HandleReload(p, end); break;
+        default:                 Reply(ENOSYS); break;
+    }
+}
+
+// ============================================================================
+// Main loop
+// ============================================================================
+
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+
+    for (;;) {
+        // Answer everything already received, then send the replies in one
+        // write before blocking for more
+        size_t offset = 0;
+        while (g_in.length - offset >= AGENT_HEADER_SIZE) {
+            uint32_t length = AgentGetU32(g_in.data + offset);
+            if (length < 1 || length > AGENT_MAX_FRAME) {
+                fprintf(stderr, "salamander-agent: bad frame length %u\n", length);
+                return 1;
+            }
+            if (g_in.length - offset < 4 + (size_t)length) break;
+
+            const unsigned char *frame = g_in.data + offset + 4;
+            HandleFrame(frame[0], frame + 1, frame + length);
+            offset += 4 + (size_t)length;
+        }
+        if (offset > 0) {
+            memmove(g_in.data, g_in.data + offset, g_in.length - offset);
+            g_in.length -= offset;
+        }
+
+        FlushReplies();
+
+        Reserve(&g_in, AGENT_READ_CHUNK);
+        ssize_t n = read(STDIN_FILENO, g_in.data + g_in.length, g_in.capacity - g_in.length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;      // Session closed
+        g_in.length += (size_t)n;
+    }
+    return 0;
+}
@@ -0,0 +1,738 @@
+// ============================================================================
+// salamander_bench - Performance regression suite against a mock device
+// ============================================================================
+//
+// Runs the real ssh_manager and plugin_browser code against a fake CarThing:
+// the benchmark links itself into a private bin directory as `ssh` and
+// `sshpass` and puts that first on PATH, so every command the engine spawns
+// lands back in this binary. Invoked under those names it plays the device:
+// device paths are rewritten into a scratch root, each command costs one
+// simulated round trip, and bytes streamed into a command are paced to the
+// configured link bandwidth. No sshd, network or CarThing is involved, so
+// runs are repeatable on any Linux host.
+//
+// Results go to stdout (or --out) as fixed-width lines, one per
+// benchmark/case/metric, in a fixed order; diff two runs to compare commits.
+// Engine logs are dropped unless --verbose sends them to stderr.
+
+#include "ssh_manager.h"
+#include "plugin_browser.h"
+#include "file_hasher.h"
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define BENCH_FORMAT_VERSION 1
+
+// Defaults model the CarThing's USB gadget link
+#define BENCH_DEFAULT_LATENCY_MS 1.0
+#define BENCH_DEFAULT_BANDWIDTH_MBPS 40.0
+#define BENCH_DEFAULT_REPS 3
+#define BENCH_MAX_REPS 50
+
+// Handshake cost of opening the master, in round trips
+#define BENCH_HANDSHAKE_RTTS 3
+
+// Frames averaged per frame-cost sample
+#define BENCH_FRAME_LOOPS 2000
+
+// Device paths the engine uses, relocated under the mock root
+static const char *const g_devicePrefixes[] = {
+    "/usr/lib/llizard", "/var/lib/llizard", "/etc/llizard", "/tmp/llizard", "/tmp/salamander-agent",
+};
+
+// Device commands with side effects on a real CarThing (or on the host,
+// here) that the mock only pretends to run. The mock device has no rsync,
+// so updates take the streamed path being measured.
+static const struct {
+    const char *from;
+    const char *to;
+} g_deviceStubs[] = {
+    { "mount -o remount,rw /", "true" },
+    { "sv stop", "true" },
+    { "sv start", "true" },
+    { "sv restart", "true" },
+    { "pkill", "true" },
+    { "command -v rsync", "false" },
+};
+
+typedef struct {
+    bool quick;
+    bool verbose;
+    int reps;
+    double latencyMs;
+    double bandwidthMbps;       // 0 = unlimited
+    const char *outPath;
+} BenchOptions;
+
+static char g_benchDir[256] = "";
+static char g_deviceDir[512] = "";          // Mock device's plugin directory
+static FILE *g_report = NULL;
+static int g_failures = 0;
+
+static double NowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void SleepMs(double ms) {
+    if (ms <= 0) return;
+    struct timespec ts = { (time_t)(ms / 1000.0), (long)(((long long)(ms * 1e6)) % 1000000000LL) };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+// ============================================================================
+// Mock device (this binary run as ssh / sshpass)
+// ============================================================================
+
+static double EnvDouble(const char *name) {
+    const char *value = getenv(name);
+    return value ? atof(value) : 0.0;
+}
+
+// Device paths into the mock root, stubbed commands replaced
+static char *RewriteCommand(const char *command, const char *root) {
+    size_t rootLen = strlen(root);
+    size_t capacity = strlen(command) * 2 + 64;
+    char *out = malloc(capacity);
+    if (!out) return NULL;
+
+    size_t o = 0;
+    for (const char *c = command; *c;) {
+        const char *insert = NULL;
+        size_t skip = 0;
+        bool prefix = false;
+        for (size_t i = 0; i < sizeof(g_deviceStubs) / sizeof(g_deviceStubs[0]) && !insert; i++) {
+            size_t n = strlen(g_deviceStubs[i].from);
+            if (strncmp(c, g_deviceStubs[i].from, n) == 0) {
+                insert = g_deviceStubs[i].to;
+                skip = n;
+            }
+        }
+        for (size_t i = 0; i < sizeof(g_devicePrefixes) / sizeof(g_devicePrefixes[0]) && !insert; i++) {
+            size_t n = strlen(g_devicePrefixes[i]);
+            if (strncmp(c, g_devicePrefixes[i], n) == 0) {
+                insert = g_devicePrefixes[i];
+                skip = n;
+                prefix = true;
+            }
+        }
+
+        size_t need = insert ? (prefix ? rootLen : 0) + strlen(insert) : 1;
+        if (o + need + 1 > capacity) {
+            capacity = (o + need + 1) * 2;
+            char *grown = realloc(out, capacity);
+            if (!grown) {
+                free(out);
+                return NULL;
+            }
+            out = grown;
+        }
+        if (!insert) {
+            out[o++] = *c++;
+            continue;
+        }
+        if (prefix) {
+            memcpy(out + o, root, rootLen);
+            o += rootLen;
+        }
+        memcpy(out + o, insert, strlen(insert));
+        o += strlen(insert);
+        c += skip;
+    }
+    out[o] = '\0';
+    // `sync` on its own would flush the host's disks
+    if (strcmp(out, "sync") == 0) strcpy(out, "true");
+    return out;
+}
+
+static bool WriteAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+// Feed our stdin to the command no faster than the link allows
+static int RunPaced(const char *command, double bytesPerSec) {
+    int fds[2];
+    if (pipe(fds) != 0) return 255;
+    pid_t pid = fork();
+    if (pid < 0) return 255;
+    if (pid == 0) {
+        dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+        _exit(127);
+    }
+    close(fds[0]);
+    signal(SIGPIPE, SIG_IGN);
+
+    char buffer[16384];
+    double start = NowMs();
+    long long sent = 0;
+    ssize_t n;
+    while ((n = read(STDIN_FILENO, buffer, sizeof(buffer))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (!WriteAll(fds[1], buffer, (size_t)n)) break;  // Receiver gave up
+        sent += n;
+        SleepMs(start + sent * 1000.0 / bytesPerSec - NowMs());
+    }
+    close(fds[1]);
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 255;
+}
+
+static int MockSsh(int argc, char **argv) {
+    const char *benchDir = getenv("SALAMANDER_BENCH_DIR");
+    if (!benchDir) {
+        fprintf(stderr, "ssh: salamander_bench mock run outside the benchmark\n");
+        return 255;
+    }
+    double latencyMs = EnvDouble("SALAMANDER_BENCH_LATENCY_MS");
+    double bytesPerSec = EnvDouble("SALAMANDER_BENCH_BPS");
+
+    bool master = false;
+    const char *control = NULL;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            if (strcmp(argv[++i], "ControlMaster=yes") == 0) master = true;
+        } else if (strcmp(argv[i], "-O") == 0 && i + 1 < argc) {
+            control = argv[++i];
+        } else if (argv[i][1] && strchr("pilFS", argv[i][1]) && argv[i][2] == '\0' && i + 1 < argc) {
+            i++;
+        }
+    }
+    i++;    // user@host
+
+    char marker[PATH_MAX];
+    snprintf(marker, sizeof(marker), "%s/master", benchDir);
+    if (control) {
+        if (strcmp(control, "check") == 0) return access(marker, F_OK) == 0 ? 0 : 255;
+        unlink(marker);
+        return 0;
+    }
+    if (master) {
+        SleepMs(latencyMs * BENCH_HANDSHAKE_RTTS);
+        int fd = open(marker, O_WRONLY | O_CREAT, 0644);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+
+    // ssh joins the remaining words into one remote command line
+    size_t length = 1;
+    for (int j = i; j < argc; j++) length += strlen(argv[j]) + 1;
+    char *command = calloc(1, length);
+    if (!command) return 255;
+    for (int j = i; j < argc; j++) {
+        if (j > i) strcat(command, " ");
+        strcat(command, argv[j]);
+    }
+    if (command[0] == '\0') return 0;
+
+    char root[PATH_MAX];
+    snprintf(root, sizeof(root), "%s/device", benchDir);
+    char *rewritten = RewriteCommand(command, root);
+    free(command);
+    if (!rewritten) return 255;
+
+    SleepMs(latencyMs);
+
+    // Only transfers get a pipe on stdin (the benchmark's own is /dev/null)
+    struct stat st;
+    if (bytesPerSec > 0 && fstat(STDIN_FILENO, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        int status = RunPaced(rewritten, bytesPerSec);
+        free(rewritten);
+        return status;
+    }
+    execl("/bin/sh", "sh", "-c", rewritten, (char *)NULL);
+    return 127;
+}
+
+static int MockSshpass(int argc, char **argv) {
+    int i = 1;
+    if (i + 1 < argc && strcmp(argv[i], "-p") == 0) i += 2;
+    if (i >= argc) return 1;
+    execvp(argv[i], argv + i);
+    return 127;
+}
+
+// ============================================================================
+// Fixtures
+// ============================================================================
+
+static void RemoveTree(const char *path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) return;
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(path);
+        struct dirent *entry;
+        while (dir && (entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            char child[PATH_MAX];
+            snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+            RemoveTree(child);
+        }
+        if (dir) closedir(dir);
+    }
+    remove(path);
+}
+
+static bool MakeDirs(const char *path) {
+    char buffer[PATH_MAX];
+    snprintf(buffer, sizeof(buffer), "%s", path);
+    for (char *p = buffer + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buffer, 0755) != 0 && errno != EEXIST) return false;
+        *p = '/';
+    }
+    return mkdir(buffer, 0755) == 0 || errno == EEXIST;
+}
+
+// Deterministic plugin-like contents: alternating random and repetitive
+// 4 KB blocks (code-like text with a random byte every 32), so gzip gets
+// roughly the 2:1 a stripped .so gives
+static bool WritePlugin(const char *path, size_t size, uint64_t seed) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    uint64_t state = seed * 0x9e3779b97f4a7c15ull + 1;
+    unsigned char block[4096];
+    for (size_t offset = 0, n = 0; offset < size; offset += sizeof(block), n++) {
+        for (size_t i = 0; i < sizeof(block); i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            block[i] = (n % 2 == 0 || i % 32 == 0) ? (unsigned char)state : (unsigned char)"ldr r0, [sp]\n"[i % 13];
+        }
+        size_t part = size - offset < sizeof(block) ? size - offset : sizeof(block);
+        if (fwrite(block, 1, part, f) != part) {
+            fclose(f);
+            return false;
+        }
+    }
+    return fclose(f) == 0;
+}
+
+static bool CopyFile(const char *from, const char *to) {
+    FILE *in = fopen(from, "rb");
+    FILE *out = in ? fopen(to, "wb") : NULL;
+    bool ok = in && out;
+    char buffer[65536];
+    size_t n;
+    while (ok && (n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        ok = fwrite(buffer, 1, n, out) == n;
+    }
+    if (in) fclose(in);
+    if (out && fclose(out) != 0) ok = false;
+    return ok;
+}
+
+// A local build directory of count plugins, optionally already on the device
+static bool MakePluginSet(const char *localDir, int count, size_t size, bool onDevice) {
+    RemoveTree(localDir);
+    if (!MakeDirs(localDir)) return false;
+    for (int i = 0; i < count; i++) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/bench_%03d.so", localDir, i);
+        if (!WritePlugin(path, size, (uint64_t)i + 1)) return false;
+        if (onDevice) {
+            char remote[PATH_MAX];
+            snprintf(remote, sizeof(remote), "%s/bench_%03d.so", g_deviceDir, i);
+            if (!CopyFile(path, remote)) return false;
+        }
+    }
+    return true;
+}
+
+static void ClearDevice(void) {
+    RemoveTree(g_deviceDir);
+    MakeDirs(g_deviceDir);
+}
+
+static bool SetUpBenchDir(const BenchOptions *options) {
+    const char *tmp = getenv("TMPDIR");
+    int n = snprintf(g_benchDir, sizeof(g_benchDir), "%s/salamander-bench.XXXXXX", tmp && tmp[0] ? tmp : "/tmp");
+    if (n < 0 || (size_t)n >= sizeof(g_benchDir) || !mkdtemp(g_benchDir)) {
+        g_benchDir[0] = '\0';
+        return false;
+    }
+
+    char self[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) return false;
+    self[length] = '\0';
+
+    char bin[PATH_MAX], link[PATH_MAX + 16];
+    snprintf(bin, sizeof(bin), "%s/bin", g_benchDir);
+    if (!MakeDirs(bin)) return false;
+    snprintf(link, sizeof(link), "%s/ssh", bin);
+    if (symlink(self, link) != 0) return false;
+    snprintf(link, sizeof(link), "%s/sshpass", bin);
+    if (symlink(self, link) != 0) return false;
+
+    snprintf(g_deviceDir, sizeof(g_deviceDir), "%s/device" SSH_PLUGIN_PATH, g_benchDir);
+    if (!MakeDirs(g_deviceDir)) return false;
+
+    char value[PATH_MAX * 2];
+    const char *path = getenv("PATH");
+    snprintf(value, sizeof(value), "%s:%s", bin, path ? path : "/usr/bin:/bin");
+    setenv("PATH", value, 1);
+    setenv("SALAMANDER_BENCH_DIR", g_benchDir, 1);
+    snprintf(value, sizeof(value), "%g", options->latencyMs);
+    setenv("SALAMANDER_BENCH_LATENCY_MS", value, 1);
+    snprintf(value, sizeof(value), "%g", options->bandwidthMbps * 1e6 / 8.0);
+    setenv("SALAMANDER_BENCH_BPS", value, 1);
+    // Keep the inventory cache out of the user's
+    snprintf(value, sizeof(value), "%s/cache", g_benchDir);
+    setenv("XDG_CACHE_HOME", value, 1);
+    return true;
+}
+
+// ============================================================================
+// Measurement helpers
+// ============================================================================
+
+typedef struct {
+    double samples[BENCH_MAX_REPS];
+    int count;
+} Samples;
+
+static void AddSample(Samples *s, double value) {
+    if (s->count < BENCH_MAX_REPS) s->samples[s->count++] = value;
+}
+
+static int CompareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double Median(Samples *s) {
+    if (s->count == 0) return 0.0;
+    qsort(s->samples, (size_t)s->count, sizeof(double), CompareDoubles);
+    return s->count % 2 ? s->samples[s->count / 2]
+                        : (s->samples[s->count / 2 - 1] + s->samples[s->count / 2]) / 2.0;
+}
+
+// Median and best sample (lowest time, highest rate); Median sorts first
+static void Report(const char *benchmark, const char *caseName, const char *metric, Samples *s,
+                   const char *unit) {
+    double median = Median(s);
+    bool isRate = strstr(unit, "/s") != NULL;
+    double best = s->count ? s->samples[isRate ? s->count - 1 : 0] : 0.0;
+    fprintf(g_report, "%-9s %-16s %-10s %12.3f %12.3f  %s\n", benchmark, caseName, metric, median,
+            best, unit);
+    fflush(g_report);
+}
+
+static void Fail(const char *what) {
+    fprintf(stderr, "salamander_bench: %s\n", what);
+    g_failures++;
+}
+
+static void WaitForRefresh(void) {
+    while (PluginBrowserIsRefreshing()) usleep(200);
+}
+
+// Full refresh (the R key) run to completion; ms, or -1 if the device
+// wasn't scanned
+static double TimedRefresh(void) {
+    double start = NowMs();
+    PluginBrowserRefresh();
+    WaitForRefresh();
+    double elapsed = NowMs() - start;
+    return PluginBrowserDeviceScanned(NULL, 0) ? elapsed : -1.0;
+}
+
+// Wait for the batch executor, counting failed items
+static int WaitForBatch(void) {
+    int failed = 0;
+    PluginOpResult result;
+    for (;;) {
+        bool busy = PluginBrowserIsBusy();
+        while (PluginBrowserPollResult(&result)) {
+            if (!result.success) failed++;
+        }
+        if (!busy) break;
+        usleep(200);
+    }
+    WaitForRefresh();
+    return failed;
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+// Per-frame work the UI does against the core, without drawing: poll for a
+// new list, then visit every row of every section the way DrawSidebar does
+static double FrameCostUs(void) {
+    char label[PLUGIN_NAME_MAX + 32];
+    volatile size_t sink = 0;
+    double start = NowMs();
+    for (int frame = 0; frame < BENCH_FRAME_LOOPS; frame++) {
+        PluginBrowserUpdate();
+        const PluginSectionView *view = PluginBrowserGetSections();
+        for (int s = 0; s < 3; s++) {
+            const PluginSection *section = &view->sections[s];
+            for (int i = 0; i < section->count; i++) {
+                const PluginInfo *p = PluginBrowserGetPlugin(section->slots[i]);
+                if (!p) continue;
+                sink += (size_t)snprintf(label, sizeof(label), "%s  %s", p->displayName,
+                                         p->localPath[0] ? p->detail->localSizeText : p->detail->remoteSizeText);
+            }
+        }
+    }
+    (void)sink;
+    return (NowMs() - start) * 1000.0 / BENCH_FRAME_LOOPS;
+}
+
+// Refresh latency vs plugin count (cold: nothing hashed yet), plus what the
+// resulting list costs the UI thread: the swap and sectioning when a new
+// list lands, and an idle frame over it
+static void BenchRefresh(const BenchOptions *options) {
+    static const int counts[] = { 10, 50, 200, 500 };
+    int countLimit = options->quick ? 2 : 4;
+
+    // Identical lists aren't republished, so each cold pass starts from a
+    // refresh of an empty build directory to have a new list to swap in
+    char emptyDir[PATH_MAX];
+    snprintf(emptyDir, sizeof(emptyDir), "%s/local-empty", g_benchDir);
+    MakeDirs(emptyDir);
+
+    for (int c = 0; c < countLimit; c++) {
+        char localDir[PATH_MAX], caseName[32];
+        snprintf(localDir, sizeof(localDir), "%s/local-%d", g_benchDir, counts[c]);
+        snprintf(caseName, sizeof(caseName), "plugins=%d", counts[c]);
+        ClearDevice();
+        if (!MakePluginSet(localDir, counts[c], 32 * 1024, true)) {
+            Fail("could not create plugin set");
+            return;
+        }
+
+        Samples cold = {0}, warm = {0}, swap = {0}, frame = {0};
+        for (int r = 0; r < options->reps; r++) {
+            PluginBrowserSetLocalPath(emptyDir);
+            TimedRefresh();
+            PluginBrowserUpdate();
+            PluginBrowserSetLocalPath(localDir);
+
+            FileHasherClear();
+            double ms = TimedRefresh();
+            if (ms < 0) Fail("refresh did not scan the device");
+            AddSample(&cold, ms);
+
+            double start = NowMs();
+            if (!PluginBrowserUpdate()) Fail("refresh published no list");
+            AddSample(&swap, (NowMs() - start) * 1000.0);
+            if (PluginBrowserGetList()->count != counts[c]) Fail("refresh listed the wrong plugins");
+
+            ms = TimedRefresh();
+            if (ms < 0) Fail("refresh did not scan the device");
+            AddSample(&warm, ms);
+
+            AddSample(&frame, FrameCostUs());
+        }
+        Report("refresh", caseName, "cold", &cold, "ms");
+        Report("refresh", caseName, "warm", &warm, "ms");
+        Report("frame", caseName, "list_swap", &swap, "us");
+        Report("frame", caseName, "idle", &frame, "us");
+    }
+}
+
+// One file copied to the device, raw and gzip'd, vs file size
+static void BenchInstall(const BenchOptions *options) {
+    static const size_t sizes[] = { 64 * 1024, 1024 * 1024, 8 * 1024 * 1024 };
+    static const char *const names[] = { "size=64K", "size=1M", "size=8M" };
+    static const struct {
+        SshCompressMode mode;
+        const char *label;
+    } modes[] = { { SSH_COMPRESS_OFF, "raw" }, { SSH_COMPRESS_ON, "gzip" } };
+    int sizeLimit = options->quick ? 2 : 3;
+
+    char localPath[PATH_MAX];
+    snprintf(localPath, sizeof(localPath), "%s/transfer.so", g_benchDir);
+    const char *remotePath = SSH_PLUGIN_PATH "/bench_transfer.so";
+
+    for (int s = 0; s < sizeLimit; s++) {
+        if (!WritePlugin(localPath, sizes[s], 1000 + (uint64_t)s)) {
+            Fail("could not create transfer file");
+            return;
+        }
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            SshSetCompression(modes[m].mode);
+            Samples ms = {0}, rate = {0};
+            for (int r = 0; r < options->reps; r++) {
+                ClearDevice();
+                double start = NowMs();
+                if (!SshCopyToDevice(localPath, remotePath, NULL, NULL)) Fail("copy to device failed");
+                double elapsed = NowMs() - start;
+                AddSample(&ms, elapsed);
+                AddSample(&rate, sizes[s] / (1024.0 * 1024.0) / (elapsed / 1000.0));
+            }
+            char metric[32];
+            snprintf(metric, sizeof(metric), "%s_ms", modes[m].label);
+            Report("install", names[s], metric, &ms, "ms");
+            snprintf(metric, sizeof(metric), "%s_rate", modes[m].label);
+            Report("install", names[s], metric, &rate, "MiB/s");
+        }
+    }
+    SshSetCompression(SSH_COMPRESS_AUTO);
+}
+
+// The same plugins installed one batch each vs queued as one batch
+static void BenchBatch(const BenchOptions *options) {
+    int count = options->quick ? 4 : 8;
+    char localDir[PATH_MAX], caseName[32];
+    snprintf(localDir, sizeof(localDir), "%s/local-batch", g_benchDir);
+    snprintf(caseName, sizeof(caseName), "plugins=%d", count);
+    ClearDevice();
+    if (!MakePluginSet(localDir, count, 256 * 1024, false)) {
+        Fail("could not create plugin set");
+        return;
+    }
+    PluginBrowserSetLocalPath(localDir);
+
+    Samples serial = {0}, batch = {0};
+    for (int r = 0; r < options->reps; r++) {
+        for (int pass = 0; pass < 2; pass++) {
+            ClearDevice();
+            TimedRefresh();
+            PluginBrowserUpdate();
+
+            double start = NowMs();
+            int failed = 0;
+            for (int i = 0; i < count; i++) {
+                char name[PLUGIN_NAME_MAX];
+                snprintf(name, sizeof(name), "bench_%03d", i);
+                if (!PluginBrowserInstall(name)) failed++;
+                if (pass == 0) failed += WaitForBatch();
+            }
+            failed += WaitForBatch();
+            AddSample(pass == 0 ? &serial : &batch, NowMs() - start);
+            if (failed) Fail("install failed");
+        }
+    }
+    Report("batch", caseName, "serial", &serial, "ms");
+    Report("batch", caseName, "batched", &batch, "ms");
+}
+
+// ============================================================================
+// Entry point
+// ============================================================================
+
+static void PrintUsage(const char *argv0) {
+    fprintf(stderr,
+            "Usage: %s [--quick] [--reps N] [--latency-ms MS] [--bandwidth-mbps MBPS]\n"
+            "       [--out <results.txt>] [--verbose]\n"
+            "  --bandwidth-mbps 0 leaves the mock link unthrottled\n",
+            argv0);
+}
+
+int main(int argc, char *argv[]) {
+    const char *self = basename(argv[0]);
+    if (strcmp(self, "ssh") == 0) return MockSsh(argc, argv);
+    if (strcmp(self, "sshpass") == 0) return MockSshpass(argc, argv);
+
+    BenchOptions options = {
+        .reps = BENCH_DEFAULT_REPS,
+        .latencyMs = BENCH_DEFAULT_LATENCY_MS,
+        .bandwidthMbps = BENCH_DEFAULT_BANDWIDTH_MBPS,
+    };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            options.quick = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            options.verbose = true;
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            options.reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--latency-ms") == 0 && i + 1 < argc) {
+            options.latencyMs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--bandwidth-mbps") == 0 && i + 1 < argc) {
+            options.bandwidthMbps = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            options.outPath = argv[++i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.reps < 1) options.reps = 1;
+    if (options.reps > BENCH_MAX_REPS) options.reps = BENCH_MAX_REPS;
+    if (options.latencyMs < 0) options.latencyMs = 0;
+    if (options.bandwidthMbps < 0) options.bandwidthMbps = 0;
+
+    // The report keeps stdout; the engine's logs go to stderr or nowhere.
+    // Spawned commands get /dev/null on stdin, which tells the mock device
+    // which ones are transfers.
+    fflush(stdout);
+    g_report = options.outPath ? fopen(options.outPath, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (!g_report) {
+        fprintf(stderr, "salamander_bench: cannot open %s\n", options.outPath ? options.outPath : "stdout");
+        return 1;
+    }
+    int logFd = options.verbose ? dup(STDERR_FILENO) : open("/dev/null", O_WRONLY);
+    if (logFd >= 0) {
+        dup2(logFd, STDOUT_FILENO);
+        close(logFd);
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    int nullFd = open("/dev/null", O_RDONLY);
+    if (nullFd >= 0) {
+        dup2(nullFd, STDIN_FILENO);
+        close(nullFd);
+    }
+
+    if (!SetUpBenchDir(&options)) {
+        fprintf(stderr, "salamander_bench: cannot set up the mock device: %s\n", strerror(errno));
+        if (g_benchDir[0]) RemoveTree(g_benchDir);
+        return 1;
+    }
+
+    SshInit("bench-device", "root", "bench");
+    PluginBrowserInit(NULL);
+    PluginBrowserSetElfChecks(false);   // Fixtures are not real ARM builds
+    SshCheckConnection();
+    if (SshGetStatus() != SSH_STATUS_CONNECTED) {
+        fprintf(stderr, "salamander_bench: mock device did not answer\n");
+        g_failures++;
+    } else {
+        fprintf(g_report, "# salamander_bench format %d\n", BENCH_FORMAT_VERSION);
+        fprintf(g_report, "# link latency_ms=%g bandwidth_mbps=%g reps=%d%s\n", options.latencyMs,
+                options.bandwidthMbps, options.reps, options.quick ? " quick" : "");
+        fprintf(g_report, "# %-7s %-16s %-10s %12s %12s  %s\n", "bench", "case", "metric", "median",
+                "best", "unit");
+        BenchRefresh(&options);
+        BenchInstall(&options);
+        BenchBatch(&options);
+    }
+
+    PluginBrowserShutdown();
+    SshShutdown();
+    RemoveTree(g_benchDir);
+    fclose(g_report);
+    return g_failures ? 1 : 0;
+}
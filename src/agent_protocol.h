@@ -0,0 +1,67 @@
+#ifndef AGENT_PROTOCOL_H
+#define AGENT_PROTOCOL_H
+
+#include <stdint.h>
+
+// ============================================================================
+// Agent Protocol - Framing shared by salamander and salamander-agent
+// ============================================================================
+//
+// The agent runs on the device as one long-lived process on the persistent
+// SSH session and reads requests from stdin, answering each on stdout in
+// the order received, so a client can write a whole batch before reading
+// any reply. Every frame is
+//
+//     u32 length      bytes that follow (little-endian), at least 1
+//     u8  op/status   request: AgentOp; reply: 0 or an errno from the device
+//     payload         length - 1 bytes
+//
+// Strings in payloads are NUL-terminated. Request payloads:
+//
+//     HELLO       -                        -> "salamander-agent <version>"
+//     INVENTORY   u8 withHashes, dir       -> same text as SshListInventory
+//     HASH        path                     -> 64 hex chars (sha256sum)
+//     STAT        path                     -> "<size> <mtime>"
+//     WRITE       u8 append, path, data    -> -
+//     RENAME      from, to                 -> -
+//     DELETE      u8 recursive, path       -> -  (missing paths are fine)
+//     MKDIR       path                     -> -  (parents too, like mkdir -p)
+//     REMOUNT     mount point              -> -  (read-write)
+//     SYNC        -                        -> -
+//     RELOAD      fifo, lines              -> -  (ENOENT/ENXIO: nobody listening)
+
+#define AGENT_PROTOCOL_VERSION 1
+
+// Largest frame either side accepts (WRITE data is chunked below this)
+#define AGENT_MAX_FRAME (1024 * 1024)
+#define AGENT_HEADER_SIZE 5
+
+typedef enum {
+    AGENT_OP_HELLO = 1,
+    AGENT_OP_INVENTORY,
+    AGENT_OP_HASH,
+    AGENT_OP_STAT,
+    AGENT_OP_WRITE,
+    AGENT_OP_RENAME,
+    AGENT_OP_DELETE,
+    AGENT_OP_MKDIR,
+    AGENT_OP_REMOUNT,
+    AGENT_OP_SYNC,
+    AGENT_OP_RELOAD
+} AgentOp;
+
+#define AGENT_OK 0
+
+static inline void AgentPutU32(unsigned char *out, uint32_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+}
+
+static inline uint32_t AgentGetU32(const unsigned char *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
+#endif // AGENT_PROTOCOL_H
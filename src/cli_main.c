@@ -0,0 +1,95 @@
+#include "ssh_manager.h"
+#include "plugin_browser.h"
+#include "deploy.h"
+#include "fleet.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// salamander-cli - Headless entry point (no raylib, no window, no fonts)
+// ============================================================================
+
+static void PrintUsage(const char *argv0) {
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s --sync <dir> [--device <host>] [--user <user>] [--password <pass>]\n"
+            "      [--streams N] [--compress auto|on|off] [--reload hot|restart]\n"
+            "      [--agent <salamander-agent>] [--no-elf-check] [--dry-run]\n"
+            "      [--trace <trace.json>]\n"
+            "  %s --fleet <devices.txt> [--jobs N] [--push] [--compress auto|on|off]\n"
+            "      [--reload hot|restart] [--agent <salamander-agent>] [--no-elf-check]\n"
+            "      [--trace <trace.json>] <dir>\n",
+            argv0, argv0);
+}
+
+int main(int argc, char *argv[]) {
+    DeployOptions deploy = {0};
+    FleetOptions fleet = {0};
+    SshCompressMode compress = SSH_COMPRESS_AUTO;
+    PluginReloadMode reload = PLUGIN_RELOAD_HOT;
+    const char *localPath = NULL;
+    const char *agentPath = NULL;
+    const char *tracePath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sync") == 0 && i + 1 < argc) {
+            deploy.localDir = argv[++i];
+        } else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            deploy.host = argv[++i];
+        } else if (strcmp(argv[i], "--user") == 0 && i + 1 < argc) {
+            deploy.user = argv[++i];
+        } else if (strcmp(argv[i], "--password") == 0 && i + 1 < argc) {
+            deploy.password = argv[++i];
+        } else if (strcmp(argv[i], "--streams") == 0 && i + 1 < argc) {
+            deploy.streams = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            deploy.dryRun = true;
+        } else if (strcmp(argv[i], "--compress") == 0 && i + 1 < argc) {
+            const char *mode = argv[++i];
+            compress = strcmp(mode, "on") == 0 ? SSH_COMPRESS_ON
+                     : strcmp(mode, "off") == 0 ? SSH_COMPRESS_OFF : SSH_COMPRESS_AUTO;
+        } else if (strcmp(argv[i], "--reload") == 0 && i + 1 < argc) {
+            reload = strcmp(argv[++i], "restart") == 0 ? PLUGIN_RELOAD_RESTART : PLUGIN_RELOAD_HOT;
+        } else if (strcmp(argv[i], "--agent") == 0 && i + 1 < argc) {
+            agentPath = argv[++i];
+        } else if (strcmp(argv[i], "--no-elf-check") == 0) {
+            PluginBrowserSetElfChecks(false);
+        } else if (strcmp(argv[i], "--fleet") == 0 && i + 1 < argc) {
+            fleet.deviceFile = argv[++i];
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            fleet.jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--push") == 0) {
+            fleet.push = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (argv[i][0] != '-') {
+            localPath = argv[i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    SshSetCompression(compress);
+    SshSetAgentBinary(agentPath);
+    PluginBrowserSetReloadMode(reload);
+    fleet.restart = (reload == PLUGIN_RELOAD_RESTART);
+    if (tracePath) TraceStart(tracePath);
+    TraceNameThread("main");
+    if (deploy.localDir) {
+        int code = DeployRun(&deploy);
+        TraceStop();
+        return code;
+    }
+    if (fleet.deviceFile && localPath) {
+        fleet.localDir = localPath;
+        int code = FleetRun(&fleet);
+        TraceStop();
+        return code;
+    }
+
+    PrintUsage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,303 @@
+#include "deploy.h"
+#include "plugin_browser.h"
+#include "plugin_cache.h"
+#include "ssh_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+// Deploy Implementation
+// ============================================================================
+
+typedef enum {
+    DEPLOY_NONE,            // Up to date, or nothing we can compare
+    DEPLOY_INSTALL,         // Missing on the device
+    DEPLOY_UPDATE,          // Stale copy on the device
+    DEPLOY_DEVICE_ONLY,     // Left alone
+    DEPLOY_INVALID,         // Local build failed the ELF check, not pushed
+    DEPLOY_ACTION_COUNT
+} DeployAction;
+
+typedef struct {
+    char name[PLUGIN_NAME_MAX];
+    DeployAction action;
+    long bytes;
+    bool queued;
+    bool done;
+    bool success;
+    double doneMs;          // Since the push started
+    char message[PLUGIN_MESSAGE_MAX];
+} DeployEntry;
+
+typedef struct {
+    double connectMs;
+    double scanMs;
+    double pushMs;
+    double totalMs;
+} DeployTiming;
+
+static const char *const g_actionNames[] = { "none", "install", "update", "device-only", "invalid" };
+
+static double MonotonicMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// ============================================================================
+// JSON report
+// ============================================================================
+
+static void WriteJsonString(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c == '\n') {
+            fputs("\\n", out);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void WriteReport(FILE *out, const DeployOptions *options, const char *host,
+                        const char *deviceId, const char *error, const char *warning,
+                        const DeployTiming *timing, const DeployEntry *entries, int count) {
+    int counts[DEPLOY_ACTION_COUNT] = {0};
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        counts[entries[i].action]++;
+        if (entries[i].queued && !entries[i].success) failed++;
+    }
+
+    fprintf(out, "{\n  \"device\": ");
+    WriteJsonString(out, host);
+    fprintf(out, ",\n  \"deviceId\": ");
+    WriteJsonString(out, deviceId);
+    fprintf(out, ",\n  \"localDir\": ");
+    WriteJsonString(out, options->localDir);
+    fprintf(out, ",\n  \"dryRun\": %s,\n  \"ok\": %s,\n  \"error\": ",
+            options->dryRun ? "true" : "false",
+            (!error && !warning && failed == 0 && counts[DEPLOY_INVALID] == 0) ? "true" : "false");
+    if (error) {
+        WriteJsonString(out, error);
+    } else {
+        fputs("null", out);
+    }
+    fprintf(out, ",\n  \"warning\": ");
+    if (warning) {
+        WriteJsonString(out, warning);
+    } else {
+        fputs("null", out);
+    }
+
+    fprintf(out, ",\n  \"timing\": {\"connectMs\": %.1f, \"scanMs\": %.1f, \"pushMs\": %.1f, "
+                 "\"totalMs\": %.1f},\n",
+            timing->connectMs, timing->scanMs, timing->pushMs, timing->totalMs);
+    fprintf(out, "  \"summary\": {\"install\": %d, \"update\": %d, \"upToDate\": %d, "
+                 "\"deviceOnly\": %d, \"invalid\": %d, \"failed\": %d},\n",
+            counts[DEPLOY_INSTALL], counts[DEPLOY_UPDATE], counts[DEPLOY_NONE],
+            counts[DEPLOY_DEVICE_ONLY], counts[DEPLOY_INVALID], failed);
+
+    fprintf(out, "  \"plugins\": [");
+    for (int i = 0; i < count; i++) {
+        const DeployEntry *e = &entries[i];
+        fprintf(out, "%s\n    {\"name\": ", i ? "," : "");
+        WriteJsonString(out, e->name);
+        fprintf(out, ", \"action\": \"%s\", \"bytes\": %ld", g_actionNames[e->action], e->bytes);
+        if (e->queued) {
+            fprintf(out, ", \"success\": %s, \"doneMs\": %.1f, \"message\": ",
+                    e->success ? "true" : "false", e->doneMs);
+            WriteJsonString(out, e->message);
+        } else if (e->action == DEPLOY_INVALID) {
+            fprintf(out, ", \"message\": ");
+            WriteJsonString(out, e->message);
+        }
+        fputc('}', out);
+    }
+    fprintf(out, "%s]\n}\n", count ? "\n  " : "");
+    fflush(out);
+}
+
+// ============================================================================
+// Diff and push
+// ============================================================================
+
+// One entry per plugin in the refreshed front list
+static DeployEntry *BuildEntries(int *count) {
+    const PluginList *list = PluginBrowserGetList();
+    DeployEntry *entries = calloc(list->count ? (size_t)list->count : 1, sizeof(DeployEntry));
+    if (!entries) return NULL;
+
+    for (int i = 0; i < list->count; i++) {
+        const PluginInfo *p = &list->plugins[i];
+        DeployEntry *e = &entries[i];
+        snprintf(e->name, sizeof(e->name), "%s", p->name);
+        if (p->localPath[0] != '\0' && p->detail->elf.state == ELF_INVALID) {
+            e->action = DEPLOY_INVALID;
+            e->bytes = p->localSize;
+            snprintf(e->message, sizeof(e->message), "%s", p->detail->elf.error);
+        } else if (p->status == PLUGIN_LOCAL_ONLY) {
+            e->action = DEPLOY_INSTALL;
+            e->bytes = p->localSize;
+        } else if (p->status == PLUGIN_DEVICE_ONLY) {
+            e->action = DEPLOY_DEVICE_ONLY;
+            e->bytes = p->remoteSize;
+        } else {
+            e->action = p->syncState == PLUGIN_SYNC_STALE ? DEPLOY_UPDATE : DEPLOY_NONE;
+            e->bytes = p->localSize;
+        }
+    }
+    *count = list->count;
+    return entries;
+}
+
+// Record every finished item
+static void CollectResults(DeployEntry *entries, int count, double pushStart) {
+    PluginOpResult result;
+    while (PluginBrowserPollResult(&result)) {
+        for (int i = 0; i < count; i++) {
+            DeployEntry *e = &entries[i];
+            if (!e->queued || e->done || strcmp(e->name, result.pluginName) != 0) continue;
+            e->done = true;
+            e->success = result.success;
+            e->doneMs = MonotonicMs() - pushStart;
+            snprintf(e->message, sizeof(e->message), "%s", result.message);
+            break;
+        }
+    }
+}
+
+// Queue every missing and stale plugin, then wait for the batch to drain
+static void PushEntries(DeployEntry *entries, int count) {
+    double start = MonotonicMs();
+
+    for (int i = 0; i < count; i++) {
+        DeployEntry *e = &entries[i];
+        if (e->action != DEPLOY_INSTALL && e->action != DEPLOY_UPDATE) continue;
+
+        // More than a queue's worth: let the executor catch up
+        while (PluginBrowserQueuedCount() >= PLUGIN_QUEUE_SIZE) {
+            CollectResults(entries, count, start);
+            usleep(1000);
+        }
+
+        e->queued = true;
+        if (!PluginBrowserInstall(e->name)) {
+            e->done = true;
+            snprintf(e->message, sizeof(e->message), "%s", PluginBrowserGetOpState()->message);
+            printf("Deploy: Could not queue %s: %s\n", e->name, e->message);
+        }
+    }
+
+    // The batch still syncs after its last result, so wait for the
+    // executor itself; every result is pushed before it goes idle
+    while (PluginBrowserIsBusy()) {
+        CollectResults(entries, count, start);
+        usleep(1000);
+    }
+    CollectResults(entries, count, start);
+}
+
+// ============================================================================
+// Entry point
+// ============================================================================
+
+int DeployRun(const DeployOptions *options) {
+    double start = MonotonicMs();
+    DeployTiming timing = {0};
+
+    // stdout carries the report; everything the engine logs goes to stderr
+    fflush(stdout);
+    FILE *report = NULL;
+    int reportFd = dup(STDOUT_FILENO);
+    if (reportFd >= 0) report = fdopen(reportFd, "w");
+    if (!report) {
+        if (reportFd >= 0) close(reportFd);
+        fprintf(stderr, "Deploy: Cannot open stdout for the report\n");
+        return DEPLOY_EXIT_FAILED;
+    }
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    SshInit(options->host, options->user, options->password);
+    // One scan per run, and CI must not miss a rebuild that kept its size:
+    // hash both sides afresh instead of trusting the user's cache
+    PluginBrowserSetRemoteHashing(true);
+    PluginBrowserSetInventoryCache(false);
+    PluginBrowserInit(options->localDir);
+    PluginBrowserSetStreams(options->streams > 0 ? options->streams : PLUGIN_DEFAULT_STREAMS);
+
+    const char *error = NULL;
+    const char *warning = NULL;
+    int status = DEPLOY_EXIT_OK;
+    DeployEntry *entries = NULL;
+    int count = 0;
+    char deviceId[PLUGIN_CACHE_ID_MAX] = "";
+
+    double phase = MonotonicMs();
+    SshCheckConnection();
+    timing.connectMs = MonotonicMs() - phase;
+    if (SshGetStatus() != SSH_STATUS_CONNECTED) {
+        error = "Device not reachable";
+        status = DEPLOY_EXIT_UNREACHABLE;
+    }
+
+    if (!error) {
+        // Same refresh as the R key, run to completion
+        phase = MonotonicMs();
+        PluginBrowserRefresh();
+        while (PluginBrowserIsRefreshing()) {
+            usleep(1000);
+        }
+        PluginBrowserUpdate();
+        timing.scanMs = MonotonicMs() - phase;
+
+        if (!PluginBrowserDeviceScanned(deviceId, sizeof(deviceId))) {
+            error = "Could not list plugins on the device";
+            status = DEPLOY_EXIT_FAILED;
+        }
+
+        if (!error) entries = BuildEntries(&count);
+        if (!error && !entries) {
+            error = "Out of memory";
+            status = DEPLOY_EXIT_FAILED;
+        }
+        for (int i = 0; i < count; i++) {
+            if (entries[i].action == DEPLOY_INVALID) status = DEPLOY_EXIT_FAILED;
+        }
+    }
+
+    if (!error && !options->dryRun) {
+        phase = MonotonicMs();
+        PushEntries(entries, count);
+        timing.pushMs = MonotonicMs() - phase;
+
+        for (int i = 0; i < count; i++) {
+            if (entries[i].queued && !entries[i].success) status = DEPLOY_EXIT_FAILED;
+        }
+        // On the device, but the running host never heard about it
+        if (PluginBrowserGetOpState()->restartNeeded) {
+            warning = "Not applied until llizardgui restarts";
+            status = DEPLOY_EXIT_FAILED;
+        }
+    }
+
+    timing.totalMs = MonotonicMs() - start;
+    WriteReport(report, options, SshGetHost(), deviceId, error, warning, &timing, entries, count);
+    fclose(report);
+
+    printf("Deploy: Done in %.0f ms\n", timing.totalMs);
+    free(entries);
+    PluginBrowserShutdown();
+    SshShutdown();
+    return status;
+}
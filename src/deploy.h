@@ -0,0 +1,34 @@
+#ifndef DEPLOY_H
+#define DEPLOY_H
+
+#include <stdbool.h>
+
+// ============================================================================
+// Deploy - One-shot headless diff and push for a single device
+// ============================================================================
+//
+// For CI and flashing scripts. Scans the local directory and the device
+// through the same refresh path as the UI, queues every missing or stale
+// plugin as one batch on the plugin browser's executor (one remount and
+// sync, parallel streams, rsync deltas, gzip), waits for it, and writes one
+// JSON report to stdout. Log lines go to stderr so stdout stays parseable.
+
+// Exit statuses
+#define DEPLOY_EXIT_OK          0   // Device up to date (or diff printed, for dry runs)
+#define DEPLOY_EXIT_FAILED      1   // Scan failed, a local build failed the ELF check,
+                                    // or at least one plugin did not install
+#define DEPLOY_EXIT_UNREACHABLE 2   // Could not connect to the device
+
+typedef struct {
+    const char *localDir;       // Plugin set to push
+    const char *host;           // NULL for the default device
+    const char *user;           // NULL for SSH_DEFAULT_USER
+    const char *password;       // NULL for SSH_DEFAULT_PASS
+    int streams;                // Parallel transfers (0 = PLUGIN_DEFAULT_STREAMS)
+    bool dryRun;                // Report the diff without pushing
+} DeployOptions;
+
+// Run one deploy. Returns one of the DEPLOY_EXIT_* statuses.
+int DeployRun(const DeployOptions *options);
+
+#endif // DEPLOY_H
@@ -0,0 +1,380 @@
+#include "device_agent.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// ============================================================================
+// Device Agent Implementation
+// ============================================================================
+
+// A batch that makes no progress for this long means the link is gone
+// (ssh's keepalives give up well before this)
+#define AGENT_TIMEOUT_MS 15000
+#define AGENT_READ_CHUNK (64 * 1024)
+
+// Descriptors the agent's ssh closes before exec (the app uses a few dozen)
+#define AGENT_MAX_INHERITED_FD 1024
+
+struct DeviceAgent {
+    pid_t pid;
+    int toAgent;                // Non-blocking write end (agent's stdin)
+    int fromAgent;              // Non-blocking read end (agent's stdout)
+    bool alive;                 // Atomic; cleared once the channel breaks
+    pthread_mutex_t mutex;      // One batch at a time
+
+    unsigned char *in;          // Reply bytes not yet parsed
+    size_t inLength;
+    size_t inCapacity;
+};
+
+static bool Grow(void **data, size_t *capacity, size_t needed, size_t elementSize) {
+    if (needed <= *capacity) return true;
+    size_t grown = *capacity ? *capacity : 16;
+    while (grown < needed) grown *= 2;
+    void *p = realloc(*data, grown * elementSize);
+    if (!p) return false;
+    *data = p;
+    *capacity = grown;
+    return true;
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+// Append one frame built from up to three segments (NULL segments skipped)
+static int AddFrame(AgentBatch *batch, AgentOp op,
+                    const void *a, size_t aLen, const void *b, size_t bLen,
+                    const void *c, size_t cLen) {
+    size_t length = 1 + aLen + bLen + cLen;
+    if (length > AGENT_MAX_FRAME ||
+        !Grow((void **)&batch->requests, &batch->requestCapacity,
+              batch->requestBytes + 4 + length, 1)) {
+        batch->failed = true;
+        return -1;
+    }
+
+    unsigned char *out = batch->requests + batch->requestBytes;
+    AgentPutU32(out, (uint32_t)length);
+    out[4] = (unsigned char)op;
+    out += AGENT_HEADER_SIZE;
+    if (aLen) memcpy(out, a, aLen);
+    if (bLen) memcpy(out + aLen, b, bLen);
+    if (cLen) memcpy(out + aLen + bLen, c, cLen);
+    batch->requestBytes += 4 + length;
+    return batch->count++;
+}
+
+static int AddFlagAndPath(AgentBatch *batch, AgentOp op, bool flag, const char *path) {
+    unsigned char f = flag ? 1 : 0;
+    return AddFrame(batch, op, &f, 1, path, strlen(path) + 1, NULL, 0);
+}
+
+static int AddPath(AgentBatch *batch, AgentOp op, const char *path) {
+    return AddFrame(batch, op, path, strlen(path) + 1, NULL, 0, NULL, 0);
+}
+
+int AgentAddInventory(AgentBatch *batch, const char *dir, bool withHashes) {
+    return AddFlagAndPath(batch, AGENT_OP_INVENTORY, withHashes, dir);
+}
+
+int AgentAddHash(AgentBatch *batch, const char *path) {
+    return AddPath(batch, AGENT_OP_HASH, path);
+}
+
+int AgentAddStat(AgentBatch *batch, const char *path) {
+    return AddPath(batch, AGENT_OP_STAT, path);
+}
+
+int AgentAddWrite(AgentBatch *batch, const char *path, bool append, const void *data, size_t length) {
+    unsigned char f = append ? 1 : 0;
+    return AddFrame(batch, AGENT_OP_WRITE, &f, 1, path, strlen(path) + 1, data, length);
+}
+
+int AgentAddRename(AgentBatch *batch, const char *from, const char *to) {
+    return AddFrame(batch, AGENT_OP_RENAME, from, strlen(from) + 1, to, strlen(to) + 1, NULL, 0);
+}
+
+int AgentAddDelete(AgentBatch *batch, const char *path, bool recursive) {
+    return AddFlagAndPath(batch, AGENT_OP_DELETE, recursive, path);
+}
+
+int AgentAddMkdir(AgentBatch *batch, const char *path) {
+    return AddPath(batch, AGENT_OP_MKDIR, path);
+}
+
+int AgentAddRemount(AgentBatch *batch, const char *mountPoint) {
+    return AddPath(batch, AGENT_OP_REMOUNT, mountPoint);
+}
+
+int AgentAddSync(AgentBatch *batch) {
+    return AddFrame(batch, AGENT_OP_SYNC, NULL, 0, NULL, 0, NULL, 0);
+}
+
+int AgentAddReload(AgentBatch *batch, const char *fifo, const char *lines) {
+    return AddFrame(batch, AGENT_OP_RELOAD, fifo, strlen(fifo) + 1, lines, strlen(lines), NULL, 0);
+}
+
+void AgentBatchReset(AgentBatch *batch) {
+    batch->requestBytes = 0;
+    batch->count = 0;
+    batch->replyBytes = 0;
+    batch->failed = false;
+}
+
+void AgentBatchFree(AgentBatch *batch) {
+    free(batch->requests);
+    free(batch->replies);
+    free(batch->replyData);
+    memset(batch, 0, sizeof(*batch));
+}
+
+// ============================================================================
+// Running a batch
+// ============================================================================
+
+// Move complete reply frames from the agent's read buffer into the batch.
+// Payload offsets go into data for now; pointers are fixed up at the end.
+static bool ParseReplies(DeviceAgent *agent, AgentBatch *batch, int *received) {
+    size_t offset = 0;
+    while (*received < batch->count && agent->inLength - offset >= AGENT_HEADER_SIZE) {
+        uint32_t length = AgentGetU32(agent->in + offset);
+        if (length < 1 || length > AGENT_MAX_FRAME) return false;
+        if (agent->inLength - offset < 4 + (size_t)length) break;
+
+        size_t payload = length - 1;
+        if (!Grow((void **)&batch->replyData, &batch->replyDataCapacity,
+                  batch->replyBytes + payload + 1, 1)) {
+            return false;
+        }
+        AgentReply *reply = &batch->replies[(*received)++];
+        reply->status = agent->in[offset + 4];
+        reply->length = payload;
+        reply->data = (char *)(uintptr_t)batch->replyBytes;
+        memcpy(batch->replyData + batch->replyBytes, agent->in + offset + AGENT_HEADER_SIZE, payload);
+        batch->replyBytes += payload;
+        batch->replyData[batch->replyBytes++] = '\0';
+        offset += 4 + (size_t)length;
+    }
+    if (offset > 0) {
+        memmove(agent->in, agent->in + offset, agent->inLength - offset);
+        agent->inLength -= offset;
+    }
+    return true;
+}
+
+// Write and read at the same time so large replies can't stall large
+// requests (both pipes are bounded)
+static bool Exchange(DeviceAgent *agent, AgentBatch *batch) {
+    size_t sent = 0;
+    int received = 0;
+
+    while (received < batch->count) {
+        struct pollfd fds[2] = {
+            { .fd = agent->fromAgent, .events = POLLIN },
+            { .fd = agent->toAgent, .events = POLLOUT },
+        };
+        int nfds = sent < batch->requestBytes ? 2 : 1;
+        int ready = poll(fds, (nfds_t)nfds, AGENT_TIMEOUT_MS);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) {
+            printf("Agent: No reply for %d s, giving up\n", AGENT_TIMEOUT_MS / 1000);
+            return false;
+        }
+
+        if (nfds == 2 && (fds[1].revents & (POLLOUT | POLLERR | POLLHUP))) {
+            ssize_t n = write(agent->toAgent, batch->requests + sent, batch->requestBytes - sent);
+            if (n < 0 && errno != EAGAIN && errno != EINTR) return false;
+            if (n > 0) sent += (size_t)n;
+        }
+
+        if (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) {
+            if (!Grow((void **)&agent->in, &agent->inCapacity,
+                      agent->inLength + AGENT_READ_CHUNK, 1)) {
+                return false;
+            }
+            ssize_t n = read(agent->fromAgent, agent->in + agent->inLength,
+                             agent->inCapacity - agent->inLength);
+            if (n == 0) return false;   // Agent exited
+            if (n < 0 && errno != EAGAIN && errno != EINTR) return false;
+            if (n > 0) {
+                agent->inLength += (size_t)n;
+                if (!ParseReplies(agent, batch, &received)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Caller holds agent->mutex
+static bool RunLocked(DeviceAgent *agent, AgentBatch *batch) {
+    if (batch->failed || agent->toAgent < 0) return false;
+
+    size_t replyCapacity = (size_t)batch->replyCapacity;
+    if (!Grow((void **)&batch->replies, &replyCapacity, (size_t)batch->count, sizeof(AgentReply))) {
+        return false;
+    }
+    batch->replyCapacity = (int)replyCapacity;
+    batch->replyBytes = 0;
+
+    if (!Exchange(agent, batch)) {
+        printf("Agent: Lost the channel to the agent\n");
+        __atomic_store_n(&agent->alive, false, __ATOMIC_RELEASE);
+        return false;
+    }
+    for (int i = 0; i < batch->count; i++) {
+        batch->replies[i].data = batch->replyData + (uintptr_t)batch->replies[i].data;
+    }
+    return true;
+}
+
+bool AgentBatchRun(DeviceAgent *agent, AgentBatch *batch) {
+    if (!AgentIsAlive(agent)) return false;
+    uint64_t traceStart = TraceBegin();
+    pthread_mutex_lock(&agent->mutex);
+    bool ok = AgentIsAlive(agent) && RunLocked(agent, batch);
+    pthread_mutex_unlock(&agent->mutex);
+    TraceEndArgs("Agent batch", TRACE_CAT_SSH, traceStart, "requests", batch->count, NULL);
+    return ok;
+}
+
+// ============================================================================
+// Process
+// ============================================================================
+
+DeviceAgent *AgentCreate(void) {
+    DeviceAgent *agent = calloc(1, sizeof(DeviceAgent));
+    if (!agent) return NULL;
+    agent->toAgent = -1;
+    agent->fromAgent = -1;
+    pthread_mutex_init(&agent->mutex, NULL);
+    return agent;
+}
+
+void AgentDestroy(DeviceAgent *agent) {
+    if (!agent) return;
+    AgentStop(agent);
+    pthread_mutex_destroy(&agent->mutex);
+    free(agent->in);
+    free(agent);
+}
+
+// Caller holds agent->mutex
+static void StopLocked(DeviceAgent *agent) {
+    __atomic_store_n(&agent->alive, false, __ATOMIC_RELEASE);
+    if (agent->toAgent >= 0) close(agent->toAgent);
+    if (agent->fromAgent >= 0) close(agent->fromAgent);
+    agent->toAgent = -1;
+    agent->fromAgent = -1;
+    agent->inLength = 0;
+
+    // EOF on stdin ends the agent; don't wait on a wedged channel for long
+    for (int i = 0; i < 100 && agent->pid > 0; i++) {
+        if (waitpid(agent->pid, NULL, WNOHANG) != 0) {
+            agent->pid = 0;
+            break;
+        }
+        usleep(10000);
+    }
+    if (agent->pid > 0) {
+        kill(agent->pid, SIGTERM);
+        waitpid(agent->pid, NULL, 0);
+        agent->pid = 0;
+    }
+}
+
+void AgentStop(DeviceAgent *agent) {
+    if (!agent) return;
+    pthread_mutex_lock(&agent->mutex);
+    StopLocked(agent);
+    pthread_mutex_unlock(&agent->mutex);
+}
+
+// Caller holds agent->mutex
+static bool SpawnLocked(DeviceAgent *agent, const char *command) {
+    int toChild[2], fromChild[2];
+    if (pipe(toChild) != 0) return false;
+    if (pipe(fromChild) != 0) {
+        close(toChild[0]);
+        close(toChild[1]);
+        return false;
+    }
+
+    // Our ends must not leak into the ssh children other threads popen
+    fcntl(toChild[1], F_SETFD, FD_CLOEXEC);
+    fcntl(fromChild[0], F_SETFD, FD_CLOEXEC);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(toChild[0], STDIN_FILENO);
+        dup2(fromChild[1], STDOUT_FILENO);
+        close(toChild[0]);
+        close(toChild[1]);
+        close(fromChild[0]);
+        close(fromChild[1]);
+        // Other threads' transfer pipes (popen) were inherited as well; an
+        // extra write end would keep their remote cat from seeing EOF
+        for (int fd = STDERR_FILENO + 1; fd < AGENT_MAX_INHERITED_FD; fd++) close(fd);
+        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+        _exit(127);
+    }
+    close(toChild[0]);
+    close(fromChild[1]);
+    if (pid < 0) {
+        close(toChild[1]);
+        close(fromChild[0]);
+        return false;
+    }
+
+    agent->pid = pid;
+    agent->toAgent = toChild[1];
+    agent->fromAgent = fromChild[0];
+    fcntl(agent->toAgent, F_SETFL, fcntl(agent->toAgent, F_GETFL) | O_NONBLOCK);
+    fcntl(agent->fromAgent, F_SETFL, fcntl(agent->fromAgent, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+bool AgentStart(DeviceAgent *agent, const char *command) {
+    // A dead channel must fail the write, not kill the app
+    signal(SIGPIPE, SIG_IGN);
+
+    pthread_mutex_lock(&agent->mutex);
+    StopLocked(agent);
+    if (!SpawnLocked(agent, command)) {
+        pthread_mutex_unlock(&agent->mutex);
+        return false;
+    }
+
+    // Handshake: anything but our own agent at our protocol version is
+    // treated as no agent
+    AgentBatch hello = {0};
+    AddFrame(&hello, AGENT_OP_HELLO, NULL, 0, NULL, 0, NULL, 0);
+    char expected[64];
+    snprintf(expected, sizeof(expected), "salamander-agent %d", AGENT_PROTOCOL_VERSION);
+    bool ok = RunLocked(agent, &hello);
+    if (ok && (hello.replies[0].status != AGENT_OK || strcmp(hello.replies[0].data, expected) != 0)) {
+        printf("Agent: Unexpected handshake: %.60s\n", hello.replies[0].data);
+        ok = false;
+    }
+    AgentBatchFree(&hello);
+
+    if (ok) {
+        __atomic_store_n(&agent->alive, true, __ATOMIC_RELEASE);
+    } else {
+        StopLocked(agent);
+    }
+    pthread_mutex_unlock(&agent->mutex);
+    return ok;
+}
+
+bool AgentIsAlive(const DeviceAgent *agent) {
+    return agent && __atomic_load_n(&agent->alive, __ATOMIC_ACQUIRE);
+}
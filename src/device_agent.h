@@ -0,0 +1,85 @@
+#ifndef DEVICE_AGENT_H
+#define DEVICE_AGENT_H
+
+#include "agent_protocol.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// Device Agent - Client for salamander-agent running on the device
+// ============================================================================
+//
+// Requests are collected into a batch and sent in one go; the agent answers
+// them in order, so a whole batch costs one round trip however many steps it
+// has. The transport is any command whose stdin/stdout reach the agent (ssh
+// over the persistent session in practice); see ssh_manager for deployment.
+// One agent is shared by every thread using its device: batches run one at
+// a time.
+
+typedef struct DeviceAgent DeviceAgent;
+
+// Reply to one request
+typedef struct {
+    int status;             // AGENT_OK, or an errno value from the device
+    char *data;             // Payload, NUL-terminated (owned by the batch)
+    size_t length;
+} AgentReply;
+
+// Zero-initialize; reuse across runs to keep the allocations
+typedef struct {
+    unsigned char *requests;    // Encoded frames
+    size_t requestBytes;
+    size_t requestCapacity;
+    int count;                  // Requests added since the last reset
+    AgentReply *replies;        // One per request once the batch has run
+    int replyCapacity;
+    char *replyData;            // Every reply payload, back to back
+    size_t replyBytes;
+    size_t replyDataCapacity;
+    bool failed;                // A request could not be added (out of memory, too large)
+} AgentBatch;
+
+// Agent handle for one device. It outlives restarts, so threads holding it
+// stay safe when the process behind it dies and is replaced.
+DeviceAgent *AgentCreate(void);
+
+// Release the handle (stops the agent first)
+void AgentDestroy(DeviceAgent *agent);
+
+// Run command with its stdin/stdout connected to the agent and check that
+// it answers, replacing any previous process. Returns false if it doesn't
+// (command failed, missing or wrong binary).
+bool AgentStart(DeviceAgent *agent, const char *command);
+
+// Close the channel and reap the process (waits for a running batch)
+void AgentStop(DeviceAgent *agent);
+
+// True between a successful start and the channel breaking (the agent
+// exited or the session dropped). Lock-free.
+bool AgentIsAlive(const DeviceAgent *agent);
+
+// Add requests; each returns its reply index, or -1 if it couldn't be added
+int AgentAddInventory(AgentBatch *batch, const char *dir, bool withHashes);
+int AgentAddHash(AgentBatch *batch, const char *path);
+int AgentAddStat(AgentBatch *batch, const char *path);
+int AgentAddWrite(AgentBatch *batch, const char *path, bool append, const void *data, size_t length);
+int AgentAddRename(AgentBatch *batch, const char *from, const char *to);
+int AgentAddDelete(AgentBatch *batch, const char *path, bool recursive);
+int AgentAddMkdir(AgentBatch *batch, const char *path);
+int AgentAddRemount(AgentBatch *batch, const char *mountPoint);
+int AgentAddSync(AgentBatch *batch);
+int AgentAddReload(AgentBatch *batch, const char *fifo, const char *lines);
+
+// Send every request and collect every reply (one round trip)
+// Returns false if the channel broke (the agent is dead from then on) or a
+// request couldn't be added. Replies stay valid until the batch is reset;
+// reset it before adding the next set of requests.
+bool AgentBatchRun(DeviceAgent *agent, AgentBatch *batch);
+
+// Drop requests and replies, keeping the memory
+void AgentBatchReset(AgentBatch *batch);
+
+// Release all memory held by the batch
+void AgentBatchFree(AgentBatch *batch);
+
+#endif // DEVICE_AGENT_H
@@ -0,0 +1,355 @@
+#include "dir_watcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+// ============================================================================
+// Directory Watcher Implementation
+// ============================================================================
+
+#define MAX_PENDING 64          // Files debounced at once before giving up
+#define WAKE_MS 250             // Longest sleep, so stop requests are seen
+
+typedef struct {
+    char name[NAME_MAX + 1];
+    double deadline;            // Report once this passes with no new events
+} PendingFile;
+
+// Polling snapshot entry
+typedef struct {
+    char *name;
+    long size;
+    long mtime;
+} DirEntry;
+
+static pthread_t g_thread;
+static bool g_running = false;
+static int g_stop = 0;          // Atomic
+
+// Watch settings (fixed while the thread runs)
+static char g_dir[512];
+static char g_suffix[16];
+static double g_debounce = 0.3;
+static DirWatcherCallback g_callback = NULL;
+static void *g_userData = NULL;
+
+// Debounce state (watcher thread only)
+static PendingFile g_pending[MAX_PENDING];
+static int g_pendingCount = 0;
+static bool g_overflow = false;
+static double g_overflowDeadline = 0.0;
+
+static double MonotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool Stopping(void) {
+    return __atomic_load_n(&g_stop, __ATOMIC_ACQUIRE) != 0;
+}
+
+static bool HasSuffix(const char *name) {
+    size_t len = strlen(name);
+    size_t suffixLen = strlen(g_suffix);
+    return len > suffixLen && strcmp(name + len - suffixLen, g_suffix) == 0;
+}
+
+// ============================================================================
+// Debouncing
+// ============================================================================
+
+static void MarkOverflow(double now) {
+    g_overflow = true;
+    g_overflowDeadline = now + g_debounce;
+}
+
+static void Touch(const char *name, double now) {
+    if (!HasSuffix(name) || strlen(name) > NAME_MAX) return;
+    if (g_overflow) {
+        g_overflowDeadline = now + g_debounce;
+        return;
+    }
+
+    for (int i = 0; i < g_pendingCount; i++) {
+        if (strcmp(g_pending[i].name, name) == 0) {
+            g_pending[i].deadline = now + g_debounce;
+            return;
+        }
+    }
+
+    if (g_pendingCount == MAX_PENDING) {
+        MarkOverflow(now);
+        return;
+    }
+    PendingFile *p = &g_pending[g_pendingCount++];
+    strcpy(p->name, name);
+    p->deadline = now + g_debounce;
+}
+
+// Report files that have gone quiet
+static void Flush(double now) {
+    if (g_overflow) {
+        if (now < g_overflowDeadline) return;
+        g_overflow = false;
+        g_pendingCount = 0;
+        g_callback(NULL, g_userData);
+        return;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < g_pendingCount; i++) {
+        if (now >= g_pending[i].deadline) {
+            g_callback(g_pending[i].name, g_userData);
+        } else {
+            g_pending[kept++] = g_pending[i];
+        }
+    }
+    g_pendingCount = kept;
+}
+
+// Milliseconds until the next report is due, capped at max
+static int NextTimeout(double now, int max) {
+    double next = now + max / 1000.0;
+    if (g_overflow && g_overflowDeadline < next) next = g_overflowDeadline;
+    for (int i = 0; !g_overflow && i < g_pendingCount; i++) {
+        if (g_pending[i].deadline < next) next = g_pending[i].deadline;
+    }
+    int ms = (int)((next - now) * 1000.0) + 1;
+    return ms < 0 ? 0 : ms;
+}
+
+// ============================================================================
+// Polling fallback
+// ============================================================================
+
+static int CompareEntries(const void *a, const void *b) {
+    return strcmp(((const DirEntry *)a)->name, ((const DirEntry *)b)->name);
+}
+
+static void FreeEntries(DirEntry *entries, int count) {
+    for (int i = 0; i < count; i++) free(entries[i].name);
+    free(entries);
+}
+
+// Sorted snapshot of matching files (empty if the directory is missing)
+static DirEntry *ReadSnapshot(int *outCount) {
+    *outCount = 0;
+    DIR *dir = opendir(g_dir);
+    if (!dir) return NULL;
+
+    DirEntry *entries = NULL;
+    int count = 0, capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!HasSuffix(entry->d_name)) continue;
+
+        char path[sizeof(g_dir) + NAME_MAX + 2];
+        snprintf(path, sizeof(path), "%s/%s", g_dir, entry->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0) continue;
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            DirEntry *grown = realloc(entries, (size_t)capacity * sizeof(DirEntry));
+            if (!grown) break;
+            entries = grown;
+        }
+        entries[count].name = strdup(entry->d_name);
+        if (!entries[count].name) break;
+        entries[count].size = (long)st.st_size;
+        entries[count].mtime = (long)st.st_mtime;
+        count++;
+    }
+    closedir(dir);
+
+    if (count > 1) qsort(entries, (size_t)count, sizeof(DirEntry), CompareEntries);
+    *outCount = count;
+    return entries;
+}
+
+// Poll until stopped, or (with returnWhenWatchable) until the directory
+// exists again and inotify can take over
+static void PollDirectory(bool returnWhenWatchable) {
+    int oldCount = 0;
+    DirEntry *old = ReadSnapshot(&oldCount);
+    double nextPoll = MonotonicSeconds() + DIR_WATCHER_POLL_MS / 1000.0;
+
+    while (!Stopping()) {
+        double now = MonotonicSeconds();
+        if (now >= nextPoll) {
+            nextPoll = now + DIR_WATCHER_POLL_MS / 1000.0;
+
+            if (returnWhenWatchable && access(g_dir, F_OK) == 0) break;
+
+            int newCount = 0;
+            DirEntry *current = ReadSnapshot(&newCount);
+
+            // Merge-walk both sorted snapshots
+            int i = 0, j = 0;
+            while (i < oldCount || j < newCount) {
+                int cmp = i == oldCount ? 1 : j == newCount ? -1 : strcmp(old[i].name, current[j].name);
+                if (cmp < 0) {
+                    Touch(old[i++].name, now);          // Deleted
+                } else if (cmp > 0) {
+                    Touch(current[j++].name, now);      // Created
+                } else {
+                    if (old[i].size != current[j].size || old[i].mtime != current[j].mtime) {
+                        Touch(current[j].name, now);    // Modified
+                    }
+                    i++;
+                    j++;
+                }
+            }
+
+            FreeEntries(old, oldCount);
+            old = current;
+            oldCount = newCount;
+        }
+
+        Flush(now);
+        usleep((useconds_t)NextTimeout(MonotonicSeconds(), WAKE_MS) * 1000);
+    }
+
+    FreeEntries(old, oldCount);
+}
+
+// ============================================================================
+// inotify
+// ============================================================================
+
+#ifdef __linux__
+// Watch until stopped (returns 1), the directory goes away or doesn't exist
+// yet (0), or inotify is unusable for it (-1, errno says why: no inotify,
+// EACCES, ENOSPC once max_user_watches is used up)
+static int WatchWithInotify(void) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return -1;
+
+    uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_MODIFY | IN_MOVED_TO | IN_MOVED_FROM |
+                    IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF;
+    if (inotify_add_watch(fd, g_dir, mask) < 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return error == ENOENT ? 0 : -1;
+    }
+
+    int result = 1;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (!Stopping()) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, NextTimeout(MonotonicSeconds(), WAKE_MS));
+        double now = MonotonicSeconds();
+
+        if (ready > 0) {
+            ssize_t len;
+            bool lost = false;
+            while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char *p = buffer; p < buffer + len;) {
+                    struct inotify_event *event = (struct inotify_event *)p;
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        MarkOverflow(now);
+                    } else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                        lost = true;
+                    } else if (event->len > 0) {
+                        Touch(event->name, now);
+                    }
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+            if (lost) {
+                result = 0;
+                break;
+            }
+        }
+
+        Flush(now);
+    }
+
+    close(fd);
+    return result;
+}
+#endif
+
+// ============================================================================
+// Thread
+// ============================================================================
+
+static void *WatcherThread(void *arg) {
+    (void)arg;
+
+#ifdef __linux__
+    bool resync = false;
+    while (!Stopping()) {
+        // Anything may have changed while we weren't watching
+        if (resync && access(g_dir, F_OK) == 0) {
+            g_callback(NULL, g_userData);
+        }
+
+        int watched = WatchWithInotify();
+        if (watched == 1) break;
+        if (watched < 0) {
+            // Waiting for the directory would return at once and resync
+            // forever: poll it for good instead
+            printf("Watch: inotify unavailable (%s), polling %s every %d ms\n", strerror(errno), g_dir,
+                   DIR_WATCHER_POLL_MS);
+            PollDirectory(false);
+            break;
+        }
+        if (!resync) {
+            printf("Watch: Cannot watch %s, polling until it can be\n", g_dir);
+        }
+        PollDirectory(true);
+        resync = true;
+    }
+#else
+    PollDirectory(false);
+#endif
+
+    // Don't sit on changes that were still settling
+    g_pendingCount = 0;
+    g_overflow = false;
+    return NULL;
+}
+
+bool DirWatcherStart(const char *dir, const char *suffix, int debounceMs,
+                     DirWatcherCallback callback, void *userData) {
+    DirWatcherStop();
+    if (!dir || !dir[0] || !callback) return false;
+
+    snprintf(g_dir, sizeof(g_dir), "%s", dir);
+    snprintf(g_suffix, sizeof(g_suffix), "%s", suffix ? suffix : "");
+    g_debounce = debounceMs / 1000.0;
+    g_callback = callback;
+    g_userData = userData;
+    g_pendingCount = 0;
+    g_overflow = false;
+    __atomic_store_n(&g_stop, 0, __ATOMIC_RELEASE);
+
+    if (pthread_create(&g_thread, NULL, WatcherThread, NULL) != 0) {
+        printf("Watch: Failed to start watcher thread\n");
+        return false;
+    }
+    g_running = true;
+    printf("Watch: Watching %s for *%s changes\n", g_dir, g_suffix);
+    return true;
+}
+
+void DirWatcherStop(void) {
+    if (!g_running) return;
+    __atomic_store_n(&g_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(g_thread, NULL);
+    g_running = false;
+}
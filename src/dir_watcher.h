@@ -0,0 +1,30 @@
+#ifndef DIR_WATCHER_H
+#define DIR_WATCHER_H
+
+#include <stdbool.h>
+
+// ============================================================================
+// Directory Watcher - Change notification for one directory
+// ============================================================================
+//
+// Watches a directory on a background thread with inotify, falling back to
+// polling (readdir + stat) where inotify isn't available or the directory
+// can't be watched. Events are debounced per file: a file is reported once
+// it has been quiet for the debounce window, so a linker writing a .so in
+// bursts produces one notification.
+
+// Polling fallback interval
+#define DIR_WATCHER_POLL_MS 1000
+
+// Called on the watcher thread. fileName is relative to the directory; NULL
+// means too much changed to track and the caller should rescan everything.
+typedef void (*DirWatcherCallback)(const char *fileName, void *userData);
+
+// Start watching dir for files ending in suffix (replaces any current watch)
+bool DirWatcherStart(const char *dir, const char *suffix, int debounceMs,
+                     DirWatcherCallback callback, void *userData);
+
+// Stop watching (waits for the watcher thread)
+void DirWatcherStop(void);
+
+#endif // DIR_WATCHER_H
@@ -0,0 +1,238 @@
+#include "elf_check.h"
+#include <elf.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// ELF Check Implementation
+// ============================================================================
+//
+// Every offset in the file is bounds-checked before use; structures are
+// memcpy'd out of the mapping because nothing guarantees their alignment.
+// Fields are read in host order, which is fine for the little-endian hosts
+// salamander runs on (the file itself must be little-endian anyway).
+
+static bool Fail(ElfPluginInfo *info, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(info->error, sizeof(info->error), format, args);
+    va_end(args);
+    info->state = ELF_INVALID;
+    return false;
+}
+
+static const char *MachineName(uint16_t machine, unsigned char elfClass) {
+    switch (machine) {
+        case EM_ARM:     return elfClass == ELFCLASS32 ? "ARM" : "ARM (64-bit ELF)";
+        case EM_AARCH64: return "AArch64";
+        case EM_X86_64:  return "x86-64";
+        case EM_386:     return "x86";
+        case EM_RISCV:   return "RISC-V";
+        case EM_MIPS:    return "MIPS";
+        default:         return NULL;
+    }
+}
+
+// Start of count items of itemSize at offset, or NULL if any part is
+// outside the file
+static const unsigned char *At(const unsigned char *data, size_t size, uint64_t offset,
+                               uint64_t count, size_t itemSize) {
+    if (offset > size || count > (size - offset) / itemSize) return NULL;
+    return data + offset;
+}
+
+// NUL-terminated string at offset within a string table section
+static const char *StringAt(const unsigned char *data, size_t size, const Elf32_Shdr *strtab,
+                            uint32_t offset) {
+    const unsigned char *table = At(data, size, strtab->sh_offset, strtab->sh_size, 1);
+    if (!table || offset >= strtab->sh_size) return NULL;
+    const unsigned char *s = table + offset;
+    return memchr(s, '\0', strtab->sh_size - offset) ? (const char *)s : NULL;
+}
+
+static bool ReadSection(const unsigned char *data, size_t size, const Elf32_Ehdr *eh,
+                        uint32_t index, Elf32_Shdr *out) {
+    if (index >= eh->e_shnum) return false;
+    const unsigned char *p = At(data, size, eh->e_shoff + (uint64_t)index * sizeof(Elf32_Shdr),
+                                1, sizeof(Elf32_Shdr));
+    if (!p) return false;
+    memcpy(out, p, sizeof(*out));
+    return true;
+}
+
+// Pick NT_GNU_BUILD_ID out of a note section
+static void FindBuildId(const unsigned char *data, size_t size, const Elf32_Shdr *note,
+                        ElfPluginInfo *info) {
+    const unsigned char *p = At(data, size, note->sh_offset, note->sh_size, 1);
+    if (!p) return;
+    const unsigned char *end = p + note->sh_size;
+
+    while ((size_t)(end - p) >= sizeof(Elf32_Nhdr)) {
+        Elf32_Nhdr nh;
+        memcpy(&nh, p, sizeof(nh));
+        p += sizeof(nh);
+        size_t nameLen = ((size_t)nh.n_namesz + 3) & ~(size_t)3;
+        size_t descLen = ((size_t)nh.n_descsz + 3) & ~(size_t)3;
+        if (nameLen > (size_t)(end - p) || descLen > (size_t)(end - p - nameLen)) return;
+
+        if (nh.n_type == NT_GNU_BUILD_ID && nh.n_namesz == 4 && memcmp(p, "GNU", 4) == 0) {
+            static const char digits[] = "0123456789abcdef";
+            const unsigned char *desc = p + nameLen;
+            size_t n = nh.n_descsz < 20 ? nh.n_descsz : 20;
+            for (size_t i = 0; i < n; i++) {
+                info->buildId[i * 2] = digits[desc[i] >> 4];
+                info->buildId[i * 2 + 1] = digits[desc[i] & 0xf];
+            }
+            info->buildId[n * 2] = '\0';
+            return;
+        }
+        p += nameLen + descLen;
+    }
+}
+
+// Value of a defined 4-byte object symbol (0 for .bss), -1 if unreadable
+static int ReadIntSymbol(const unsigned char *data, size_t size, const Elf32_Ehdr *eh,
+                         const Elf32_Sym *sym) {
+    Elf32_Shdr section;
+    if (sym->st_size != 4 || !ReadSection(data, size, eh, sym->st_shndx, &section)) return -1;
+    if (section.sh_type == SHT_NOBITS) return 0;
+    if (section.sh_size < 4 || sym->st_value < section.sh_addr ||
+        sym->st_value - section.sh_addr > section.sh_size - 4) {
+        return -1;
+    }
+    const unsigned char *p = At(data, size, section.sh_offset + (sym->st_value - section.sh_addr), 1, 4);
+    if (!p) return -1;
+    int32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+bool ElfCheckBuffer(const void *buffer, size_t size, ElfPluginInfo *info) {
+    const unsigned char *data = buffer;
+    memset(info, 0, sizeof(*info));
+    info->abiVersion = -1;
+
+    if (size < EI_NIDENT || memcmp(data, ELFMAG, SELFMAG) != 0) {
+        return Fail(info, "Not an ELF file");
+    }
+    if (size < sizeof(Elf32_Ehdr)) return Fail(info, "Truncated ELF header");
+
+    // e_machine sits at the same offset for both classes
+    uint16_t machine;
+    memcpy(&machine, data + offsetof(Elf32_Ehdr, e_machine), sizeof(machine));
+    const char *name = MachineName(machine, data[EI_CLASS]);
+    if (name) {
+        snprintf(info->machine, sizeof(info->machine), "%s", name);
+    } else {
+        snprintf(info->machine, sizeof(info->machine), "machine %u", machine);
+    }
+    if (data[EI_DATA] != ELFDATA2LSB) return Fail(info, "Big-endian build, device is little-endian");
+    if (machine != EM_ARM || data[EI_CLASS] != ELFCLASS32) {
+        return Fail(info, "Built for %s, device needs 32-bit %s", info->machine, ELF_CHECK_MACHINE_NAME);
+    }
+
+    Elf32_Ehdr eh;
+    memcpy(&eh, data, sizeof(eh));
+    if (eh.e_type != ET_DYN) return Fail(info, "Not a shared library");
+    if ((eh.e_flags & EF_ARM_EABIMASK) != EF_ARM_EABI_VER5) {
+        return Fail(info, "ARM EABI version %u, device needs 5", (eh.e_flags & EF_ARM_EABIMASK) >> 24);
+    }
+    if (eh.e_flags & EF_ARM_ABI_FLOAT_SOFT) {
+        return Fail(info, "Soft-float build, device needs hard-float (gnueabihf)");
+    }
+    if (eh.e_shoff == 0 || eh.e_shentsize != sizeof(Elf32_Shdr) ||
+        !At(data, size, eh.e_shoff, eh.e_shnum, sizeof(Elf32_Shdr))) {
+        return Fail(info, "Missing or truncated section headers");
+    }
+
+    Elf32_Shdr dynamic = {0}, dynsym = {0};
+    bool haveDynamic = false, haveDynsym = false;
+    for (uint32_t i = 0; i < eh.e_shnum; i++) {
+        Elf32_Shdr section;
+        ReadSection(data, size, &eh, i, &section);
+        if (section.sh_type == SHT_DYNAMIC) {
+            dynamic = section;
+            haveDynamic = true;
+        } else if (section.sh_type == SHT_DYNSYM) {
+            dynsym = section;
+            haveDynsym = true;
+        } else if (section.sh_type == SHT_NOTE && info->buildId[0] == '\0') {
+            FindBuildId(data, size, &section, info);
+        }
+    }
+    if (!haveDynamic || !haveDynsym) return Fail(info, "No dynamic symbol table");
+
+    // SONAME from the dynamic section
+    Elf32_Shdr dynstr;
+    const unsigned char *entries = At(data, size, dynamic.sh_offset, dynamic.sh_size / sizeof(Elf32_Dyn),
+                                      sizeof(Elf32_Dyn));
+    if (entries && ReadSection(data, size, &eh, dynamic.sh_link, &dynstr)) {
+        for (uint32_t i = 0; i < dynamic.sh_size / sizeof(Elf32_Dyn); i++) {
+            Elf32_Dyn dyn;
+            memcpy(&dyn, entries + i * sizeof(Elf32_Dyn), sizeof(dyn));
+            if (dyn.d_tag == DT_NULL) break;
+            if (dyn.d_tag == DT_SONAME) {
+                const char *soname = StringAt(data, size, &dynstr, dyn.d_un.d_val);
+                if (soname) snprintf(info->soname, sizeof(info->soname), "%s", soname);
+            }
+        }
+    }
+
+    // Exported symbols llizardgui-host relies on
+    Elf32_Shdr symstr;
+    uint32_t symbolCount = dynsym.sh_entsize == sizeof(Elf32_Sym) ? dynsym.sh_size / sizeof(Elf32_Sym) : 0;
+    const unsigned char *symbols = At(data, size, dynsym.sh_offset, symbolCount, sizeof(Elf32_Sym));
+    if (!symbols || !ReadSection(data, size, &eh, dynsym.sh_link, &symstr)) {
+        return Fail(info, "Corrupt dynamic symbol table");
+    }
+    bool haveEntry = false;
+    for (uint32_t i = 1; i < symbolCount; i++) {
+        Elf32_Sym sym;
+        memcpy(&sym, symbols + i * sizeof(Elf32_Sym), sizeof(sym));
+        int bind = ELF32_ST_BIND(sym.st_info);
+        if (sym.st_shndx == SHN_UNDEF || (bind != STB_GLOBAL && bind != STB_WEAK)) continue;
+
+        const char *symbol = StringAt(data, size, &symstr, sym.st_name);
+        if (!symbol) continue;
+        if (strcmp(symbol, PLUGIN_ENTRY_SYMBOL) == 0 && ELF32_ST_TYPE(sym.st_info) == STT_FUNC) {
+            haveEntry = true;
+        } else if (strcmp(symbol, PLUGIN_ABI_SYMBOL) == 0 && ELF32_ST_TYPE(sym.st_info) == STT_OBJECT) {
+            info->abiVersion = ReadIntSymbol(data, size, &eh, &sym);
+        }
+    }
+    if (!haveEntry) return Fail(info, "Does not export %s()", PLUGIN_ENTRY_SYMBOL);
+    if (info->abiVersion >= 0 && info->abiVersion != PLUGIN_ABI_VERSION) {
+        return Fail(info, "Built for plugin API %d, llizardgui-host expects %d", info->abiVersion,
+                    PLUGIN_ABI_VERSION);
+    }
+
+    info->state = ELF_VALID;
+    return true;
+}
+
+bool ElfCheckFile(const char *path, ElfPluginInfo *info) {
+    memset(info, 0, sizeof(*info));
+    info->abiVersion = -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return Fail(info, "Cannot open file");
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < EI_NIDENT) {
+        close(fd);
+        return Fail(info, "Not an ELF file");
+    }
+
+    // Only the pages holding headers and tables are ever touched
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return Fail(info, "Cannot map file");
+    bool ok = ElfCheckBuffer(map, (size_t)st.st_size, info);
+    munmap(map, (size_t)st.st_size);
+    return ok;
+}
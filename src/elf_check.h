@@ -0,0 +1,48 @@
+#ifndef ELF_CHECK_H
+#define ELF_CHECK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// ELF Check - Validate plugin binaries for the device before transfer
+// ============================================================================
+//
+// Reads the ELF header, the dynamic section, the dynamic symbol table and the
+// build-id note straight out of a read-only mapping (nothing is copied but
+// the fields kept below), so a wrong-architecture or wrong-ABI build is
+// caught on the host instead of after a copy and a service restart.
+
+// What llizardgui-host runs on: 32-bit little-endian ARM, hard-float EABI
+#define ELF_CHECK_MACHINE_NAME "ARM"
+
+// Symbol llizardgui-host looks up in every plugin
+#define PLUGIN_ENTRY_SYMBOL "LlzGetPlugin"
+
+// Optional `const int` a plugin can export to declare which plugin API it
+// was built against; when present it must match PLUGIN_ABI_VERSION
+#define PLUGIN_ABI_SYMBOL  "LlzPluginAbiVersion"
+#define PLUGIN_ABI_VERSION 1
+
+typedef enum {
+    ELF_UNCHECKED,              // Not looked at yet (or checks turned off)
+    ELF_VALID,
+    ELF_INVALID                 // error says why
+} ElfCheckState;
+
+typedef struct {
+    ElfCheckState state;
+    char machine[16];           // Architecture the file was built for
+    char buildId[41];           // GNU build-id in hex (first 20 bytes), "" if none
+    char soname[64];            // DT_SONAME, "" if none
+    int abiVersion;             // PLUGIN_ABI_SYMBOL's value, -1 if not exported
+    char error[96];             // Why the file was rejected, "" when valid
+} ElfPluginInfo;
+
+// Check an ELF image in memory (info is always filled in)
+bool ElfCheckBuffer(const void *data, size_t size, ElfPluginInfo *info);
+
+// Map path read-only and check it
+bool ElfCheckFile(const char *path, ElfPluginInfo *info);
+
+#endif // ELF_CHECK_H
@@ -0,0 +1,327 @@
+#include "file_hasher.h"
+#include "xxh64.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// File Hasher Implementation
+// ============================================================================
+
+// What identifies one version of a file without reading it
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    long long mtimeNs;
+} FileKey;
+
+typedef struct {
+    char *path;                     // NULL for an empty slot
+    FileKey key;
+    uint64_t quick;                 // XXH64 of the contents
+    bool quickValid;                // False for hashes taken from knownHash
+    char hex[SHA256_HEX_SIZE];
+} CacheEntry;
+
+// Open addressing on the path, grown at 3/4 full; entries are only
+// dropped all at once (FileHasherClear)
+static CacheEntry *g_entries = NULL;
+static size_t g_capacity = 0;
+static size_t g_used = 0;
+static pthread_mutex_t g_cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+typedef enum {
+    CACHE_MISSING,                  // Never hashed this path
+    CACHE_STALE,                    // Hashed, but the file changed since
+    CACHE_HIT
+} CacheLookup;
+
+static FileKey KeyOf(const struct stat *st) {
+    FileKey key;
+    memset(&key, 0, sizeof(key));
+    key.dev = st->st_dev;
+    key.ino = st->st_ino;
+    key.size = st->st_size;
+    key.mtimeNs = (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+    return key;
+}
+
+static bool SameKey(const FileKey *a, const FileKey *b) {
+    return a->dev == b->dev && a->ino == b->ino && a->size == b->size && a->mtimeNs == b->mtimeNs;
+}
+
+static size_t PathSlot(const char *path, size_t capacity) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char *c = path; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 1099511628211ull;
+    }
+    return (size_t)hash & (capacity - 1);
+}
+
+// Caller holds g_cacheMutex
+static CacheEntry *FindSlot(CacheEntry *entries, size_t capacity, const char *path) {
+    size_t i = PathSlot(path, capacity);
+    while (entries[i].path && strcmp(entries[i].path, path) != 0) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &entries[i];
+}
+
+// Caller holds g_cacheMutex
+static bool GrowCache(void) {
+    size_t capacity = g_capacity ? g_capacity * 2 : 256;
+    CacheEntry *entries = calloc(capacity, sizeof(CacheEntry));
+    if (!entries) return false;
+    for (size_t i = 0; i < g_capacity; i++) {
+        if (g_entries[i].path) *FindSlot(entries, capacity, g_entries[i].path) = g_entries[i];
+    }
+    free(g_entries);
+    g_entries = entries;
+    g_capacity = capacity;
+    return true;
+}
+
+static CacheLookup Lookup(const char *path, const FileKey *key, CacheEntry *out) {
+    CacheLookup result = CACHE_MISSING;
+    pthread_mutex_lock(&g_cacheMutex);
+    if (g_capacity > 0) {
+        CacheEntry *entry = FindSlot(g_entries, g_capacity, path);
+        if (entry->path) {
+            *out = *entry;
+            out->path = NULL;
+            result = SameKey(&entry->key, key) ? CACHE_HIT : CACHE_STALE;
+        }
+    }
+    pthread_mutex_unlock(&g_cacheMutex);
+    return result;
+}
+
+static void Store(const char *path, const FileKey *key, uint64_t quick, bool quickValid,
+                  const char *hex) {
+    pthread_mutex_lock(&g_cacheMutex);
+    if ((g_used + 1) * 4 > g_capacity * 3 && !GrowCache()) {
+        pthread_mutex_unlock(&g_cacheMutex);
+        return;
+    }
+    CacheEntry *entry = FindSlot(g_entries, g_capacity, path);
+    if (!entry->path) {
+        entry->path = strdup(path);
+        if (!entry->path) {
+            pthread_mutex_unlock(&g_cacheMutex);
+            return;
+        }
+        g_used++;
+    }
+    entry->key = *key;
+    entry->quick = quick;
+    entry->quickValid = quickValid;
+    memcpy(entry->hex, hex, SHA256_HEX_SIZE);
+    pthread_mutex_unlock(&g_cacheMutex);
+}
+
+void FileHasherClear(void) {
+    pthread_mutex_lock(&g_cacheMutex);
+    for (size_t i = 0; i < g_capacity; i++) {
+        free(g_entries[i].path);
+    }
+    free(g_entries);
+    g_entries = NULL;
+    g_capacity = 0;
+    g_used = 0;
+    pthread_mutex_unlock(&g_cacheMutex);
+}
+
+// ============================================================================
+// Hashing a mapped file
+// ============================================================================
+
+// A plugin being relinked can shrink under the mapping, which faults with
+// SIGBUS on the next page. The faulting thread jumps back out of the hash.
+static __thread sigjmp_buf *t_mappedRead = NULL;
+static pthread_once_t g_sigbusOnce = PTHREAD_ONCE_INIT;
+
+static void OnSigbus(int sig) {
+    if (t_mappedRead) siglongjmp(*t_mappedRead, 1);
+    // Not ours: fault again with the default action
+    signal(sig, SIG_DFL);
+}
+
+static void InstallSigbusHandler(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnSigbus;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGBUS, &sa, NULL);
+}
+
+// XXH64 first: if the bytes match what was hashed for the previous
+// version, its SHA-256 still holds
+static bool HashMapped(const char *path, const unsigned char *data, size_t size,
+                       const CacheEntry *previous, uint64_t *quick, char hex[SHA256_HEX_SIZE]) {
+    sigjmp_buf jump;
+    volatile bool ok = false;
+    if (sigsetjmp(jump, 1) == 0) {
+        t_mappedRead = &jump;
+        *quick = Xxh64(data, size, 0);
+        if (previous && previous->quickValid && previous->quick == *quick &&
+            previous->key.size == (off_t)size) {
+            memcpy(hex, previous->hex, SHA256_HEX_SIZE);
+        } else {
+            Sha256Hex(data, size, hex);
+        }
+        ok = true;
+    } else {
+        printf("Plugins:   %s changed while being hashed\n", path);
+    }
+    t_mappedRead = NULL;
+    return ok;
+}
+
+// Read and hash one file, updating the cache
+static bool HashFile(FileHashJob *job) {
+    job->hex[0] = '\0';
+    int fd = open(job->path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+    FileKey key = KeyOf(&st);
+    CacheEntry previous;
+    bool havePrevious = Lookup(job->path, &key, &previous) != CACHE_MISSING;
+
+    size_t size = (size_t)st.st_size;
+    uint64_t quick = 0;
+    bool ok;
+    if (size == 0) {
+        quick = Xxh64("", 0, 0);
+        Sha256Hex("", 0, job->hex);
+        ok = true;
+    } else {
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            // Not mappable (odd filesystems): plain reads, no quick hash
+            close(fd);
+            ok = Sha256File(job->path, job->hex);
+            if (ok) Store(job->path, &key, 0, false, job->hex);
+            return ok;
+        }
+        madvise(map, size, MADV_SEQUENTIAL);
+        ok = HashMapped(job->path, map, size, havePrevious ? &previous : NULL, &quick, job->hex);
+        munmap(map, size);
+    }
+    close(fd);
+
+    if (ok) {
+        Store(job->path, &key, quick, true, job->hex);
+    } else {
+        job->hex[0] = '\0';
+    }
+    return ok;
+}
+
+// Answer a job without reading the file if possible
+static bool ResolveCached(FileHashJob *job) {
+    struct stat st;
+    if (stat(job->path, &st) != 0) {
+        job->hex[0] = '\0';
+        return true;    // Nothing to read
+    }
+    FileKey key = KeyOf(&st);
+    CacheEntry cached;
+    CacheLookup found = Lookup(job->path, &key, &cached);
+    if (found == CACHE_HIT) {
+        memcpy(job->hex, cached.hex, SHA256_HEX_SIZE);
+        return true;
+    }
+    if (found == CACHE_MISSING && job->knownHash && job->knownHash[0] != '\0') {
+        snprintf(job->hex, sizeof(job->hex), "%s", job->knownHash);
+        Store(job->path, &key, 0, false, job->hex);
+        return true;
+    }
+    return false;
+}
+
+bool FileHasherHash(const char *path, char hex[SHA256_HEX_SIZE]) {
+    pthread_once(&g_sigbusOnce, InstallSigbusHandler);
+    FileHashJob job;
+    memset(&job, 0, sizeof(job));
+    job.path = path;
+    bool ok = ResolveCached(&job) ? job.hex[0] != '\0' : HashFile(&job);
+    memcpy(hex, job.hex, SHA256_HEX_SIZE);
+    return ok;
+}
+
+// ============================================================================
+// Thread pool
+// ============================================================================
+
+typedef struct {
+    FileHashJob *jobs;
+    int *pending;                   // Indexes into jobs that need reading
+    int count;
+    int next;                       // Atomic: next pending slot to take
+} HashRun;
+
+static void *HashWorker(void *arg) {
+    HashRun *run = arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&run->next, 1, __ATOMIC_RELAXED);
+        if (i >= run->count) break;
+        FileHashJob *job = &run->jobs[run->pending[i]];
+        if (!HashFile(job)) {
+            printf("Plugins:   Could not hash %s\n", job->path);
+        }
+    }
+    return NULL;
+}
+
+static int ThreadLimit(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) return 1;
+    return cpus < FILE_HASH_MAX_THREADS ? (int)cpus : FILE_HASH_MAX_THREADS;
+}
+
+int FileHasherRun(FileHashJob *jobs, int count) {
+    pthread_once(&g_sigbusOnce, InstallSigbusHandler);
+    if (count <= 0) return 0;
+
+    int *pending = malloc((size_t)count * sizeof(int));
+    HashRun run = { .jobs = jobs, .pending = pending, .count = 0, .next = 0 };
+    for (int i = 0; i < count; i++) {
+        if (ResolveCached(&jobs[i])) continue;
+        if (pending) {
+            pending[run.count++] = i;
+        } else if (!HashFile(&jobs[i])) {
+            printf("Plugins:   Could not hash %s\n", jobs[i].path);
+        }
+    }
+    if (!pending) return count;
+
+    // The calling thread is one of the workers
+    pthread_t threads[FILE_HASH_MAX_THREADS];
+    bool started[FILE_HASH_MAX_THREADS] = {false};
+    int extra = (run.count < ThreadLimit() ? run.count : ThreadLimit()) - 1;
+    for (int i = 0; i < extra; i++) {
+        started[i] = (pthread_create(&threads[i], NULL, HashWorker, &run) == 0);
+    }
+    HashWorker(&run);
+    for (int i = 0; i < extra; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+
+    int read = run.count;
+    free(pending);
+    return read;
+}
@@ -0,0 +1,36 @@
+#ifndef FILE_HASHER_H
+#define FILE_HASHER_H
+
+#include "sha256.h"
+#include <stdbool.h>
+
+// ============================================================================
+// File Hasher - Parallel SHA-256 of local plugins with a stat-keyed cache
+// ============================================================================
+//
+// Results are cached per path under (device, inode, size, mtime in ns); a
+// file whose stat still matches is never read again. Changed files are
+// mmap'd and checked with XXH64 first, so a rebuild that relinks identical
+// bytes costs one fast pass instead of a SHA-256 pass. The rest are hashed
+// on up to FILE_HASH_MAX_THREADS threads. Safe from any thread.
+
+#define FILE_HASH_MAX_THREADS 4
+
+typedef struct {
+    const char *path;
+    const char *knownHash;          // Optional: SHA-256 an earlier run recorded for
+                                    // this file's current size and mtime (trusted
+                                    // when the cache has nothing for the path)
+    char hex[SHA256_HEX_SIZE];      // Result, "" if the file couldn't be read
+} FileHashJob;
+
+// Hash every job's file. Returns how many files had to be read.
+int FileHasherRun(FileHashJob *jobs, int count);
+
+// Hash one file through the cache (false if it can't be read)
+bool FileHasherHash(const char *path, char hex[SHA256_HEX_SIZE]);
+
+// Forget every cached result
+void FileHasherClear(void);
+
+#endif // FILE_HASHER_H
@@ -0,0 +1,383 @@
+#include "fleet.h"
+#include "plugin_browser.h"
+#include "ssh_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+// ============================================================================
+// Fleet Implementation
+// ============================================================================
+
+typedef struct {
+    char host[256];
+    char user[64];
+    char pass[64];
+    SshDevice *ssh;
+    PluginList list;            // Local plugins merged with this device's inventory
+    char deviceId[128];
+    bool reachable;
+    char error[256];            // First failure, for the summary
+
+    // Diff against the local directory
+    int missing;
+    int stale;
+    int upToDate;
+    int deviceOnly;
+    int rejected;               // Local build failed the ELF check (never pushed)
+
+    // Push results
+    int pushed;
+    int failed;
+    bool restartNeeded;         // Pushed, but the host couldn't be told or restarted
+    double seconds;
+} FleetDevice;
+
+// Shared by the pool threads while one transfer runs
+typedef struct {
+    FleetDevice *device;
+    const char *pluginName;
+    int index;
+    int total;
+    int lastQuarter;            // Last 25% step printed
+    char lastMessage[128];
+} FleetProgress;
+
+typedef void (*FleetTask)(FleetDevice *device);
+
+static FleetDevice g_devices[FLEET_MAX_DEVICES];
+static int g_deviceCount = 0;
+static PluginList g_local = {0};
+static bool g_restart = false;     // Restart llizardgui instead of hot reloading
+static int g_rejected = 0;         // Local builds that failed the ELF check
+
+// Worker pool: each thread takes the next device until none are left
+static FleetTask g_task = NULL;
+static int g_nextDevice = 0;    // Atomic
+
+static double MonotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Builds that would not load on the device never reach any of them. They
+// stay in the diff, so a plugin the device has isn't shown as device-only.
+static bool IsRejected(const PluginInfo *p) {
+    return p->localPath[0] != '\0' && p->detail->elf.state == ELF_INVALID;
+}
+
+static bool LoadDevices(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("Fleet: Cannot open device list %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char host[256], user[64], pass[64];
+        int fields = sscanf(line, "%255s %63s %63s", host, user, pass);
+        if (fields < 1) continue;
+        if (g_deviceCount == FLEET_MAX_DEVICES) {
+            printf("Fleet: More than %d devices listed, ignoring the rest\n", FLEET_MAX_DEVICES);
+            break;
+        }
+
+        FleetDevice *device = &g_devices[g_deviceCount++];
+        memset(device, 0, sizeof(*device));
+        snprintf(device->host, sizeof(device->host), "%s", host);
+        snprintf(device->user, sizeof(device->user), "%s", fields >= 2 ? user : SSH_DEFAULT_USER);
+        snprintf(device->pass, sizeof(device->pass), "%s", fields >= 3 ? pass : SSH_DEFAULT_PASS);
+    }
+    fclose(fp);
+
+    if (g_deviceCount == 0) {
+        printf("Fleet: No devices in %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+static void *PoolThread(void *arg) {
+    (void)arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&g_nextDevice, 1, __ATOMIC_RELAXED);
+        if (i >= g_deviceCount) break;
+        SshBindDevice(g_devices[i].ssh);
+        g_task(&g_devices[i]);
+    }
+    SshBindDevice(NULL);
+    return NULL;
+}
+
+// Run task for every device, at most jobs at a time (this thread is one)
+static void RunOnAll(FleetTask task, int jobs) {
+    pthread_t threads[FLEET_MAX_DEVICES];
+    bool started[FLEET_MAX_DEVICES] = {0};
+    int count = jobs < g_deviceCount ? jobs : g_deviceCount;
+
+    g_task = task;
+    __atomic_store_n(&g_nextDevice, 0, __ATOMIC_RELAXED);
+    for (int i = 1; i < count; i++) {
+        started[i] = (pthread_create(&threads[i], NULL, PoolThread, NULL) == 0);
+    }
+    PoolThread(NULL);
+    for (int i = 1; i < count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+}
+
+// ============================================================================
+// Probe and diff
+// ============================================================================
+
+static void ProbeDevice(FleetDevice *device) {
+    double start = MonotonicSeconds();
+    SshCheckConnection();
+    if (SshGetStatus() != SSH_STATUS_CONNECTED) {
+        snprintf(device->error, sizeof(device->error), "Unreachable");
+        printf("Fleet: [%s] Unreachable\n", device->host);
+        return;
+    }
+
+    // One probe per run: hash on the device so same-size rebuilds count
+    PluginListCopy(&device->list, &g_local);
+    if (!PluginBrowserScanDevice(&device->list, true, device->deviceId, sizeof(device->deviceId))) {
+        snprintf(device->error, sizeof(device->error), "Could not list plugins");
+        return;
+    }
+    device->reachable = true;
+
+    for (int i = 0; i < device->list.count; i++) {
+        const PluginInfo *p = &device->list.plugins[i];
+        if (IsRejected(p)) {
+            device->rejected++;
+        } else if (p->status == PLUGIN_LOCAL_ONLY) {
+            device->missing++;
+        } else if (p->status == PLUGIN_DEVICE_ONLY) {
+            device->deviceOnly++;
+        } else if (p->syncState == PLUGIN_SYNC_STALE) {
+            device->stale++;
+        } else {
+            device->upToDate++;
+        }
+    }
+    printf("Fleet: [%s] Scanned in %.2fs\n", device->host, MonotonicSeconds() - start);
+}
+
+static void PrintDiff(const FleetDevice *device) {
+    if (!device->reachable) {
+        printf("Fleet: [%s] %s\n", device->host, device->error);
+        return;
+    }
+
+    printf("Fleet: [%s] %s%s%s%d missing, %d stale, %d up to date, %d device only, %d rejected\n",
+           device->host, device->deviceId[0] ? "(" : "", device->deviceId,
+           device->deviceId[0] ? ") " : "",
+           device->missing, device->stale, device->upToDate, device->deviceOnly, device->rejected);
+    for (int i = 0; i < device->list.count; i++) {
+        const PluginInfo *p = &device->list.plugins[i];
+        if (IsRejected(p)) {
+            printf("Fleet: [%s]   ! %s (%s)\n", device->host, p->name,
+                   p->remotePath[0] ? "rejected build, device copy kept" : "rejected build");
+            continue;
+        }
+        char mark = p->status == PLUGIN_LOCAL_ONLY ? '+'
+                  : p->status == PLUGIN_DEVICE_ONLY ? '-'
+                  : p->syncState == PLUGIN_SYNC_STALE ? '~' : 0;
+        if (mark) printf("Fleet: [%s]   %c %s\n", device->host, mark, p->name);
+    }
+}
+
+// ============================================================================
+// Push
+// ============================================================================
+
+static bool NeedsPush(const PluginInfo *p) {
+    if (IsRejected(p)) return false;
+    return p->status == PLUGIN_LOCAL_ONLY ||
+           (p->status == PLUGIN_INSTALLED && p->syncState == PLUGIN_SYNC_STALE);
+}
+
+// One line per quarter of each file, so N devices don't flood the console
+static void OnPushProgress(float progress, const char *message,
+                           const SshTransferStats *stats, void *userData) {
+    FleetProgress *fp = (FleetProgress *)userData;
+    snprintf(fp->lastMessage, sizeof(fp->lastMessage), "%s", message);
+    if (!stats) return;
+
+    int quarter = (int)(progress * 4.0f);
+    if (quarter <= fp->lastQuarter || quarter >= 4) return;
+    fp->lastQuarter = quarter;
+    printf("Fleet: [%s] %d/%d %s %d%% (%.1f KB/s)\n", fp->device->host, fp->index, fp->total,
+           fp->pluginName, quarter * 25, stats->instantBps / 1024.0);
+}
+
+typedef char ReloadLine[PLUGIN_NAME_MAX + 8];
+
+// Tell the host about every plugin that made it onto the device, restarting
+// the service when hot reload can't reach it (as the batch executor does)
+static void ApplyChanges(FleetDevice *device, ReloadLine *reloads) {
+    if (device->pushed == 0) return;
+    if (g_restart) {
+        printf("Fleet: [%s] Restarting llizardgui service\n", device->host);
+        SshExecute("sv restart llizardgui 2>/dev/null || true");
+        return;
+    }
+
+    const char **lines = reloads ? malloc((size_t)device->pushed * sizeof(*lines)) : NULL;
+    int sent = -1;
+    if (lines) {
+        for (int i = 0; i < device->pushed; i++) {
+            lines[i] = reloads[i];
+        }
+        sent = SshNotifyReload(lines, device->pushed);
+        free(lines);
+    }
+    if (sent > 0) return;
+
+    printf("Fleet: [%s] Could not reach llizardgui-host on %s, restarting the service\n",
+           device->host, SSH_RELOAD_FIFO);
+    if (!SshExecute("sv restart llizardgui 2>/dev/null").success) {
+        printf("Fleet: [%s] Could not restart llizardgui; changes apply on its next restart\n",
+               device->host);
+        device->restartNeeded = true;
+    }
+}
+
+// Same sequence as the batch executor: remount once, transfer (only the
+// changed blocks for stale plugins), one sync, then reload what changed
+static void PushDevice(FleetDevice *device) {
+    int total = device->missing + device->stale;
+    if (!device->reachable || total == 0) return;
+
+    double start = MonotonicSeconds();
+    if (!SshPrepareWrite(SSH_PLUGIN_PATH)) {
+        printf("Fleet: [%s] Warning - could not remount rw\n", device->host);
+    }
+
+    ReloadLine *reloads = g_restart ? NULL : malloc((size_t)total * sizeof(ReloadLine));
+    int index = 0;
+    for (int i = 0; i < device->list.count; i++) {
+        const PluginInfo *p = &device->list.plugins[i];
+        if (!NeedsPush(p)) continue;
+
+        FleetProgress progress = {0};
+        progress.device = device;
+        progress.pluginName = p->name;
+        progress.index = ++index;
+        progress.total = total;
+
+        char remotePath[sizeof(SSH_PLUGIN_PATH) + PLUGIN_NAME_MAX + 4];
+        snprintf(remotePath, sizeof(remotePath), "%s/%s.so", SSH_PLUGIN_PATH, p->name);
+        bool ok = p->status == PLUGIN_INSTALLED
+                ? SshSyncToDevice(p->localPath, remotePath, OnPushProgress, &progress)
+                : SshCopyToDevice(p->localPath, remotePath, OnPushProgress, &progress);
+
+        if (ok) {
+            if (reloads) snprintf(reloads[device->pushed], sizeof(reloads[0]), "load %s", p->name);
+            device->pushed++;
+            printf("Fleet: [%s] %d/%d Installed %s\n", device->host, index, total, p->name);
+        } else {
+            device->failed++;
+            if (device->error[0] == '\0') {
+                snprintf(device->error, sizeof(device->error), "%s: %s", p->name, progress.lastMessage);
+            }
+            printf("Fleet: [%s] %d/%d Failed to install %s: %s\n", device->host, index, total,
+                   p->name, progress.lastMessage);
+        }
+    }
+
+    SshSyncFilesystem();
+    ApplyChanges(device, reloads);
+    free(reloads);
+    device->seconds = MonotonicSeconds() - start;
+}
+
+// ============================================================================
+// Entry point
+// ============================================================================
+
+int FleetRun(const FleetOptions *options) {
+    g_deviceCount = 0;
+    g_restart = options->restart;
+    if (!LoadDevices(options->deviceFile)) return 1;
+
+    int jobs = options->jobs > 0 ? options->jobs : FLEET_DEFAULT_JOBS;
+    if (jobs > FLEET_MAX_DEVICES) jobs = FLEET_MAX_DEVICES;
+
+    for (int i = 0; i < g_deviceCount; i++) {
+        FleetDevice *device = &g_devices[i];
+        device->ssh = SshDeviceCreate(device->host, device->user, device->pass);
+        if (!device->ssh) {
+            printf("Fleet: Out of memory\n");
+            g_deviceCount = i;
+            break;
+        }
+    }
+
+    PluginListReset(&g_local);
+    PluginBrowserScanLocalDir(options->localDir, &g_local, NULL);
+    g_rejected = 0;
+    for (int i = 0; i < g_local.count; i++) {
+        const PluginInfo *p = &g_local.plugins[i];
+        if (IsRejected(p)) {
+            printf("Fleet: Not pushing %s: %s\n", p->name, p->detail->elf.error);
+            g_rejected++;
+        }
+    }
+    printf("Fleet: %d devices, %d local plugins, pushing %d at a time\n", g_deviceCount, g_local.count,
+           jobs);
+
+    // Probes are mostly waiting on the network: every device at once;
+    // jobs only limits the pushes, which compete for the host's uplink
+    double start = MonotonicSeconds();
+    RunOnAll(ProbeDevice, g_deviceCount);
+    printf("Fleet: Probed %d devices in %.2fs\n", g_deviceCount, MonotonicSeconds() - start);
+    for (int i = 0; i < g_deviceCount; i++) {
+        PrintDiff(&g_devices[i]);
+    }
+
+    if (options->push) {
+        start = MonotonicSeconds();
+        RunOnAll(PushDevice, jobs);
+        printf("Fleet: Pushed in %.2fs\n", MonotonicSeconds() - start);
+    }
+
+    // Summary, and a failing status if any device didn't make it
+    int ok = 0;
+    for (int i = 0; i < g_deviceCount; i++) {
+        FleetDevice *device = &g_devices[i];
+        bool good = device->reachable && device->failed == 0 && !device->restartNeeded;
+        if (good) ok++;
+
+        if (device->reachable && device->failed == 0 && device->restartNeeded) {
+            printf("Fleet: [%s] FAILED: %d installed, not applied until llizardgui restarts\n",
+                   device->host, device->pushed);
+        } else if (!good) {
+            printf("Fleet: [%s] FAILED: %s\n", device->host, device->error);
+        } else if (options->push && device->pushed > 0) {
+            printf("Fleet: [%s] OK, %d installed in %.2fs\n", device->host, device->pushed, device->seconds);
+        } else if (options->push) {
+            printf("Fleet: [%s] OK, already up to date\n", device->host);
+        } else {
+            printf("Fleet: [%s] OK\n", device->host);
+        }
+
+        SshDeviceDestroy(device->ssh);
+        PluginListFree(&device->list);
+    }
+    PluginListFree(&g_local);
+
+    printf("Fleet: %d of %d devices OK\n", ok, g_deviceCount);
+    if (g_rejected > 0) {
+        printf("Fleet: %d local plugins were rejected\n", g_rejected);
+    }
+    return ok == g_deviceCount && g_rejected == 0 ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdbool.h>
+
+// ============================================================================
+// Fleet - Inventory and deployment across many devices at once
+// ============================================================================
+//
+// Headless. Every device gets its own SSH session context; all of them are
+// probed and scanned concurrently, diffed against one local plugin
+// directory, and (when pushing) brought up to date on a worker pool of at
+// most `jobs` devices at a time. Progress and results go to stdout, one
+// line per event, prefixed with the device's host.
+
+#define FLEET_MAX_DEVICES 256
+#define FLEET_DEFAULT_JOBS 4
+
+typedef struct {
+    const char *deviceFile;     // "host [user [password]]" per line; # comments
+    const char *localDir;       // Plugin set to compare against and push
+    int jobs;                   // Devices worked on at once
+    bool push;                  // Install missing and stale plugins (diff only otherwise)
+    bool restart;               // Restart llizardgui after pushing instead of hot reloading
+} FleetOptions;
+
+// Run fleet mode. Returns the process exit status: 0 if every device was
+// reached (and, when pushing, fully updated) and every local build passed
+// the ELF check, 1 otherwise.
+int FleetRun(const FleetOptions *options);
+
+#endif // FLEET_H
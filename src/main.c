@@ -2,11 +2,19 @@
 #include "salamander_theme.h"
 #include "ssh_manager.h"
 #include "plugin_browser.h"
+#include "text_cache.h"
+#include "fleet.h"
+#include "deploy.h"
+#include "prestage.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
 // ============================================================================
 // Salamander - Plugin Manager for CarThing
@@ -29,7 +37,7 @@ typedef struct {
 // Drag state
 typedef struct {
     bool isDragging;
-    char pluginName[64];
+    char pluginName[PLUGIN_NAME_MAX];
     SectionType sourceSection;
     Vector2 startPos;
     Vector2 currentPos;
@@ -40,7 +48,7 @@ typedef struct {
 static Selection g_selection = {SECTION_LOCAL_ONLY, 0};
 static DragState g_drag = {0};
 static float g_animTime = 0.0f;
-static float g_connectionCheckTimer = 0.0f;
+static SshConnectionStatus g_lastStatus = SSH_STATUS_UNKNOWN;
 static bool g_needsRefresh = true;
 
 // Smooth scrolling state
@@ -48,6 +56,31 @@ static float g_scrollOffset = 0.0f;
 static float g_targetScroll = 0.0f;
 static float g_totalContentHeight = 0.0f;
 
+// Low-power mode: drop to IDLE_FPS after IDLE_DELAY seconds with no input
+// and nothing animating, and return to TARGET_FPS on the next event
+#define IDLE_DELAY 1.0f
+static bool g_lowPower = false;
+
+// Performance overlay (F3): frame time plus the phase breakdowns of the last
+// frame and the last operation, taken from the trace ring. Opening it starts
+// an in-memory trace if --trace didn't already.
+#define OVERLAY_LINES 8
+#define OVERLAY_REFRESH 0.5f    // Seconds between breakdown refreshes
+typedef struct {
+    bool visible;
+    bool ownsTrace;             // Overlay started tracing, so stops it too
+    float frameMs;              // Smoothed frame interval
+    float refreshTimer;
+    char frame[OVERLAY_LINES][64];
+    int frameLines;
+    char op[OVERLAY_LINES][64];
+    int opLines;
+} PerfOverlay;
+static PerfOverlay g_overlay = {0};
+static bool g_idle = false;
+static float g_idleTimer = 0.0f;
+static Vector2 g_lastMouse = {0};
+
 // Sidebar content area
 #define SIDEBAR_CONTENT_TOP (HEADER_HEIGHT)
 #define SIDEBAR_CONTENT_HEIGHT (WINDOW_HEIGHT - HEADER_HEIGHT - FOOTER_HEIGHT)
@@ -55,6 +88,27 @@ static float g_totalContentHeight = 0.0f;
 // Section rectangles for drop detection (in content space, before scroll)
 static Rectangle g_sectionRects[3] = {0};
 
+// Sidebar geometry, recomputed only when the section index changes
+#define SIDEBAR_HEADER_HEIGHT 24
+#define SIDEBAR_EMPTY_HEIGHT 20
+#define SIDEBAR_ITEM_PITCH (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING)
+#define SIDEBAR_OVERSCAN 2      // Extra rows drawn past each edge of the viewport
+typedef struct {
+    int count[3];           // Items per section
+    float headerY[3];       // Content-space Y of each section header
+    float itemsY[3];        // Content-space Y of each section's first item
+    float totalHeight;
+    unsigned int generation;  // PluginSectionView generation this was built from
+} SidebarLayout;
+static SidebarLayout g_layout = {0};
+
+// Section -> plugin status, for the browser's section index
+static const PluginStatus g_sectionStatus[3] = {
+    PLUGIN_DEVICE_ONLY,     // SECTION_DEVICE_ONLY
+    PLUGIN_INSTALLED,       // SECTION_SYNCED
+    PLUGIN_LOCAL_ONLY       // SECTION_LOCAL_ONLY
+};
+
 // Hover state for sidebar
 static SectionType g_hoverSection = SECTION_LOCAL_ONLY;
 static int g_hoverIndex = -1;  // -1 means no hover
@@ -99,18 +153,32 @@ static const char *g_failMessages[] = {
 };
 static const int g_failMessageCount = 4;
 
-// Last operation tracking for toast display
-static bool g_lastOpComplete = true;
-static bool g_lastOpSuccess = false;
-static char g_lastOpPlugin[64] = {0};
-static PluginOperation g_lastOpType = OP_NONE;
+// Plugins marked for a batch operation (Space / Ctrl+Click)
+static char **g_marked = NULL;
+static int g_markedCount = 0;
+static int g_markedCapacity = 0;
 
-// Font
+// Font: the default font until the TTF finishes loading in the background
+#define APP_FONT_SIZE 32
+#define APP_FONT_PADDING 4      // Same glyph padding LoadFontEx uses
+typedef struct {
+    pthread_t thread;
+    bool started;
+    int ready;              // Set (atomically) once the worker is done
+    GlyphInfo *glyphs;      // NULL if no font could be loaded
+    Rectangle *recs;
+    Image atlas;
+    int glyphCount;
+    const char *path;
+} FontLoader;
 static Font g_font;
 static bool g_fontLoaded = false;
+static FontLoader g_fontLoader = {0};
+static double g_startTime = 0.0;
 
 // Forward declarations
 static void LoadAppFont(void);
+static bool PollAppFont(void);
 static void UnloadAppFont(void);
 static void DrawBackground(void);
 static void DrawEmberGlow(float time);
@@ -118,19 +186,25 @@ static void DrawHeader(void);
 static void DrawSidebar(const PluginList *plugins, float deltaTime);
 static void DrawMainPanel(const PluginInfo *selectedPlugin);
 static void DrawFooter(void);
-static void DrawProgressBar(Rectangle bounds, float progress, const char *label);
+static void DrawProgressBar(Rectangle bounds, float progress, const char *label, const char *detail);
 static void DrawDragGhost(void);
 static void DrawToast(void);
+static void TogglePerfOverlay(void);
+static void UpdatePerfOverlay(float deltaTime);
+static void DrawPerfOverlay(void);
 static void ShowToast(const char *pluginName, bool isSuccess, bool isInstall);
 static void UpdateToast(float deltaTime);
 static void UpdateButtonAnimations(float deltaTime);
 static void HandleInput(const PluginList *plugins);
 static void UpdateScroll(float deltaTime);
-static void ScrollToSelection(const PluginList *plugins);
+static void ScrollToSelection(void);
 static const PluginInfo *GetSelectedPlugin(const PluginList *plugins);
-static void GetSectionCounts(const PluginList *plugins, int *deviceOnly, int *synced, int *localOnly);
+static void UpdateSidebarLayout(void);
+static int HitTestSidebar(float contentY, int *row);
+static int GetSectionCount(SectionType section);
 static const PluginInfo *GetPluginInSection(const PluginList *plugins, SectionType section, int index);
-static float GetSelectionY(const PluginList *plugins);
+static float GetSelectionY(void);
+static bool GetVisibleRows(int section, int *first, int *last);
 
 // ============================================================================
 // Font Loading
@@ -164,7 +238,16 @@ static int *BuildCodepoints(int *outCount) {
     return codepoints;
 }
 
-static void LoadAppFont(void) {
+static double MonotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Rasterize the TTF and pack the atlas off the UI thread; only the texture
+// upload needs the GL context, so PollAppFont does that part
+static void *FontLoaderThread(void *arg) {
+    (void)arg;
     int count = 0;
     int *codepoints = BuildCodepoints(&count);
 
@@ -176,22 +259,90 @@ static void LoadAppFont(void) {
         "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
     };
 
-    g_font = GetFontDefault();
-    for (int i = 0; i < 5; i++) {
-        Font loaded = LoadFontEx(paths[i], 32, codepoints, count);
-        if (loaded.texture.id != 0) {
-            g_font = loaded;
-            g_fontLoaded = true;
-            SetTextureFilter(g_font.texture, TEXTURE_FILTER_BILINEAR);
-            printf("Salamander: Loaded font from %s\n", paths[i]);
-            break;
-        }
+    for (int i = 0; i < 5 && codepoints; i++) {
+        if (access(paths[i], R_OK) != 0) continue;
+
+        int dataSize = 0;
+        unsigned char *data = LoadFileData(paths[i], &dataSize);
+        if (!data) continue;
+
+        GlyphInfo *glyphs = LoadFontData(data, dataSize, APP_FONT_SIZE, codepoints, count, FONT_DEFAULT);
+        UnloadFileData(data);
+        if (!glyphs) continue;
+
+        g_fontLoader.glyphs = glyphs;
+        g_fontLoader.glyphCount = count;
+        g_fontLoader.atlas = GenImageFontAtlas(glyphs, &g_fontLoader.recs, count,
+                                               APP_FONT_SIZE, APP_FONT_PADDING, 0);
+        g_fontLoader.path = paths[i];
+        break;
     }
 
-    if (codepoints) free(codepoints);
+    free(codepoints);
+    __atomic_store_n(&g_fontLoader.ready, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Kick off the TTF load; runs alongside window creation, and the UI draws
+// with the built-in font until PollAppFont swaps the real one in
+static void LoadAppFont(void) {
+    if (pthread_create(&g_fontLoader.thread, NULL, FontLoaderThread, NULL) != 0) {
+        printf("Salamander: Failed to start font loader, using default font\n");
+        return;
+    }
+    g_fontLoader.started = true;
+}
+
+// Swap in the loaded font once the worker is done (UI thread)
+// Returns true on the frame the font changes
+static bool PollAppFont(void) {
+    if (!g_fontLoader.started || !__atomic_load_n(&g_fontLoader.ready, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    pthread_join(g_fontLoader.thread, NULL);
+    g_fontLoader.started = false;
+
+    if (!g_fontLoader.glyphs) {
+        printf("Salamander: No font found, using default font\n");
+        return false;
+    }
+
+    Font font = {0};
+    font.baseSize = APP_FONT_SIZE;
+    font.glyphCount = g_fontLoader.glyphCount;
+    font.glyphPadding = APP_FONT_PADDING;
+    font.glyphs = g_fontLoader.glyphs;
+    font.recs = g_fontLoader.recs;
+    font.texture = LoadTextureFromImage(g_fontLoader.atlas);
+    UnloadImage(g_fontLoader.atlas);
+
+    if (font.texture.id == 0) {
+        UnloadFontData(font.glyphs, font.glyphCount);
+        free(font.recs);
+        printf("Salamander: Failed to upload font atlas, using default font\n");
+        return false;
+    }
+
+    SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+    g_font = font;
+    g_fontLoaded = true;
+    TextCacheClear();
+    printf("Salamander: Loaded font from %s (%.0f ms after start)\n",
+           g_fontLoader.path, (MonotonicSeconds() - g_startTime) * 1000.0);
+    return true;
 }
 
 static void UnloadAppFont(void) {
+    // A loader still running owns its buffers until it finishes
+    if (g_fontLoader.started) {
+        pthread_join(g_fontLoader.thread, NULL);
+        g_fontLoader.started = false;
+        if (g_fontLoader.glyphs) {
+            UnloadImage(g_fontLoader.atlas);
+            UnloadFontData(g_fontLoader.glyphs, g_fontLoader.glyphCount);
+            free(g_fontLoader.recs);
+        }
+    }
     if (g_fontLoaded && g_font.texture.id != GetFontDefault().texture.id) {
         UnloadFont(g_font);
     }
@@ -201,99 +352,203 @@ static void UnloadAppFont(void) {
 // Helper Functions
 // ============================================================================
 
-static void GetSectionCounts(const PluginList *plugins, int *deviceOnly, int *synced, int *localOnly) {
-    *deviceOnly = 0;
-    *synced = 0;
-    *localOnly = 0;
-
-    for (int i = 0; i < plugins->count; i++) {
-        const PluginInfo *p = &plugins->plugins[i];
-        bool hasLocal = (p->localPath[0] != '\0');
-        bool hasRemote = (p->remotePath[0] != '\0');
-
-        if (hasLocal && hasRemote) {
-            (*synced)++;
-        } else if (hasRemote) {
-            (*deviceOnly)++;
-        } else if (hasLocal) {
-            (*localOnly)++;
-        }
+// Recompute section offsets after the browser rebuilt its section index
+static void UpdateSidebarLayout(void) {
+    const PluginSectionView *view = PluginBrowserGetSections();
+    if (view->generation == g_layout.generation) return;
+
+    float y = SIDEBAR_PADDING;
+    for (int section = 0; section < 3; section++) {
+        int count = view->sections[g_sectionStatus[section]].count;
+        float height = SIDEBAR_HEADER_HEIGHT + (count > 0 ? count * SIDEBAR_ITEM_PITCH : SIDEBAR_EMPTY_HEIGHT);
+
+        g_layout.count[section] = count;
+        g_layout.headerY[section] = y;
+        g_layout.itemsY[section] = y + SIDEBAR_HEADER_HEIGHT;
+        g_sectionRects[section] = (Rectangle){0, y, SIDEBAR_WIDTH, height};
+
+        y += height;
+        if (section < 2) y += SIDEBAR_SECTION_SPACING / 2;
     }
+
+    g_layout.totalHeight = y + SIDEBAR_PADDING;
+    g_layout.generation = view->generation;
+
+    // Store total content height for scroll calculations
+    g_totalContentHeight = g_layout.totalHeight;
+
+    // Keep the scroll position inside the (possibly shorter) list
+    float maxScroll = g_totalContentHeight - SIDEBAR_CONTENT_HEIGHT;
+    if (maxScroll < 0) maxScroll = 0;
+    if (g_targetScroll > maxScroll) g_targetScroll = maxScroll;
+    if (g_scrollOffset > maxScroll) g_scrollOffset = maxScroll;
 }
 
-static const PluginInfo *GetPluginInSection(const PluginList *plugins, SectionType section, int index) {
-    int count = 0;
-    for (int i = 0; i < plugins->count; i++) {
-        const PluginInfo *p = &plugins->plugins[i];
-        bool hasLocal = (p->localPath[0] != '\0');
-        bool hasRemote = (p->remotePath[0] != '\0');
-
-        bool inSection = false;
-        if (section == SECTION_SYNCED && hasLocal && hasRemote) inSection = true;
-        else if (section == SECTION_DEVICE_ONLY && hasRemote && !hasLocal) inSection = true;
-        else if (section == SECTION_LOCAL_ONLY && hasLocal && !hasRemote) inSection = true;
-
-        if (inSection) {
-            if (count == index) return p;
-            count++;
+// Rows of a section that intersect the viewport, plus overscan
+// Returns false when none of the section's items are on screen
+static bool GetVisibleRows(int section, int *first, int *last) {
+    int count = g_layout.count[section];
+    if (count == 0) return false;
+
+    float top = g_scrollOffset - g_layout.itemsY[section];
+    float bottom = top + SIDEBAR_CONTENT_HEIGHT;
+    if (bottom < 0 || top >= count * SIDEBAR_ITEM_PITCH) return false;
+
+    int lo = (int)floorf(top / SIDEBAR_ITEM_PITCH) - SIDEBAR_OVERSCAN;
+    int hi = (int)floorf(bottom / SIDEBAR_ITEM_PITCH) + SIDEBAR_OVERSCAN;
+    *first = lo < 0 ? 0 : lo;
+    *last = hi >= count ? count - 1 : hi;
+    return true;
+}
+
+// Which section (and item row, or -1) a content-space Y falls in
+// Returns -1 outside every section
+static int HitTestSidebar(float contentY, int *row) {
+    *row = -1;
+    for (int section = 0; section < 3; section++) {
+        Rectangle rect = g_sectionRects[section];
+        if (contentY < rect.y || contentY >= rect.y + rect.height) continue;
+
+        float offset = contentY - g_layout.itemsY[section];
+        if (offset >= 0 && g_layout.count[section] > 0) {
+            int index = (int)(offset / SIDEBAR_ITEM_PITCH);
+            if (index < g_layout.count[section] && offset - index * SIDEBAR_ITEM_PITCH < SIDEBAR_ITEM_HEIGHT) {
+                *row = index;
+            }
         }
+        return section;
     }
-    return NULL;
+    return -1;
 }
 
-static const PluginInfo *GetSelectedPlugin(const PluginList *plugins) {
-    return GetPluginInSection(plugins, g_selection.section, g_selection.index);
+static const PluginInfo *GetPluginInSection(const PluginList *plugins, SectionType section, int index) {
+    const PluginSection *items = &PluginBrowserGetSections()->sections[g_sectionStatus[section]];
+    if (index < 0 || index >= items->count) return NULL;
+    return &plugins->plugins[items->slots[index]];
+}
+
+// Local build can go to the device: not installed yet, or the device copy
+// isn't known to match (stale, or not compared without --remote-hash)
+static bool CanInstall(const PluginInfo *p) {
+    return p->localPath[0] != '\0' && p->detail->elf.state != ELF_INVALID &&
+           (p->remotePath[0] == '\0' || p->syncState != PLUGIN_SYNC_UP_TO_DATE) &&
+           SshGetStatus() == SSH_STATUS_CONNECTED;
+}
+
+static bool CanUninstall(const PluginInfo *p) {
+    return p->remotePath[0] != '\0' && SshGetStatus() == SSH_STATUS_CONNECTED;
 }
 
-static int GetSectionCount(const PluginList *plugins, SectionType section) {
-    int deviceOnly, synced, localOnly;
-    GetSectionCounts(plugins, &deviceOnly, &synced, &localOnly);
-    switch (section) {
-        case SECTION_DEVICE_ONLY: return deviceOnly;
-        case SECTION_SYNCED: return synced;
-        case SECTION_LOCAL_ONLY: return localOnly;
+// Last plugin handed to prestage; cleared when the list changes so a
+// rebuild of the same selection is prepared again
+static char g_prestageHinted[PLUGIN_NAME_MAX] = "";
+
+// Let prestage get p ready in case it is installed next (p may be NULL).
+// The selection is hinted once; a drag start always is, without delay.
+static void HintInstall(const PluginInfo *p, bool immediate) {
+    if (PrestageGetMode() == PRESTAGE_OFF) return;
+    if (!p || !CanInstall(p)) {
+        g_prestageHinted[0] = '\0';
+        return;
     }
-    return 0;
+    if (!immediate && strcmp(g_prestageHinted, p->name) == 0) return;
+    snprintf(g_prestageHinted, sizeof(g_prestageHinted), "%s", p->name);
+    PrestageHint(p->name, p->localPath, immediate);
 }
 
-// Calculate Y position of selected item in content space (before scroll)
-static float GetSelectionY(const PluginList *plugins) {
-    int deviceOnly, synced, localOnly;
-    GetSectionCounts(plugins, &deviceOnly, &synced, &localOnly);
+// ============================================================================
+// Batch Marks
+// ============================================================================
 
-    float y = SIDEBAR_PADDING;
+static bool IsMarked(const char *name) {
+    for (int i = 0; i < g_markedCount; i++) {
+        if (strcmp(g_marked[i], name) == 0) return true;
+    }
+    return false;
+}
 
-    // DEVICE ONLY section
-    y += 24;  // Header
-    if (deviceOnly == 0) {
-        y += 20;
-    } else {
-        if (g_selection.section == SECTION_DEVICE_ONLY) {
-            return y + g_selection.index * (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING);
+static void ToggleMark(const char *name) {
+    for (int i = 0; i < g_markedCount; i++) {
+        if (strcmp(g_marked[i], name) == 0) {
+            free(g_marked[i]);
+            g_markedCount--;
+            memmove(&g_marked[i], &g_marked[i + 1], (size_t)(g_markedCount - i) * sizeof(g_marked[0]));
+            return;
         }
-        y += deviceOnly * (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING);
     }
-    y += SIDEBAR_SECTION_SPACING / 2;
+    if (g_markedCount == g_markedCapacity) {
+        int capacity = g_markedCapacity ? g_markedCapacity * 2 : 16;
+        char **marked = realloc(g_marked, (size_t)capacity * sizeof(g_marked[0]));
+        if (!marked) return;
+        g_marked = marked;
+        g_markedCapacity = capacity;
+    }
+    char *copy = strdup(name);
+    if (copy) g_marked[g_markedCount++] = copy;
+}
 
-    // SYNCED section
-    y += 24;  // Header
-    if (synced == 0) {
-        y += 20;
+static void ClearMarks(void) {
+    for (int i = 0; i < g_markedCount; i++) {
+        free(g_marked[i]);
+    }
+    g_markedCount = 0;
+}
+
+// Plugins a button press acts on: the marked set, or just the selection
+static int CountTargets(const PluginInfo *selected, bool (*can)(const PluginInfo *)) {
+    if (g_markedCount == 0) {
+        return (selected && can(selected)) ? 1 : 0;
+    }
+    int count = 0;
+    for (int i = 0; i < g_markedCount; i++) {
+        const PluginInfo *p = PluginBrowserFindPlugin(g_marked[i]);
+        if (p && can(p)) count++;
+    }
+    return count;
+}
+
+// Queue installs (or uninstalls) for every target; they run as one batch
+static int QueueTargets(const PluginInfo *selected, bool install) {
+    bool (*can)(const PluginInfo *) = install ? CanInstall : CanUninstall;
+    int queued = 0;
+
+    if (g_markedCount == 0) {
+        if (selected && can(selected)) {
+            printf("Salamander: %s %s\n", install ? "Installing" : "Uninstalling", selected->name);
+            if (install ? PluginBrowserInstall(selected->name) : PluginBrowserUninstall(selected->name)) {
+                queued++;
+            }
+        }
     } else {
-        if (g_selection.section == SECTION_SYNCED) {
-            return y + g_selection.index * (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING);
+        for (int i = 0; i < g_markedCount; i++) {
+            const PluginInfo *p = PluginBrowserFindPlugin(g_marked[i]);
+            if (!p || !can(p)) continue;
+            printf("Salamander: %s %s (batch)\n", install ? "Installing" : "Uninstalling", p->name);
+            if (install ? PluginBrowserInstall(p->name) : PluginBrowserUninstall(p->name)) {
+                queued++;
+            }
         }
-        y += synced * (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING);
+        ClearMarks();
     }
-    y += SIDEBAR_SECTION_SPACING / 2;
 
-    // LOCAL ONLY section
-    y += 24;  // Header
-    if (g_selection.section == SECTION_LOCAL_ONLY) {
-        return y + g_selection.index * (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING);
+    if (queued > 0) {
+        if (install) g_installBtnPress = 1.0f; else g_uninstallBtnPress = 1.0f;
+        g_needsRefresh = true;
     }
+    return queued;
+}
+
+static const PluginInfo *GetSelectedPlugin(const PluginList *plugins) {
+    return GetPluginInSection(plugins, g_selection.section, g_selection.index);
+}
 
-    return y;
+static int GetSectionCount(SectionType section) {
+    return g_layout.count[section];
+}
+
+// Calculate Y position of selected item in content space (before scroll)
+static float GetSelectionY(void) {
+    return g_layout.itemsY[g_selection.section] + g_selection.index * SIDEBAR_ITEM_PITCH;
 }
 
 // ============================================================================
@@ -305,7 +560,8 @@ static void UpdateScroll(float deltaTime) {
     float diff = g_targetScroll - g_scrollOffset;
     float speed = 12.0f;
 
-    g_scrollOffset += diff * speed * deltaTime;
+    // Capped so a long frame (waking from idle) can't overshoot
+    g_scrollOffset += diff * CLAMP(speed * deltaTime, 0.0f, 1.0f);
 
     // Snap when very close
     if (fabsf(diff) < 0.5f) {
@@ -313,8 +569,8 @@ static void UpdateScroll(float deltaTime) {
     }
 }
 
-static void ScrollToSelection(const PluginList *plugins) {
-    float selY = GetSelectionY(plugins);
+static void ScrollToSelection(void) {
+    float selY = GetSelectionY();
     float itemHeight = SIDEBAR_ITEM_HEIGHT;
 
     // Calculate visible area
@@ -341,6 +597,51 @@ static void ScrollToSelection(const PluginList *plugins) {
     if (g_targetScroll > maxScroll) g_targetScroll = maxScroll;
 }
 
+// ============================================================================
+// Frame Rate
+// ============================================================================
+
+// Input this frame, or anything on screen that is still moving
+static bool HasActivity(bool listChanged) {
+    bool active = listChanged;
+
+    // Drain the key queue so a press counts once
+    while (GetKeyPressed() != 0) active = true;
+
+    Vector2 mouse = GetMousePosition();
+    if (mouse.x != g_lastMouse.x || mouse.y != g_lastMouse.y) active = true;
+    g_lastMouse = mouse;
+
+    if (GetMouseWheelMove() != 0.0f) active = true;
+    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) || IsMouseButtonDown(MOUSE_RIGHT_BUTTON)) active = true;
+
+    if (g_drag.isDragging || g_toast.active) active = true;
+    if (g_scrollOffset != g_targetScroll) active = true;
+    if (g_installBtnPress > 0.0f || g_uninstallBtnPress > 0.0f) active = true;
+    if (g_needsRefresh || PluginBrowserIsBusy() || PluginBrowserIsRefreshing()) active = true;
+
+    return active;
+}
+
+static void UpdateFrameRate(bool active, float deltaTime) {
+    if (!g_lowPower) return;
+
+    if (active) {
+        g_idleTimer = 0.0f;
+        if (g_idle) {
+            g_idle = false;
+            SetTargetFPS(TARGET_FPS);
+        }
+        return;
+    }
+
+    g_idleTimer += deltaTime;
+    if (!g_idle && g_idleTimer >= IDLE_DELAY) {
+        g_idle = true;
+        SetTargetFPS(IDLE_FPS);
+    }
+}
+
 // ============================================================================
 // Toast Notifications & Button Animations
 // ============================================================================
@@ -446,20 +747,105 @@ static void DrawToast(void) {
     if (g_toast.isSuccess) {
         // Checkmark / flame icon
         DrawCircle((int)iconX, (int)iconY, 12, ColorWithAlpha(COLOR_CONNECTED, 0.3f));
-        DrawTextEx(g_font, "*", (Vector2){iconX - 6, iconY - 10}, 24, 1, COLOR_GOLD);
+        TextCacheDraw(g_font, "*", (Vector2){iconX - 6, iconY - 10}, 24, 1, COLOR_GOLD);
     } else {
         // X / error icon
         DrawCircle((int)iconX, (int)iconY, 12, ColorWithAlpha(COLOR_DISCONNECTED, 0.3f));
-        DrawTextEx(g_font, "X", (Vector2){iconX - 6, iconY - 10}, 20, 1, COLOR_DISCONNECTED);
+        TextCacheDraw(g_font, "X", (Vector2){iconX - 6, iconY - 10}, 20, 1, COLOR_DISCONNECTED);
     }
 
     // Message text
     Color textColor = g_toast.isSuccess ? COLOR_CONNECTED : (Color){255, 180, 180, 255};
-    DrawTextEx(g_font, g_toast.message, (Vector2){x + 40, y + 12}, 16, 1, textColor);
+    TextCacheDraw(g_font, g_toast.message, (Vector2){x + 40, y + 12}, 16, 1, textColor);
 
     // Subtitle
     const char *subtitle = g_toast.isSuccess ? "Operation complete" : "Please try again";
-    DrawTextEx(g_font, subtitle, (Vector2){x + 40, y + 34}, 12, 1, COLOR_TEXT_DIM);
+    TextCacheDraw(g_font, subtitle, (Vector2){x + 40, y + 34}, 12, 1, COLOR_TEXT_DIM);
+}
+
+// ============================================================================
+// Performance Overlay
+// ============================================================================
+
+static void TogglePerfOverlay(void) {
+    g_overlay.visible = !g_overlay.visible;
+    if (g_overlay.visible) {
+        if (!TraceEnabled()) g_overlay.ownsTrace = TraceStart(NULL);
+        g_overlay.frameLines = 0;
+        g_overlay.opLines = 0;
+        g_overlay.refreshTimer = 0.0f;
+    } else if (g_overlay.ownsTrace) {
+        TraceStop();
+        g_overlay.ownsTrace = false;
+    }
+}
+
+// Root span plus its children, one line each
+static int FormatBreakdown(const char *rootCategory, const char *childCategory,
+                           char lines[OVERLAY_LINES][64]) {
+    TraceTotal root;
+    TraceTotal totals[OVERLAY_LINES - 1];
+    int count = TraceLastBreakdown(rootCategory, childCategory, &root, totals, OVERLAY_LINES - 1);
+    if (root.count == 0) return 0;
+
+    snprintf(lines[0], sizeof(lines[0]), "%s  %.1f ms", root.name, root.totalMs);
+    for (int i = 0; i < count; i++) {
+        if (totals[i].count > 1) {
+            snprintf(lines[i + 1], sizeof(lines[i + 1]), "  %-16s %7.1f ms  x%d", totals[i].name,
+                     totals[i].totalMs, totals[i].count);
+        } else {
+            snprintf(lines[i + 1], sizeof(lines[i + 1]), "  %-16s %7.1f ms", totals[i].name,
+                     totals[i].totalMs);
+        }
+    }
+    return count + 1;
+}
+
+static void UpdatePerfOverlay(float deltaTime) {
+    if (!g_overlay.visible) return;
+
+    float ms = deltaTime * 1000.0f;
+    g_overlay.frameMs = g_overlay.frameMs > 0.0f ? g_overlay.frameMs * 0.9f + ms * 0.1f : ms;
+
+    // Text is rebuilt a couple of times a second so it stays readable (and
+    // the text cache isn't flooded with one-frame strings)
+    g_overlay.refreshTimer -= deltaTime;
+    if (g_overlay.refreshTimer > 0.0f) return;
+    g_overlay.refreshTimer = OVERLAY_REFRESH;
+    g_overlay.frameLines = FormatBreakdown(TRACE_CAT_FRAME, TRACE_CAT_UI, g_overlay.frame);
+    g_overlay.opLines = FormatBreakdown(TRACE_CAT_OP, NULL, g_overlay.op);
+}
+
+static void DrawPerfOverlay(void) {
+    if (!g_overlay.visible) return;
+
+    float lineHeight = 15;
+    float width = 300;
+    float x = WINDOW_WIDTH - width - 10;
+    float y = HEADER_HEIGHT + 10;
+    int lines = 1 + g_overlay.frameLines + 1 + (g_overlay.opLines > 0 ? g_overlay.opLines : 1);
+    DrawRectangleRounded((Rectangle){x, y, width, lines * lineHeight + 16}, 0.05f, 4,
+                         (Color){20, 16, 14, 220});
+
+    char header[64];
+    snprintf(header, sizeof(header), "Frame %.1f ms  (%.0f FPS)", g_overlay.frameMs,
+             g_overlay.frameMs > 0.0f ? 1000.0f / g_overlay.frameMs : 0.0f);
+    float textY = y + 8;
+    TextCacheDraw(g_font, header, (Vector2){x + 10, textY}, 13, 1, COLOR_GOLD);
+    textY += lineHeight;
+    for (int i = 0; i < g_overlay.frameLines; i++, textY += lineHeight) {
+        TextCacheDraw(g_font, g_overlay.frame[i], (Vector2){x + 10, textY}, 12, 1, COLOR_TEXT_DIM);
+    }
+
+    textY += lineHeight;
+    if (g_overlay.opLines == 0) {
+        TextCacheDraw(g_font, "No operation since tracing started", (Vector2){x + 10, textY}, 12, 1,
+                      COLOR_TEXT_DIM);
+    }
+    for (int i = 0; i < g_overlay.opLines; i++, textY += lineHeight) {
+        TextCacheDraw(g_font, g_overlay.op[i], (Vector2){x + 10, textY}, 12, 1,
+                      i == 0 ? COLOR_TEXT_BRIGHT : COLOR_TEXT_DIM);
+    }
 }
 
 // ============================================================================
@@ -472,26 +858,93 @@ static void DrawBackground(void) {
                            (Color){20, 18, 18, 255});
 }
 
+// ============================================================================
+// Ember Glow
+// ============================================================================
+// The glow is a fixed gradient whose strength pulses. Each layer is
+// rasterized once at full strength and drawn as a single textured quad,
+// with the pulse applied through the tint alpha.
+
+#define GLOW_TOP_HEIGHT 40
+#define GLOW_BOTTOM_HEIGHT 60
+#define GLOW_CORNER_RADIUS 180  // Largest corner; the smaller one is scaled down
+
+typedef struct {
+    Texture2D topBand;      // 1 x GLOW_TOP_HEIGHT, stretched across the window
+    Texture2D bottomBand;   // 1 x GLOW_BOTTOM_HEIGHT
+    Texture2D corner;       // Radial falloff matching DrawCircleGradient
+    bool loaded;
+} GlowTextures;
+static GlowTextures g_glow = {0};
+
+static Texture2D BakeBand(int height, Color color, float strength) {
+    Image img = GenImageColor(1, height, BLANK);
+    Color *pixels = img.data;
+    for (int i = 0; i < height; i++) {
+        pixels[i] = ColorWithAlpha(color, (1.0f - (float)i / height) * strength);
+    }
+    Texture2D tex = LoadTextureFromImage(img);
+    UnloadImage(img);
+    return tex;
+}
+
+static Texture2D BakeCorner(int radius, Color color) {
+    int size = radius * 2;
+    Image img = GenImageColor(size, size, BLANK);
+    Color *pixels = img.data;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            float dx = x + 0.5f - radius;
+            float dy = y + 0.5f - radius;
+            float t = 1.0f - sqrtf(dx * dx + dy * dy) / radius;
+            if (t <= 0.0f) continue;
+            // Vertex-colour fade to BLANK: colour and alpha both ramp down
+            pixels[y * size + x] = (Color){(unsigned char)(color.r * t), (unsigned char)(color.g * t),
+                                           (unsigned char)(color.b * t), (unsigned char)(255 * t)};
+        }
+    }
+    Texture2D tex = LoadTextureFromImage(img);
+    SetTextureFilter(tex, TEXTURE_FILTER_BILINEAR);
+    UnloadImage(img);
+    return tex;
+}
+
+static void LoadGlowTextures(void) {
+    g_glow.topBand = BakeBand(GLOW_TOP_HEIGHT, COLOR_FIRE_DEEP, 0.15f);
+    g_glow.bottomBand = BakeBand(GLOW_BOTTOM_HEIGHT, COLOR_EMBER, 0.2f);
+    g_glow.corner = BakeCorner(GLOW_CORNER_RADIUS, COLOR_FIRE_DEEP);
+    g_glow.loaded = true;
+}
+
+static void UnloadGlowTextures(void) {
+    if (!g_glow.loaded) return;
+    UnloadTexture(g_glow.topBand);
+    UnloadTexture(g_glow.bottomBand);
+    UnloadTexture(g_glow.corner);
+    g_glow.loaded = false;
+}
+
+static void DrawGlowCorner(float x, float y, float radius, Color tint) {
+    Rectangle src = {0, 0, (float)g_glow.corner.width, (float)g_glow.corner.height};
+    Rectangle dst = {x - radius, y - radius, radius * 2, radius * 2};
+    DrawTexturePro(g_glow.corner, src, dst, (Vector2){0, 0}, 0.0f, tint);
+}
+
 static void DrawEmberGlow(float time) {
     float pulse = (sinf(time * GLOW_SPEED) + 1.0f) * 0.5f;
     float glowAlpha = LERP(EMBER_GLOW_MIN, EMBER_GLOW_MAX, pulse);
+    Color bandTint = ColorWithAlpha(WHITE, glowAlpha);
 
-    for (int i = 0; i < 40; i++) {
-        float alpha = glowAlpha * (1.0f - i / 40.0f) * 0.15f;
-        Color glow = ColorWithAlpha(COLOR_FIRE_DEEP, alpha);
-        DrawRectangle(0, i, WINDOW_WIDTH, 1, glow);
-    }
-
-    for (int i = 0; i < 60; i++) {
-        float alpha = glowAlpha * (1.0f - i / 60.0f) * 0.2f;
-        Color glow = ColorWithAlpha(COLOR_EMBER, alpha);
-        DrawRectangle(0, WINDOW_HEIGHT - 60 + i, WINDOW_WIDTH, 1, glow);
-    }
+    DrawTexturePro(g_glow.topBand, (Rectangle){0, 0, 1, GLOW_TOP_HEIGHT},
+                   (Rectangle){0, 0, WINDOW_WIDTH, GLOW_TOP_HEIGHT}, (Vector2){0, 0}, 0.0f, bandTint);
+    DrawTexturePro(g_glow.bottomBand, (Rectangle){0, 0, 1, GLOW_BOTTOM_HEIGHT},
+                   (Rectangle){0, WINDOW_HEIGHT - GLOW_BOTTOM_HEIGHT, WINDOW_WIDTH, GLOW_BOTTOM_HEIGHT},
+                   (Vector2){0, 0}, 0.0f, bandTint);
 
     float cornerPulse = (sinf(time * PULSE_SPEED + 1.5f) + 1.0f) * 0.5f;
-    Color cornerColor = ColorWithAlpha(COLOR_FIRE_DEEP, 0.1f + cornerPulse * 0.1f);
-    DrawCircleGradient(0, 0, 150, cornerColor, BLANK);
-    DrawCircleGradient(WINDOW_WIDTH, WINDOW_HEIGHT, 180, cornerColor, BLANK);
+    Color cornerTint = ColorWithAlpha(WHITE, 0.1f + cornerPulse * 0.1f);
+    DrawGlowCorner(0, 0, 150, cornerTint);
+    DrawGlowCorner(WINDOW_WIDTH, WINDOW_HEIGHT, GLOW_CORNER_RADIUS, cornerTint);
 }
 
 static void DrawHeader(void) {
@@ -501,7 +954,7 @@ static void DrawHeader(void) {
     Color borderColor = ColorWithAlpha(COLOR_FIRE_DEEP, 0.6f + pulse * 0.4f);
     DrawRectangle(0, HEADER_HEIGHT - 2, WINDOW_WIDTH, 2, borderColor);
 
-    DrawTextEx(g_font, "SALAMANDER",
+    TextCacheDraw(g_font, "SALAMANDER",
                (Vector2){HEADER_PADDING, (HEADER_HEIGHT - 24) / 2},
                24, 1, COLOR_FIRE_DEEP);
 
@@ -516,6 +969,7 @@ static void DrawHeader(void) {
             statusColor = COLOR_CONNECTED;
             statusIcon = "[*]";
             break;
+        case SSH_STATUS_UNKNOWN:
         case SSH_STATUS_CHECKING:
             statusText = "Checking...";
             statusColor = COLOR_EMBER;
@@ -530,8 +984,8 @@ static void DrawHeader(void) {
 
     char statusStr[128];
     snprintf(statusStr, sizeof(statusStr), "%s %s", statusIcon, statusText);
-    Vector2 textSize = MeasureTextEx(g_font, statusStr, 18, 1);
-    DrawTextEx(g_font, statusStr,
+    Vector2 textSize = TextCacheMeasure(g_font, statusStr, 18, 1);
+    TextCacheDraw(g_font, statusStr,
                (Vector2){WINDOW_WIDTH - textSize.x - HEADER_PADDING, (HEADER_HEIGHT - 18) / 2},
                18, 1, statusColor);
 }
@@ -541,7 +995,7 @@ static void DrawSectionHeader(const char *title, float y, Color accentColor, boo
         DrawRectangle(SIDEBAR_PADDING - 8, (int)y - 4, SIDEBAR_WIDTH - SIDEBAR_PADDING * 2 + 16, 22,
                       ColorWithAlpha(accentColor, 0.3f));
     }
-    DrawTextEx(g_font, title, (Vector2){SIDEBAR_PADDING, y}, 14, 1, accentColor);
+    TextCacheDraw(g_font, title, (Vector2){SIDEBAR_PADDING, y}, 14, 1, accentColor);
 }
 
 static void DrawPluginItem(const PluginInfo *p, float y, bool selected, bool hovered, bool isDragSource, Color accentColor) {
@@ -560,7 +1014,19 @@ static void DrawPluginItem(const PluginInfo *p, float y, bool selected, bool hov
     Color textColor = selected ? COLOR_TEXT_BRIGHT : (hovered ? COLOR_TEXT_BRIGHT : COLOR_TEXT_WARM);
     textColor = ColorWithAlpha(textColor, alpha);
 
-    DrawTextEx(g_font, p->displayName, (Vector2){SIDEBAR_PADDING + 8, y + 10.0f}, 16, 1, textColor);
+    TextCacheDraw(g_font, p->displayName, (Vector2){SIDEBAR_PADDING + 8, y + 10.0f}, 16, 1, textColor);
+
+    // Gold tick box: marked for the next batch
+    if (IsMarked(p->name)) {
+        Rectangle box = {itemRect.x + itemRect.width - 32, y + SIDEBAR_ITEM_HEIGHT / 2 - 5, 10, 10};
+        DrawRectangleRounded(box, 0.3f, 4, ColorWithAlpha(COLOR_GOLD, alpha));
+    }
+
+    // Ember dot: device copy differs from the local build
+    if (p->syncState == PLUGIN_SYNC_STALE) {
+        DrawCircle((int)(itemRect.x + itemRect.width - 14), (int)(y + SIDEBAR_ITEM_HEIGHT / 2), 4,
+                   ColorWithAlpha(COLOR_EMBER, alpha));
+    }
 }
 
 static void DrawSidebar(const PluginList *plugins, float deltaTime) {
@@ -571,9 +1037,6 @@ static void DrawSidebar(const PluginList *plugins, float deltaTime) {
     DrawRectangle(SIDEBAR_WIDTH - 1, HEADER_HEIGHT, 1, SIDEBAR_CONTENT_HEIGHT,
                   ColorWithAlpha(COLOR_FIRE_DEEP, 0.3f));
 
-    int deviceOnly, synced, localOnly;
-    GetSectionCounts(plugins, &deviceOnly, &synced, &localOnly);
-
     Vector2 mouse = GetMousePosition();
     bool mouseInSidebar = (mouse.x < SIDEBAR_WIDTH && mouse.y > HEADER_HEIGHT && mouse.y < WINDOW_HEIGHT - FOOTER_HEIGHT);
 
@@ -583,163 +1046,73 @@ static void DrawSidebar(const PluginList *plugins, float deltaTime) {
     // Begin scissor mode for scrolling content
     BeginScissorMode(0, SIDEBAR_CONTENT_TOP, SIDEBAR_WIDTH, SIDEBAR_CONTENT_HEIGHT);
 
-    // Content Y starts at padding, offset by scroll
-    float y = SIDEBAR_CONTENT_TOP + SIDEBAR_PADDING - g_scrollOffset;
-    float contentY = SIDEBAR_PADDING;  // For section rect calculation (without screen offset)
+    // Content space -> screen space
+    float screenOffset = SIDEBAR_CONTENT_TOP - g_scrollOffset;
 
     // Adjusted mouse Y for scroll
     float adjustedMouseY = mouse.y - SIDEBAR_CONTENT_TOP + g_scrollOffset;
 
     SectionType hoverSection = SECTION_LOCAL_ONLY;
-
-    // =========== SECTION: DEVICE ONLY ===========
-    float sectionStartY = contentY;
-    int sectionHeight = 24 + (deviceOnly > 0 ? deviceOnly * (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING) : 20);
-    g_sectionRects[SECTION_DEVICE_ONLY] = (Rectangle){0, sectionStartY, SIDEBAR_WIDTH, (float)sectionHeight};
-
-    if (mouseInSidebar && adjustedMouseY >= sectionStartY && adjustedMouseY < sectionStartY + sectionHeight) {
-        hoverSection = SECTION_DEVICE_ONLY;
-    }
-
-    bool isDropTarget = g_drag.isDragging && g_drag.sourceSection == SECTION_LOCAL_ONLY && mouseInSidebar;
-    DrawSectionHeader("DEVICE ONLY", y, COLOR_INSTALLING, isDropTarget && hoverSection == SECTION_DEVICE_ONLY);
-    y += 24;
-    contentY += 24;
-
-    if (deviceOnly == 0) {
-        const char *msg = (SshGetStatus() == SSH_STATUS_CONNECTED) ? "(none)" : "(connect to view)";
-        DrawTextEx(g_font, msg, (Vector2){SIDEBAR_PADDING, y}, 12, 1, COLOR_TEXT_DIM);
-        y += 20;
-        contentY += 20;
-    } else {
-        int idx = 0;
-        for (int i = 0; i < plugins->count; i++) {
-            const PluginInfo *p = &plugins->plugins[i];
-            if (p->remotePath[0] != '\0' && p->localPath[0] == '\0') {
-                bool selected = (g_selection.section == SECTION_DEVICE_ONLY && g_selection.index == idx);
-                bool isDragSource = g_drag.isDragging && strcmp(g_drag.pluginName, p->name) == 0;
-
-                // Check hover
-                bool hovered = false;
-                if (mouseInSidebar && !g_drag.isDragging) {
-                    float itemTop = contentY;
-                    float itemBottom = contentY + SIDEBAR_ITEM_HEIGHT;
-                    if (adjustedMouseY >= itemTop && adjustedMouseY < itemBottom) {
-                        g_hoverSection = SECTION_DEVICE_ONLY;
-                        g_hoverIndex = idx;
-                        hovered = true;
-                    }
-                }
-
-                DrawPluginItem(p, y, selected, hovered, isDragSource, COLOR_INSTALLING);
-                y += SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING;
-                contentY += SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING;
-                idx++;
-            }
+    int hoverRow = -1;
+    if (mouseInSidebar) {
+        int hit = HitTestSidebar(adjustedMouseY, &hoverRow);
+        if (hit >= 0) hoverSection = (SectionType)hit;
+        if (!g_drag.isDragging && hoverRow >= 0) {
+            g_hoverSection = hoverSection;
+            g_hoverIndex = hoverRow;
         }
     }
 
-    y += SIDEBAR_SECTION_SPACING / 2;
-    contentY += SIDEBAR_SECTION_SPACING / 2;
+    const char *titles[3] = {"DEVICE ONLY", "SYNCED", "LOCAL ONLY"};
+    const Color accents[3] = {COLOR_INSTALLING, COLOR_CONNECTED, COLOR_EMBER};
+    const PluginSectionView *view = PluginBrowserGetSections();
 
-    // =========== SECTION: SYNCED ===========
-    sectionStartY = contentY;
-    sectionHeight = 24 + (synced > 0 ? synced * (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING) : 20);
-    g_sectionRects[SECTION_SYNCED] = (Rectangle){0, sectionStartY, SIDEBAR_WIDTH, (float)sectionHeight};
-
-    if (mouseInSidebar && adjustedMouseY >= sectionStartY && adjustedMouseY < sectionStartY + sectionHeight) {
-        hoverSection = SECTION_SYNCED;
-    }
+    // Visible band in content space
+    float viewTop = g_scrollOffset;
+    float viewBottom = g_scrollOffset + SIDEBAR_CONTENT_HEIGHT;
 
-    isDropTarget = g_drag.isDragging && g_drag.sourceSection == SECTION_LOCAL_ONLY && mouseInSidebar;
-    DrawSectionHeader("SYNCED", y, COLOR_CONNECTED, isDropTarget && hoverSection == SECTION_SYNCED);
-    y += 24;
-    contentY += 24;
-
-    if (synced == 0) {
-        DrawTextEx(g_font, "(none)", (Vector2){SIDEBAR_PADDING, y}, 12, 1, COLOR_TEXT_DIM);
-        y += 20;
-        contentY += 20;
-    } else {
-        int idx = 0;
-        for (int i = 0; i < plugins->count; i++) {
-            const PluginInfo *p = &plugins->plugins[i];
-            if (p->remotePath[0] != '\0' && p->localPath[0] != '\0') {
-                bool selected = (g_selection.section == SECTION_SYNCED && g_selection.index == idx);
-                bool isDragSource = g_drag.isDragging && strcmp(g_drag.pluginName, p->name) == 0;
-
-                // Check hover
-                bool hovered = false;
-                if (mouseInSidebar && !g_drag.isDragging) {
-                    float itemTop = contentY;
-                    float itemBottom = contentY + SIDEBAR_ITEM_HEIGHT;
-                    if (adjustedMouseY >= itemTop && adjustedMouseY < itemBottom) {
-                        g_hoverSection = SECTION_SYNCED;
-                        g_hoverIndex = idx;
-                        hovered = true;
-                    }
-                }
+    for (int section = 0; section < 3; section++) {
+        bool isDropTarget;
+        if (section == SECTION_LOCAL_ONLY) {
+            isDropTarget = g_drag.isDragging && (g_drag.sourceSection == SECTION_SYNCED || g_drag.sourceSection == SECTION_DEVICE_ONLY) && mouseInSidebar;
+        } else {
+            isDropTarget = g_drag.isDragging && g_drag.sourceSection == SECTION_LOCAL_ONLY && mouseInSidebar;
+        }
+        // Skip sections scrolled entirely out of view
+        Rectangle rect = g_sectionRects[section];
+        if (rect.y + rect.height < viewTop || rect.y >= viewBottom) continue;
+
+        float headerY = g_layout.headerY[section];
+        if (headerY + SIDEBAR_HEADER_HEIGHT >= viewTop) {
+            DrawSectionHeader(titles[section], headerY + screenOffset, accents[section],
+                              isDropTarget && hoverSection == (SectionType)section);
+        }
 
-                DrawPluginItem(p, y, selected, hovered, isDragSource, COLOR_CONNECTED);
-                y += SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING;
-                contentY += SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING;
-                idx++;
+        float itemsY = g_layout.itemsY[section] + screenOffset;
+        if (g_layout.count[section] == 0) {
+            const char *msg = "(none)";
+            if (section == SECTION_DEVICE_ONLY && SshGetStatus() != SSH_STATUS_CONNECTED) {
+                msg = "(connect to view)";
             }
+            TextCacheDraw(g_font, msg, (Vector2){SIDEBAR_PADDING, itemsY}, 12, 1, COLOR_TEXT_DIM);
+            continue;
         }
-    }
-
-    y += SIDEBAR_SECTION_SPACING / 2;
-    contentY += SIDEBAR_SECTION_SPACING / 2;
 
-    // =========== SECTION: LOCAL ONLY ===========
-    sectionStartY = contentY;
-    sectionHeight = 24 + (localOnly > 0 ? localOnly * (SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING) : 20);
-    g_sectionRects[SECTION_LOCAL_ONLY] = (Rectangle){0, sectionStartY, SIDEBAR_WIDTH, (float)sectionHeight};
-
-    if (mouseInSidebar && adjustedMouseY >= sectionStartY && adjustedMouseY < sectionStartY + sectionHeight) {
-        hoverSection = SECTION_LOCAL_ONLY;
-    }
+        // Only the rows on screen; scissoring trims the partial ones
+        int first, last;
+        if (!GetVisibleRows(section, &first, &last)) continue;
 
-    isDropTarget = g_drag.isDragging && (g_drag.sourceSection == SECTION_SYNCED || g_drag.sourceSection == SECTION_DEVICE_ONLY) && mouseInSidebar;
-    DrawSectionHeader("LOCAL ONLY", y, COLOR_EMBER, isDropTarget && hoverSection == SECTION_LOCAL_ONLY);
-    y += 24;
-    contentY += 24;
+        const PluginSection *items = &view->sections[g_sectionStatus[section]];
+        for (int idx = first; idx <= last; idx++) {
+            const PluginInfo *p = &plugins->plugins[items->slots[idx]];
+            bool selected = (g_selection.section == (SectionType)section && g_selection.index == idx);
+            bool isDragSource = g_drag.isDragging && strcmp(g_drag.pluginName, p->name) == 0;
+            bool hovered = (!g_drag.isDragging && hoverSection == (SectionType)section && hoverRow == idx);
 
-    if (localOnly == 0) {
-        DrawTextEx(g_font, "(none)", (Vector2){SIDEBAR_PADDING, y}, 12, 1, COLOR_TEXT_DIM);
-        y += 20;
-        contentY += 20;
-    } else {
-        int idx = 0;
-        for (int i = 0; i < plugins->count; i++) {
-            const PluginInfo *p = &plugins->plugins[i];
-            if (p->localPath[0] != '\0' && p->remotePath[0] == '\0') {
-                bool selected = (g_selection.section == SECTION_LOCAL_ONLY && g_selection.index == idx);
-                bool isDragSource = g_drag.isDragging && strcmp(g_drag.pluginName, p->name) == 0;
-
-                // Check hover
-                bool hovered = false;
-                if (mouseInSidebar && !g_drag.isDragging) {
-                    float itemTop = contentY;
-                    float itemBottom = contentY + SIDEBAR_ITEM_HEIGHT;
-                    if (adjustedMouseY >= itemTop && adjustedMouseY < itemBottom) {
-                        g_hoverSection = SECTION_LOCAL_ONLY;
-                        g_hoverIndex = idx;
-                        hovered = true;
-                    }
-                }
-
-                DrawPluginItem(p, y, selected, hovered, isDragSource, COLOR_EMBER);
-                y += SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING;
-                contentY += SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING;
-                idx++;
-            }
+            DrawPluginItem(p, itemsY + idx * SIDEBAR_ITEM_PITCH, selected, hovered, isDragSource, accents[section]);
         }
     }
 
-    // Store total content height for scroll calculations
-    g_totalContentHeight = contentY + SIDEBAR_PADDING;
-
     // Draw drop zone highlight
     if (g_drag.isDragging && mouseInSidebar) {
         Rectangle dropRect = g_sectionRects[hoverSection];
@@ -798,7 +1171,7 @@ static void DrawDragGhost(void) {
     DrawRectangleRounded(ghostRect, 0.3f, 4, ColorWithAlpha(COLOR_FIRE_DEEP, ghostAlpha * 0.8f));
     DrawRectangleRoundedLines(ghostRect, 0.3f, 4, ColorWithAlpha(COLOR_GOLD, ghostAlpha));
 
-    DrawTextEx(g_font, g_drag.pluginName,
+    TextCacheDraw(g_font, g_drag.pluginName,
                (Vector2){ghostRect.x + 8, ghostRect.y + 7},
                14, 1, ColorWithAlpha(COLOR_TEXT_BRIGHT, ghostAlpha));
 
@@ -807,21 +1180,17 @@ static void DrawDragGhost(void) {
 
     if (inSidebar) {
         float adjustedMouseY = mouse.y - SIDEBAR_CONTENT_TOP + g_scrollOffset;
-        for (int i = 0; i < 3; i++) {
-            if (adjustedMouseY >= g_sectionRects[i].y &&
-                adjustedMouseY < g_sectionRects[i].y + g_sectionRects[i].height) {
-                if (g_drag.sourceSection == SECTION_LOCAL_ONLY && (i == SECTION_DEVICE_ONLY || i == SECTION_SYNCED)) {
-                    hint = "Drop to INSTALL";
-                } else if ((g_drag.sourceSection == SECTION_SYNCED || g_drag.sourceSection == SECTION_DEVICE_ONLY) && i == SECTION_LOCAL_ONLY) {
-                    hint = "Drop to UNINSTALL";
-                }
-                break;
-            }
+        int row;
+        int i = HitTestSidebar(adjustedMouseY, &row);
+        if (g_drag.sourceSection == SECTION_LOCAL_ONLY && (i == SECTION_DEVICE_ONLY || i == SECTION_SYNCED)) {
+            hint = "Drop to INSTALL";
+        } else if ((g_drag.sourceSection == SECTION_SYNCED || g_drag.sourceSection == SECTION_DEVICE_ONLY) && i == SECTION_LOCAL_ONLY) {
+            hint = "Drop to UNINSTALL";
         }
     }
 
     if (hint) {
-        DrawTextEx(g_font, hint,
+        TextCacheDraw(g_font, hint,
                    (Vector2){mouse.x + 10, mouse.y + 20},
                    12, 1, COLOR_GOLD);
     }
@@ -836,10 +1205,10 @@ static void DrawMainPanel(const PluginInfo *plugin) {
     DrawRectangle(panelX, panelY, panelW, panelH, COLOR_CHARCOAL_DARK);
 
     if (!plugin) {
-        DrawTextEx(g_font, "Select a plugin",
+        TextCacheDraw(g_font, "Select a plugin",
                    (Vector2){panelX + PANEL_PADDING, panelY + PANEL_PADDING + 50},
                    20, 1, COLOR_TEXT_DIM);
-        DrawTextEx(g_font, "Drag plugins between sections to install/uninstall",
+        TextCacheDraw(g_font, "Drag plugins between sections to install/uninstall",
                    (Vector2){panelX + PANEL_PADDING, panelY + PANEL_PADDING + 80},
                    14, 1, COLOR_TEXT_DIM);
         return;
@@ -847,7 +1216,7 @@ static void DrawMainPanel(const PluginInfo *plugin) {
 
     int y = panelY + PANEL_PADDING;
 
-    DrawTextEx(g_font, plugin->displayName, (Vector2){panelX + PANEL_PADDING, (float)y}, 32, 2, COLOR_TEXT_BRIGHT);
+    TextCacheDraw(g_font, plugin->displayName, (Vector2){panelX + PANEL_PADDING, (float)y}, 32, 2, COLOR_TEXT_BRIGHT);
     y += 48;
 
     float pulse = (sinf(g_animTime * 2.0f) + 1.0f) * 0.5f;
@@ -855,34 +1224,64 @@ static void DrawMainPanel(const PluginInfo *plugin) {
     DrawRectangle(panelX + PANEL_PADDING, y, 200, 2, lineColor);
     y += 20;
 
-    DrawTextEx(g_font, "llizardgui plugin", (Vector2){panelX + PANEL_PADDING, (float)y}, 16, 1, COLOR_TEXT_DIM);
+    TextCacheDraw(g_font, "llizardgui plugin", (Vector2){panelX + PANEL_PADDING, (float)y}, 16, 1, COLOR_TEXT_DIM);
     y += 30;
 
-    char sizeStr[64];
     if (plugin->localSize > 0) {
-        FormatFileSize(plugin->localSize, sizeStr, sizeof(sizeStr));
         char info[128];
-        snprintf(info, sizeof(info), "Local size: %s", sizeStr);
-        DrawTextEx(g_font, info, (Vector2){panelX + PANEL_PADDING, (float)y}, 16, 1, COLOR_TEXT_WARM);
+        snprintf(info, sizeof(info), "Local size: %s", plugin->detail->localSizeText);
+        TextCacheDraw(g_font, info, (Vector2){panelX + PANEL_PADDING, (float)y}, 16, 1, COLOR_TEXT_WARM);
         y += 24;
     }
 
     if (plugin->remoteSize > 0) {
-        FormatFileSize(plugin->remoteSize, sizeStr, sizeof(sizeStr));
         char info[128];
-        snprintf(info, sizeof(info), "Device size: %s", sizeStr);
-        DrawTextEx(g_font, info, (Vector2){panelX + PANEL_PADDING, (float)y}, 16, 1, COLOR_TEXT_WARM);
+        snprintf(info, sizeof(info), "Device size: %s", plugin->detail->remoteSizeText);
+        TextCacheDraw(g_font, info, (Vector2){panelX + PANEL_PADDING, (float)y}, 16, 1, COLOR_TEXT_WARM);
         y += 24;
     }
 
+    // What the local build's ELF headers say
+    if (plugin->detail->elf.state == ELF_INVALID) {
+        char info[128];
+        snprintf(info, sizeof(info), "Rejected: %s", plugin->detail->elf.error);
+        TextCacheDraw(g_font, info, (Vector2){panelX + PANEL_PADDING, (float)y}, 14, 1, COLOR_DISCONNECTED);
+        y += 20;
+    } else if (plugin->detail->elf.state == ELF_VALID) {
+        char info[160];
+        char abi[24];
+        if (plugin->detail->elf.abiVersion >= 0) {
+            snprintf(abi, sizeof(abi), "plugin API %d", plugin->detail->elf.abiVersion);
+        } else {
+            snprintf(abi, sizeof(abi), "unversioned");
+        }
+        snprintf(info, sizeof(info), "%s  |  %s%s%s", plugin->detail->elf.machine, abi,
+                 plugin->detail->elf.soname[0] ? "  |  " : "", plugin->detail->elf.soname);
+        TextCacheDraw(g_font, info, (Vector2){panelX + PANEL_PADDING, (float)y}, 14, 1, COLOR_TEXT_WARM);
+        y += 20;
+        if (plugin->detail->elf.buildId[0]) {
+            snprintf(info, sizeof(info), "Build ID: %.16s", plugin->detail->elf.buildId);
+            TextCacheDraw(g_font, info, (Vector2){panelX + PANEL_PADDING, (float)y}, 14, 1, COLOR_TEXT_DIM);
+            y += 20;
+        }
+    }
+
     y += 10;
 
     const char *statusText;
     Color statusColor;
     switch (plugin->status) {
         case PLUGIN_INSTALLED:
-            statusText = "Synced (on both)";
-            statusColor = COLOR_CONNECTED;
+            if (plugin->syncState == PLUGIN_SYNC_STALE) {
+                statusText = "Synced (stale - update available)";
+                statusColor = COLOR_EMBER;
+            } else if (plugin->syncState == PLUGIN_SYNC_UP_TO_DATE) {
+                statusText = "Synced (up to date)";
+                statusColor = COLOR_CONNECTED;
+            } else {
+                statusText = "Synced (on both)";
+                statusColor = COLOR_CONNECTED;
+            }
             break;
         case PLUGIN_LOCAL_ONLY:
             statusText = "Local Only";
@@ -894,13 +1293,15 @@ static void DrawMainPanel(const PluginInfo *plugin) {
             break;
     }
 
-    DrawTextEx(g_font, "Status:", (Vector2){panelX + PANEL_PADDING, (float)y}, 16, 1, COLOR_TEXT_DIM);
-    DrawTextEx(g_font, statusText, (Vector2){panelX + PANEL_PADDING + 70, (float)y}, 16, 1, statusColor);
+    TextCacheDraw(g_font, "Status:", (Vector2){panelX + PANEL_PADDING, (float)y}, 16, 1, COLOR_TEXT_DIM);
+    TextCacheDraw(g_font, statusText, (Vector2){panelX + PANEL_PADDING + 70, (float)y}, 16, 1, statusColor);
     y += 50;
 
-    bool canInstall = (plugin->localPath[0] != '\0' && plugin->remotePath[0] == '\0' && SshGetStatus() == SSH_STATUS_CONNECTED);
-    bool canUninstall = (plugin->remotePath[0] != '\0' && SshGetStatus() == SSH_STATUS_CONNECTED);
-    bool isBusy = PluginBrowserIsBusy();
+    // With plugins marked, the buttons act on the whole marked set
+    int installTargets = CountTargets(plugin, CanInstall);
+    int uninstallTargets = CountTargets(plugin, CanUninstall);
+    bool canInstall = installTargets > 0;
+    bool canUninstall = uninstallTargets > 0;
 
     // Check which operation is in progress
     const PluginOpState *opState = PluginBrowserGetOpState();
@@ -912,8 +1313,8 @@ static void DrawMainPanel(const PluginInfo *plugin) {
     g_uninstallBtn = (Rectangle){panelX + PANEL_PADDING + BUTTON_WIDTH + BUTTON_SPACING, (float)y, BUTTON_WIDTH, BUTTON_HEIGHT};
 
     Vector2 mouse = GetMousePosition();
-    bool installHovered = CheckCollisionPointRec(mouse, g_installBtn) && canInstall && !isBusy;
-    bool uninstallHovered = CheckCollisionPointRec(mouse, g_uninstallBtn) && canUninstall && !isBusy;
+    bool installHovered = CheckCollisionPointRec(mouse, g_installBtn) && canInstall;
+    bool uninstallHovered = CheckCollisionPointRec(mouse, g_uninstallBtn) && canUninstall;
 
     // ========== INSTALL BUTTON ==========
     float installPress = g_installBtnPress;
@@ -948,7 +1349,7 @@ static void DrawMainPanel(const PluginInfo *plugin) {
             (unsigned char)(10 + (int)(firePulse * 30)),   // B: 10-40
             255
         };
-    } else if (canInstall && !isBusy) {
+    } else if (canInstall) {
         if (installPress > 0.1f) {
             installBg = COLOR_GOLD;
         } else {
@@ -957,7 +1358,7 @@ static void DrawMainPanel(const PluginInfo *plugin) {
     } else {
         installBg = ColorWithAlpha(COLOR_FIRE_DEEP, 0.3f);
     }
-    Color installTextColor = (canInstall && !isBusy) || isInstalling ? COLOR_TEXT_BRIGHT : COLOR_TEXT_DIM;
+    Color installTextColor = (canInstall) || isInstalling ? COLOR_TEXT_BRIGHT : COLOR_TEXT_DIM;
 
     // Glow effect when pressed or working
     if (installPress > 0.1f || isInstalling) {
@@ -1001,9 +1402,17 @@ static void DrawMainPanel(const PluginInfo *plugin) {
         DrawRectangleRoundedLines(installDrawRect, BUTTON_RADIUS, 4, ColorWithAlpha(COLOR_GOLD, 0.8f));
     }
 
-    const char *installLabel = isInstalling ? "INSTALLING..." : "INSTALL";
-    Vector2 installSize = MeasureTextEx(g_font, installLabel, 16, 1);
-    DrawTextEx(g_font, installLabel,
+    bool isUpdate = (plugin->remotePath[0] != '\0');
+    char installLabel[32];
+    if (isInstalling) {
+        snprintf(installLabel, sizeof(installLabel), "%s", isUpdate ? "UPDATING..." : "INSTALLING...");
+    } else if (g_markedCount > 0) {
+        snprintf(installLabel, sizeof(installLabel), "INSTALL (%d)", installTargets);
+    } else {
+        snprintf(installLabel, sizeof(installLabel), "%s", isUpdate ? "UPDATE" : "INSTALL");
+    }
+    Vector2 installSize = TextCacheMeasure(g_font, installLabel, 16, 1);
+    TextCacheDraw(g_font, installLabel,
                (Vector2){installDrawRect.x + (installDrawRect.width - installSize.x) / 2,
                          installDrawRect.y + (installDrawRect.height - 16) / 2},
                16, 1, installTextColor);
@@ -1041,7 +1450,7 @@ static void DrawMainPanel(const PluginInfo *plugin) {
             (unsigned char)(50 + (int)(coolPulse * 30)),    // B: cooler tones
             255
         };
-    } else if (canUninstall && !isBusy) {
+    } else if (canUninstall) {
         if (uninstallPress > 0.1f) {
             uninstallBg = COLOR_DISCONNECTED;
         } else {
@@ -1050,7 +1459,7 @@ static void DrawMainPanel(const PluginInfo *plugin) {
     } else {
         uninstallBg = ColorWithAlpha(COLOR_ASH, 0.3f);
     }
-    Color uninstallTextColor = (canUninstall && !isBusy) || isUninstalling ? COLOR_TEXT_WARM : COLOR_TEXT_DIM;
+    Color uninstallTextColor = (canUninstall) || isUninstalling ? COLOR_TEXT_WARM : COLOR_TEXT_DIM;
 
     // Glow effect when pressed or working
     if (uninstallPress > 0.1f || isUninstalling) {
@@ -1080,9 +1489,16 @@ static void DrawMainPanel(const PluginInfo *plugin) {
         DrawRectangleRoundedLines(uninstallDrawRect, BUTTON_RADIUS, 4, ColorWithAlpha(COLOR_DISCONNECTED, 0.8f));
     }
 
-    const char *uninstallLabel = isUninstalling ? "REMOVING..." : "UNINSTALL";
-    Vector2 uninstallSize = MeasureTextEx(g_font, uninstallLabel, 16, 1);
-    DrawTextEx(g_font, uninstallLabel,
+    char uninstallLabel[32];
+    if (isUninstalling) {
+        snprintf(uninstallLabel, sizeof(uninstallLabel), "REMOVING...");
+    } else if (g_markedCount > 0) {
+        snprintf(uninstallLabel, sizeof(uninstallLabel), "UNINSTALL (%d)", uninstallTargets);
+    } else {
+        snprintf(uninstallLabel, sizeof(uninstallLabel), "UNINSTALL");
+    }
+    Vector2 uninstallSize = TextCacheMeasure(g_font, uninstallLabel, 16, 1);
+    TextCacheDraw(g_font, uninstallLabel,
                (Vector2){uninstallDrawRect.x + (uninstallDrawRect.width - uninstallSize.x) / 2,
                          uninstallDrawRect.y + (uninstallDrawRect.height - 16) / 2},
                16, 1, uninstallTextColor);
@@ -1092,11 +1508,43 @@ static void DrawMainPanel(const PluginInfo *plugin) {
     // Progress bar (opState already defined above)
     if (opState->operation != OP_NONE || (opState->complete && g_animTime < 3.0f)) {
         Rectangle progressBounds = {panelX + PANEL_PADDING, (float)y, panelW - PANEL_PADDING * 2, PROGRESS_HEIGHT};
-        DrawProgressBar(progressBounds, opState->progress, opState->message);
+
+        // Throughput readout while bytes are moving
+        char detail[96] = {0};
+        if (!opState->complete && opState->avgBytesPerSec > 0) {
+            char rate[32], avg[32];
+            FormatFileSize((long)opState->bytesPerSec, rate, sizeof(rate));
+            FormatFileSize((long)opState->avgBytesPerSec, avg, sizeof(avg));
+            if (opState->etaSeconds >= 0) {
+                snprintf(detail, sizeof(detail), "%s/s  (avg %s/s)  ETA %.0fs", rate, avg, opState->etaSeconds);
+            } else {
+                snprintf(detail, sizeof(detail), "%s/s  (avg %s/s)", rate, avg);
+            }
+        }
+        DrawProgressBar(progressBounds, opState->progress, opState->message, detail);
+
+        // Per-file progress while several transfers run at once
+        int active = 0;
+        for (int i = 0; i < PLUGIN_MAX_STREAMS; i++) {
+            if (opState->streams[i].active) active++;
+        }
+        if (active > 1) {
+            float streamY = y + PROGRESS_HEIGHT + 30;
+            for (int i = 0; i < PLUGIN_MAX_STREAMS; i++) {
+                const PluginStreamState *stream = &opState->streams[i];
+                if (!stream->active) continue;
+                Rectangle track = {panelX + PANEL_PADDING + 140, streamY + 5, panelW - PANEL_PADDING * 2 - 140, 4};
+                TextCacheDraw(g_font, stream->pluginName, (Vector2){panelX + PANEL_PADDING, streamY}, 12, 1, COLOR_TEXT_DIM);
+                DrawRectangleRec(track, COLOR_ASH);
+                DrawRectangle((int)track.x, (int)track.y, (int)(track.width * stream->progress), (int)track.height,
+                              COLOR_FLAME_ORANGE);
+                streamY += 18;
+            }
+        }
     }
 }
 
-static void DrawProgressBar(Rectangle bounds, float progress, const char *label) {
+static void DrawProgressBar(Rectangle bounds, float progress, const char *label, const char *detail) {
     DrawRectangleRounded(bounds, PROGRESS_RADIUS, 4, COLOR_ASH);
 
     Rectangle fill = {bounds.x + 2, bounds.y + 2, (bounds.width - 4) * progress, bounds.height - 4};
@@ -1107,13 +1555,21 @@ static void DrawProgressBar(Rectangle bounds, float progress, const char *label)
 
     if (label && label[0]) {
         float labelY = bounds.y + bounds.height + 8;
-        DrawTextEx(g_font, label, (Vector2){bounds.x, labelY}, 14, 1, COLOR_TEXT_DIM);
+        TextCacheDraw(g_font, label, (Vector2){bounds.x, labelY}, 14, 1, COLOR_TEXT_DIM);
+    }
+
+    // Right-aligned under the bar, opposite the label
+    if (detail && detail[0]) {
+        Vector2 detailSize = TextCacheMeasure(g_font, detail, 12, 1);
+        TextCacheDraw(g_font, detail,
+                   (Vector2){bounds.x + bounds.width - detailSize.x, bounds.y + bounds.height + 9},
+                   12, 1, COLOR_GOLD);
     }
 
     char pctStr[16];
     snprintf(pctStr, sizeof(pctStr), "%.0f%%", progress * 100);
-    Vector2 pctSize = MeasureTextEx(g_font, pctStr, 12, 1);
-    DrawTextEx(g_font, pctStr,
+    Vector2 pctSize = TextCacheMeasure(g_font, pctStr, 12, 1);
+    TextCacheDraw(g_font, pctStr,
                (Vector2){bounds.x + bounds.width - pctSize.x, bounds.y + (bounds.height - 12) / 2},
                12, 1, COLOR_TEXT_BRIGHT);
 }
@@ -1124,8 +1580,8 @@ static void DrawFooter(void) {
     DrawRectangle(0, footerY, WINDOW_WIDTH, FOOTER_HEIGHT, COLOR_WARM_GRAY);
     DrawRectangle(0, footerY, WINDOW_WIDTH, 1, ColorWithAlpha(COLOR_FIRE_DEEP, 0.3f));
 
-    const char *instructions = "Drag to install/uninstall  |  Scroll: Mouse wheel  |  Tab: Switch section  |  R: Refresh";
-    DrawTextEx(g_font, instructions,
+    const char *instructions = "Drag to install/uninstall  |  Space/Ctrl+Click: Mark  |  Tab: Switch section  |  R: Refresh";
+    TextCacheDraw(g_font, instructions,
                (Vector2){HEADER_PADDING, footerY + (FOOTER_HEIGHT - 14) / 2.0f},
                14, 1, COLOR_TEXT_DIM);
 }
@@ -1136,7 +1592,6 @@ static void DrawFooter(void) {
 
 static void HandleInput(const PluginList *plugins) {
     Vector2 mouse = GetMousePosition();
-    bool isBusy = PluginBrowserIsBusy();
     bool mouseInSidebar = (mouse.x < SIDEBAR_WIDTH && mouse.y > HEADER_HEIGHT && mouse.y < WINDOW_HEIGHT - FOOTER_HEIGHT);
 
     // Mouse wheel scrolling
@@ -1159,18 +1614,18 @@ static void HandleInput(const PluginList *plugins) {
             g_selection.section = (g_selection.section + 1) % 3;
             g_selection.index = 0;
             tries--;
-        } while (GetSectionCount(plugins, g_selection.section) == 0 && tries > 0);
-        ScrollToSelection(plugins);
+        } while (GetSectionCount(g_selection.section) == 0 && tries > 0);
+        ScrollToSelection();
     }
 
-    int currentCount = GetSectionCount(plugins, g_selection.section);
+    int currentCount = GetSectionCount(g_selection.section);
     if (IsKeyPressed(KEY_DOWN) && currentCount > 0) {
         g_selection.index = (g_selection.index + 1) % currentCount;
-        ScrollToSelection(plugins);
+        ScrollToSelection();
     }
     if (IsKeyPressed(KEY_UP) && currentCount > 0) {
         g_selection.index = (g_selection.index - 1 + currentCount) % currentCount;
-        ScrollToSelection(plugins);
+        ScrollToSelection();
     }
 
     // Refresh
@@ -1178,92 +1633,59 @@ static void HandleInput(const PluginList *plugins) {
         g_needsRefresh = true;
     }
 
-    // Keyboard install/uninstall
+    if (IsKeyPressed(KEY_F3)) {
+        TogglePerfOverlay();
+    }
+
+    // Keyboard install/uninstall (queued behind any running batch)
     const PluginInfo *selectedPlugin = GetSelectedPlugin(plugins);
-    if (IsKeyPressed(KEY_ENTER) && selectedPlugin && !isBusy) {
-        if (selectedPlugin->localPath[0] != '\0' && selectedPlugin->remotePath[0] == '\0' &&
-            SshGetStatus() == SSH_STATUS_CONNECTED) {
-            g_installBtnPress = 1.0f;
-            strncpy(g_lastOpPlugin, selectedPlugin->name, sizeof(g_lastOpPlugin) - 1);
-            g_lastOpType = OP_INSTALLING;
-            g_lastOpComplete = false;
-            PluginBrowserInstall(selectedPlugin->name);
-            g_needsRefresh = true;
-        }
+    if (IsKeyPressed(KEY_SPACE) && selectedPlugin) {
+        ToggleMark(selectedPlugin->name);
     }
-    if ((IsKeyPressed(KEY_DELETE) || IsKeyPressed(KEY_BACKSPACE)) && selectedPlugin && !isBusy) {
-        if (selectedPlugin->remotePath[0] != '\0' && SshGetStatus() == SSH_STATUS_CONNECTED) {
-            g_uninstallBtnPress = 1.0f;
-            strncpy(g_lastOpPlugin, selectedPlugin->name, sizeof(g_lastOpPlugin) - 1);
-            g_lastOpType = OP_UNINSTALLING;
-            g_lastOpComplete = false;
-            PluginBrowserUninstall(selectedPlugin->name);
-            g_needsRefresh = true;
-        }
+    if (IsKeyPressed(KEY_ENTER)) {
+        QueueTargets(selectedPlugin, true);
+    }
+    if (IsKeyPressed(KEY_DELETE) || IsKeyPressed(KEY_BACKSPACE)) {
+        QueueTargets(selectedPlugin, false);
     }
 
     // Mouse click selection in sidebar
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && mouseInSidebar && !isBusy) {
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && mouseInSidebar) {
+        bool ctrl = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
         float adjustedMouseY = mouse.y - SIDEBAR_CONTENT_TOP + g_scrollOffset;
 
-        for (int section = 0; section < 3; section++) {
-            Rectangle sectionRect = g_sectionRects[section];
-            if (adjustedMouseY >= sectionRect.y && adjustedMouseY < sectionRect.y + sectionRect.height) {
-                // Click is in this section, find which item
-                float itemY = sectionRect.y + 24;  // After section header
-                int count = GetSectionCount(plugins, section);
-
-                // Skip "(none)" text if empty
-                if (count == 0) break;
-
-                for (int i = 0; i < count; i++) {
-                    float itemTop = itemY;
-                    float itemBottom = itemY + SIDEBAR_ITEM_HEIGHT;
-                    if (adjustedMouseY >= itemTop && adjustedMouseY < itemBottom) {
-                        g_selection.section = section;
-                        g_selection.index = i;
-
-                        // Start drag
-                        const PluginInfo *p = GetPluginInSection(plugins, section, i);
-                        if (p) {
-                            g_drag.isDragging = true;
-                            strncpy(g_drag.pluginName, p->name, sizeof(g_drag.pluginName) - 1);
-                            g_drag.sourceSection = section;
-                            g_drag.startPos = mouse;
-                            g_drag.dragTime = 0;
-                        }
-                        break;
-                    }
-                    itemY += SIDEBAR_ITEM_HEIGHT + SIDEBAR_ITEM_SPACING;
-                }
-                break;
+        int row;
+        int section = HitTestSidebar(adjustedMouseY, &row);
+        const PluginInfo *p = (section >= 0 && row >= 0) ? GetPluginInSection(plugins, section, row) : NULL;
+        if (p) {
+            g_selection.section = section;
+            g_selection.index = row;
+
+            if (ctrl) {
+                // Ctrl+Click marks without starting a drag
+                ToggleMark(p->name);
+            } else {
+                // Plain click on an unmarked row starts over with a single
+                // selection; on a marked one it picks up the whole set
+                if (!IsMarked(p->name)) ClearMarks();
+
+                // Start drag
+                g_drag.isDragging = true;
+                strncpy(g_drag.pluginName, p->name, sizeof(g_drag.pluginName) - 1);
+                g_drag.sourceSection = section;
+                g_drag.startPos = mouse;
+                g_drag.dragTime = 0;
+                HintInstall(p, true);
             }
         }
     }
 
     // Mouse click on main panel buttons (use stored button rectangles from DrawMainPanel)
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && selectedPlugin && !isBusy && mouse.x >= PANEL_START_X) {
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && mouse.x >= PANEL_START_X) {
         if (CheckCollisionPointRec(mouse, g_installBtn)) {
-            if (selectedPlugin->localPath[0] != '\0' && selectedPlugin->remotePath[0] == '\0' &&
-                SshGetStatus() == SSH_STATUS_CONNECTED) {
-                printf("Salamander: Installing %s (button click)\n", selectedPlugin->name);
-                g_installBtnPress = 1.0f;  // Trigger press animation
-                strncpy(g_lastOpPlugin, selectedPlugin->name, sizeof(g_lastOpPlugin) - 1);
-                g_lastOpType = OP_INSTALLING;
-                g_lastOpComplete = false;
-                PluginBrowserInstall(selectedPlugin->name);
-                g_needsRefresh = true;
-            }
+            QueueTargets(selectedPlugin, true);
         } else if (CheckCollisionPointRec(mouse, g_uninstallBtn)) {
-            if (selectedPlugin->remotePath[0] != '\0' && SshGetStatus() == SSH_STATUS_CONNECTED) {
-                printf("Salamander: Uninstalling %s (button click)\n", selectedPlugin->name);
-                g_uninstallBtnPress = 1.0f;  // Trigger press animation
-                strncpy(g_lastOpPlugin, selectedPlugin->name, sizeof(g_lastOpPlugin) - 1);
-                g_lastOpType = OP_UNINSTALLING;
-                g_lastOpComplete = false;
-                PluginBrowserUninstall(selectedPlugin->name);
-                g_needsRefresh = true;
-            }
+            QueueTargets(selectedPlugin, false);
         }
     }
 
@@ -1279,33 +1701,21 @@ static void HandleInput(const PluginList *plugins) {
 
         // Handle drop
         if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
-            if (mouseInSidebar && !isBusy && SshGetStatus() == SSH_STATUS_CONNECTED) {
+            if (mouseInSidebar && SshGetStatus() == SSH_STATUS_CONNECTED) {
                 float adjustedMouseY = mouse.y - SIDEBAR_CONTENT_TOP + g_scrollOffset;
 
-                for (int section = 0; section < 3; section++) {
-                    Rectangle sectionRect = g_sectionRects[section];
-                    if (adjustedMouseY >= sectionRect.y && adjustedMouseY < sectionRect.y + sectionRect.height) {
-                        if (g_drag.sourceSection == SECTION_LOCAL_ONLY &&
-                            (section == SECTION_DEVICE_ONLY || section == SECTION_SYNCED)) {
-                            printf("Salamander: Installing %s (dragged to device)\n", g_drag.pluginName);
-                            g_installBtnPress = 1.0f;
-                            strncpy(g_lastOpPlugin, g_drag.pluginName, sizeof(g_lastOpPlugin) - 1);
-                            g_lastOpType = OP_INSTALLING;
-                            g_lastOpComplete = false;
-                            PluginBrowserInstall(g_drag.pluginName);
-                            g_needsRefresh = true;
-                        } else if ((g_drag.sourceSection == SECTION_SYNCED || g_drag.sourceSection == SECTION_DEVICE_ONLY) &&
-                                   section == SECTION_LOCAL_ONLY) {
-                            printf("Salamander: Uninstalling %s (dragged to local)\n", g_drag.pluginName);
-                            g_uninstallBtnPress = 1.0f;
-                            strncpy(g_lastOpPlugin, g_drag.pluginName, sizeof(g_lastOpPlugin) - 1);
-                            g_lastOpType = OP_UNINSTALLING;
-                            g_lastOpComplete = false;
-                            PluginBrowserUninstall(g_drag.pluginName);
-                            g_needsRefresh = true;
-                        }
-                        break;
-                    }
+                int row;
+                int section = HitTestSidebar(adjustedMouseY, &row);
+                if (g_drag.sourceSection == SECTION_LOCAL_ONLY &&
+                    (section == SECTION_DEVICE_ONLY || section == SECTION_SYNCED)) {
+                    printf("Salamander: Installing %s (dragged to device)\n", g_drag.pluginName);
+                    const PluginInfo *p = PluginBrowserFindPlugin(g_drag.pluginName);
+                    QueueTargets(IsMarked(g_drag.pluginName) ? NULL : p, true);
+                } else if ((g_drag.sourceSection == SECTION_SYNCED || g_drag.sourceSection == SECTION_DEVICE_ONLY) &&
+                           section == SECTION_LOCAL_ONLY) {
+                    printf("Salamander: Uninstalling %s (dragged to local)\n", g_drag.pluginName);
+                    const PluginInfo *p = PluginBrowserFindPlugin(g_drag.pluginName);
+                    QueueTargets(IsMarked(g_drag.pluginName) ? NULL : p, false);
                 }
             }
             g_drag.isDragging = false;
@@ -1318,18 +1728,94 @@ static void HandleInput(const PluginList *plugins) {
 // ============================================================================
 
 int main(int argc, char *argv[]) {
+    g_startTime = MonotonicSeconds();
+
     const char *localPath = "../../../build-armv7-drm";
-    if (argc > 1) {
-        localPath = argv[1];
+    int streams = PLUGIN_DEFAULT_STREAMS;
+    SshCompressMode compress = SSH_COMPRESS_AUTO;
+    bool autoPush = false;
+    PluginReloadMode reload = PLUGIN_RELOAD_HOT;
+    const char *agentPath = NULL;
+    FleetOptions fleet = {0};
+    DeployOptions deploy = {0};
+    const char *tracePath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--streams") == 0 && i + 1 < argc) {
+            streams = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compress") == 0 && i + 1 < argc) {
+            const char *mode = argv[++i];
+            compress = strcmp(mode, "on") == 0 ? SSH_COMPRESS_ON
+                     : strcmp(mode, "off") == 0 ? SSH_COMPRESS_OFF : SSH_COMPRESS_AUTO;
+        } else if (strcmp(argv[i], "--low-power") == 0) {
+            g_lowPower = true;
+        } else if (strcmp(argv[i], "--auto-push") == 0) {
+            autoPush = true;
+        } else if (strcmp(argv[i], "--reload") == 0 && i + 1 < argc) {
+            reload = strcmp(argv[++i], "restart") == 0 ? PLUGIN_RELOAD_RESTART : PLUGIN_RELOAD_HOT;
+        } else if (strcmp(argv[i], "--agent") == 0 && i + 1 < argc) {
+            agentPath = argv[++i];
+        } else if (strcmp(argv[i], "--no-elf-check") == 0) {
+            PluginBrowserSetElfChecks(false);
+        } else if (strcmp(argv[i], "--remote-hash") == 0) {
+            PluginBrowserSetRemoteHashing(true);
+        } else if (strcmp(argv[i], "--fleet") == 0 && i + 1 < argc) {
+            fleet.deviceFile = argv[++i];
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            fleet.jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--push") == 0) {
+            fleet.push = true;
+        } else if (strcmp(argv[i], "--sync") == 0 && i + 1 < argc) {
+            deploy.localDir = argv[++i];
+        } else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            deploy.host = argv[++i];
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            deploy.dryRun = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--prestage") == 0 && i + 1 < argc) {
+            const char *mode = argv[++i];
+            PrestageSetMode(strcmp(mode, "upload") == 0 ? PRESTAGE_UPLOAD
+                          : strcmp(mode, "local") == 0 ? PRESTAGE_LOCAL : PRESTAGE_OFF);
+        } else {
+            localPath = argv[i];
+        }
+    }
+
+    if (tracePath) TraceStart(tracePath);
+    TraceNameThread("main");
+
+    // Sync and fleet modes are headless: no window, no font
+    SshSetAgentBinary(agentPath);
+    PluginBrowserSetReloadMode(reload);
+    fleet.restart = (reload == PLUGIN_RELOAD_RESTART);
+    if (deploy.localDir) {
+        deploy.streams = streams;
+        SshSetCompression(compress);
+        int code = DeployRun(&deploy);
+        TraceStop();
+        return code;
+    }
+    if (fleet.deviceFile) {
+        fleet.localDir = localPath;
+        SshSetCompression(compress);
+        int code = FleetRun(&fleet);
+        TraceStop();
+        return code;
     }
 
+    LoadAppFont();
     SetConfigFlags(FLAG_MSAA_4X_HINT);
     InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Salamander - Plugin Manager");
     SetTargetFPS(TARGET_FPS);
-    LoadAppFont();
+    g_font = GetFontDefault();
+    LoadGlowTextures();
 
     SshInit(NULL, NULL, NULL);
+    SshSetCompression(compress);
     PluginBrowserInit(localPath);
+    PluginBrowserSetStreams(streams);
+    PluginBrowserSetAutoPush(autoPush);
+    PluginBrowserSetWatching(true);
 
     char absPath[512] = {0};
     if (realpath(localPath, absPath)) {
@@ -1339,65 +1825,120 @@ int main(int argc, char *argv[]) {
     }
     printf("Salamander: Will connect to CarThing at %s\n", SshGetHost());
 
-    SshCheckConnection();
+    // Probes run on the monitor thread; the frame loop only reads the status
+    SshMonitorStart(5.0f);
+
+    if (g_lowPower) {
+        printf("Salamander: Low-power mode, %d FPS when idle\n", IDLE_FPS);
+    }
 
+    bool firstFrame = true;
     while (!WindowShouldClose()) {
+        uint64_t frameStart = TraceBegin();
         float deltaTime = GetFrameTime();
         g_animTime += deltaTime;
 
+        uint64_t phaseStart = TraceBegin();
+        bool fontChanged = PollAppFont();
+
         // Update animations
         UpdateScroll(deltaTime);
         UpdateButtonAnimations(deltaTime);
         UpdateToast(deltaTime);
+        UpdatePerfOverlay(deltaTime);
 
-        // Check for operation completion and show toast
-        const PluginOpState *opState = PluginBrowserGetOpState();
-        if (!g_lastOpComplete && opState->complete && g_lastOpPlugin[0] != '\0') {
-            g_lastOpComplete = true;
-            g_lastOpSuccess = opState->success;
-            ShowToast(g_lastOpPlugin, opState->success, g_lastOpType == OP_INSTALLING);
+        // One toast per finished item in the batch
+        PluginOpResult result;
+        while (PluginBrowserPollResult(&result)) {
+            ShowToast(result.pluginName, result.success, result.operation == OP_INSTALLING);
         }
 
-        // Periodic connection check
-        g_connectionCheckTimer += deltaTime;
-        if (g_connectionCheckTimer >= 5.0f) {
-            SshCheckConnection();
-            g_connectionCheckTimer = 0.0f;
+        // Rescan when the device comes or goes
+        SshConnectionStatus status = SshGetStatus();
+        bool statusChanged = status != g_lastStatus;
+        if (statusChanged) {
+            // Going straight to disconnected also rescans, so cached device
+            // entries from the last session don't linger
+            if (status == SSH_STATUS_CONNECTED || g_lastStatus == SSH_STATUS_CONNECTED ||
+                status == SSH_STATUS_DISCONNECTED) {
+                g_needsRefresh = true;
+            }
+            g_lastStatus = status;
         }
 
-        // Refresh plugins
+        // Refresh plugins (scans run in the background)
         if (g_needsRefresh && !PluginBrowserIsBusy()) {
             PluginBrowserRefresh();
             g_needsRefresh = false;
+        }
 
-            int count = GetSectionCount(PluginBrowserGetList(), g_selection.section);
+        TraceEnd("Update", TRACE_CAT_UI, phaseStart);
+
+        // Pick up whatever the refresh worker has published
+        phaseStart = TraceBegin();
+        bool listChanged = PluginBrowserUpdate();
+        UpdateSidebarLayout();
+        if (listChanged) {
+            int count = GetSectionCount(g_selection.section);
             if (g_selection.index >= count) {
                 g_selection.index = count > 0 ? count - 1 : 0;
             }
         }
+        TraceEnd("List update", TRACE_CAT_UI, phaseStart);
 
+        phaseStart = TraceBegin();
         const PluginList *plugins = PluginBrowserGetList();
         HandleInput(plugins);
+        UpdateFrameRate(HasActivity(listChanged || statusChanged || fontChanged), deltaTime);
+        TraceEnd("Input", TRACE_CAT_UI, phaseStart);
 
         const PluginInfo *selectedPlugin = GetSelectedPlugin(plugins);
+        if (listChanged) g_prestageHinted[0] = '\0';
+        HintInstall(selectedPlugin, false);
 
         BeginDrawing();
         ClearBackground(COLOR_CHARCOAL_DARK);
 
+        phaseStart = TraceBegin();
         DrawBackground();
         DrawEmberGlow(g_animTime);
+        TraceEnd("DrawBackground", TRACE_CAT_UI, phaseStart);
+        phaseStart = TraceBegin();
         DrawHeader();
+        TraceEnd("DrawHeader", TRACE_CAT_UI, phaseStart);
+        phaseStart = TraceBegin();
         DrawSidebar(plugins, deltaTime);
+        TraceEnd("DrawSidebar", TRACE_CAT_UI, phaseStart);
+        phaseStart = TraceBegin();
         DrawMainPanel(selectedPlugin);
+        TraceEnd("DrawMainPanel", TRACE_CAT_UI, phaseStart);
+        phaseStart = TraceBegin();
         DrawFooter();
         DrawDragGhost();
         DrawToast();
+        DrawPerfOverlay();
+        TraceEnd("DrawOverlays", TRACE_CAT_UI, phaseStart);
 
+        // Includes the wait for the frame limiter / vsync
+        phaseStart = TraceBegin();
         EndDrawing();
+        TraceEnd("Present", TRACE_CAT_UI, phaseStart);
+        TextCacheNextFrame();
+        TraceEnd("Frame", TRACE_CAT_FRAME, frameStart);
+
+        if (firstFrame) {
+            printf("Salamander: First frame after %.0f ms\n", (MonotonicSeconds() - g_startTime) * 1000.0);
+            firstFrame = false;
+        }
     }
 
+    ClearMarks();
+    free(g_marked);
     PluginBrowserShutdown();
     SshShutdown();
+    TraceStop();
+    UnloadGlowTextures();
+    TextCacheClear();
     UnloadAppFont();
     CloseWindow();
 
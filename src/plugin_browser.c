@@ -1,54 +1,172 @@
 #include "plugin_browser.h"
+#include "plugin_cache.h"
+#include "dir_watcher.h"
 #include "ssh_manager.h"
+#include "sha256.h"
+#include "file_hasher.h"
+#include "elf_check.h"
+#include "prestage.h"
+#include "trace.h"
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <ctype.h>
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <time.h>
 
 // ============================================================================
 // Plugin Browser Implementation
 // ============================================================================
 
 static char g_localPath[512] = "";
-static PluginList g_plugins = {0};
+
+// Operation state. Writers update g_opState under g_opMutex (via
+// LockOpState/UnlockOpState); every unlock publishes a copy behind a
+// seqlock, which the UI reads without locking and never blocks a writer.
 static PluginOpState g_opState = {0};
+static pthread_mutex_t g_opMutex = PTHREAD_MUTEX_INITIALIZER;
+static PluginOpState g_opPublished = {0};
+static unsigned int g_opSeq = 0;            // Odd while a copy is in progress
+static PluginOpState g_opSnapshot = {0};    // UI thread only
+
+// Plugin list snapshots (triple buffered)
+// The refresh worker builds into g_scanList, copies it to g_backList and
+// swaps that into the pending slot. The UI swaps pending into front in
+// PluginBrowserUpdate, so it only ever sees complete lists.
+static PluginList g_listBuffers[3];
+static PluginList *g_frontList = &g_listBuffers[0];    // UI thread only
+static PluginList *g_pendingList = &g_listBuffers[1];  // Guarded by g_listMutex
+static PluginList *g_backList = &g_listBuffers[2];     // Refresh worker only
+static bool g_pendingReady = false;
+static pthread_mutex_t g_listMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Section index over g_frontList (UI thread only)
+static PluginSectionView g_sectionView = {0};
+static void RebuildSectionView(void);
+
+// Refresh worker state (flags guarded by g_listMutex; g_refreshRunning is
+// also stored atomically for unlocked reads)
+static PluginList g_scanList = {0};
+static PluginList g_prevScan = {0};
+static bool g_refreshRunning = false;
+static bool g_refreshQueued = false;
+static bool g_remoteHashing = false;  // Set before Init
+static bool g_elfChecks = true;         // Set before Init
+static bool g_inventoryCache = true;    // Set before Init
+static uint64_t g_publishedDigest = 0;  // Contents of the last published snapshot
+static SshBuffer g_inventoryOutput = {0};   // Device listing, kept between scans
+
+// Inventory cache (refresh worker only once Init returns). g_knownDevice is
+// the last device inventory seen, kept across passes where the device was
+// away so the cache can still describe it.
+static char g_cachePath[1024] = "";
+static PluginList g_knownDevice = {0};
+static PluginList g_cacheList = {0};
+static char g_deviceId[PLUGIN_CACHE_ID_MAX] = "";
+static bool g_deviceScanned = false;    // Last full pass listed the device
+static uint64_t g_savedDigest = 0;
+static void LoadInventoryCache(void);
+
+// Local directory watcher. Changed plugin names queue up for the refresh
+// worker, which applies them to g_scanList without a full rescan; names to
+// auto-push are handed back to the UI thread. Guarded by g_listMutex.
+static bool g_watching = false;
+static bool g_autoPush = false;
+static char g_changedNames[PLUGIN_QUEUE_SIZE][PLUGIN_NAME_MAX];
+static int g_changedCount = 0;
+static char g_pushNames[PLUGIN_QUEUE_SIZE][PLUGIN_NAME_MAX];
+static int g_pushCount = 0;
+static bool StartRefreshWorker(bool full);
+
+// Batch executor: install/uninstall requests queue up and one worker thread
+// runs them with a single remount/sync/reload cycle per batch
+typedef struct {
+    PluginOperation operation;  // OP_INSTALLING or OP_UNINSTALLING
+    char pluginName[PLUGIN_NAME_MAX];
+    char *localPath;            // Heap copies owned by the queue entry
+    char *remotePath;
+    bool isUpdate;              // Device already has a (stale) copy
+    bool succeeded;             // Set by the install stream that ran it
+} QueuedOp;
+
+static QueuedOp g_queue[PLUGIN_QUEUE_SIZE];
+static int g_queueHead = 0;
+// Count and running flag are stored atomically so the UI can read them
+// without taking the queue lock
+static int g_queueCount = 0;
+static bool g_batchRunning = false;
+static pthread_mutex_t g_queueMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Per-item results waiting for the UI: one single-producer ring per thread
+// that reports them (install stream slots, with slot 0 on the batch thread
+// also reporting uninstalls, plus one for the UI thread itself), so pushing
+// and polling need no lock. head and tail only ever grow.
+#define RESULT_RING_SIZE 64            // Power of two
+#define RESULT_RING_UI PLUGIN_MAX_STREAMS
+
+typedef struct {
+    PluginOpResult items[RESULT_RING_SIZE];
+    unsigned int head;                  // Next to read (UI only)
+    unsigned int tail;                  // Next to write (producer only)
+} ResultRing;
+
+static ResultRing g_resultRings[PLUGIN_MAX_STREAMS + 1];
+static char g_lastResultMessage[PLUGIN_MESSAGE_MAX] = {0};  // Guarded by g_opMutex
+
+// Batch progress (guarded by g_opMutex while install streams run)
+static int g_batchTotal = 0;
+static int g_batchDone = 0;
+static int g_streamLimit = PLUGIN_DEFAULT_STREAMS;
+
+// Installs taken off the queue for the current run (batch thread only)
+static QueuedOp g_runOps[PLUGIN_QUEUE_SIZE];
+
+// How changes reach llizardgui-host, and the hot reload requests collected
+// for the current batch (batch thread only)
+static PluginReloadMode g_reloadMode = PLUGIN_RELOAD_HOT;
+static char g_reloadLines[PLUGIN_QUEUE_SIZE][PLUGIN_NAME_MAX + 8];
+static int g_reloadCount = 0;
+static bool g_reloadMissed = false;     // A flush this batch didn't reach the host
+
+// Shared by the install streams of one run
+typedef struct {
+    QueuedOp *ops;
+    int count;
+    int next;        // Next op to hand out (guarded by g_opMutex)
+    int succeeded;
+    int failed;
+} InstallRun;
+
+typedef struct {
+    InstallRun *run;
+    int slot;        // Index into g_opState.streams
+} InstallStream;
+
+static void LockOpState(void) {
+    pthread_mutex_lock(&g_opMutex);
+}
 
-// Threading for async operations
-static pthread_t g_workerThread;
-static bool g_threadRunning = false;
-static char g_pendingPluginName[64] = "";
-static char g_pendingLocalPath[512] = "";
-static char g_pendingRemotePath[512] = "";
-
-// Convert filename to display name (nowplaying.so -> Now Playing)
-static void MakeDisplayName(const char *filename, char *display, size_t maxLen) {
-    // Remove .so extension
-    char base[64];
-    strncpy(base, filename, sizeof(base) - 1);
-    char *dot = strrchr(base, '.');
-    if (dot) *dot = '\0';
+// Publish the working state, then release it. The mutex serializes writers,
+// so only readers have to cope with an odd sequence.
+static void UnlockOpState(void) {
+    __atomic_store_n(&g_opSeq, g_opSeq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&g_opPublished, &g_opState, sizeof(g_opState));
+    __atomic_store_n(&g_opSeq, g_opSeq + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_opMutex);
+}
 
-    // Convert underscores to spaces and capitalize words
-    size_t outIdx = 0;
-    bool capitalizeNext = true;
-
-    for (size_t i = 0; base[i] && outIdx < maxLen - 1; i++) {
-        char c = base[i];
-        if (c == '_') {
-            display[outIdx++] = ' ';
-            capitalizeNext = true;
-        } else if (capitalizeNext && isalpha(c)) {
-            display[outIdx++] = (char)toupper(c);
-            capitalizeNext = false;
-        } else {
-            display[outIdx++] = c;
-            capitalizeNext = false;
-        }
-    }
-    display[outIdx] = '\0';
+// Set the status line from the UI thread (e.g. why a request was refused)
+static void SetOpMessage(const char *message) {
+    LockOpState();
+    snprintf(g_opState.message, sizeof(g_opState.message), "%s", message);
+    UnlockOpState();
 }
 
 // Extract plugin name from path (removes directory and .so extension)
@@ -64,21 +182,59 @@ static void ExtractPluginName(const char *path, char *name, size_t maxLen) {
 }
 
 void PluginBrowserInit(const char *localPluginDir) {
-    memset(&g_plugins, 0, sizeof(g_plugins));
+    for (int i = 0; i < 3; i++) {
+        PluginListReset(&g_listBuffers[i]);
+    }
+    PluginListReset(&g_scanList);
+    PluginListReset(&g_prevScan);
+    RebuildSectionView();
+    LockOpState();
     memset(&g_opState, 0, sizeof(g_opState));
+    UnlockOpState();
+    g_pendingReady = false;
 
     if (localPluginDir) {
         strncpy(g_localPath, localPluginDir, sizeof(g_localPath) - 1);
     }
+
+    // Show the last known inventory until the first refresh revalidates it
+    g_cachePath[0] = '\0';
+    if (g_inventoryCache && PluginCacheDefaultPath(g_cachePath, sizeof(g_cachePath))) {
+        LoadInventoryCache();
+    }
 }
 
 void PluginBrowserShutdown(void) {
-    memset(&g_plugins, 0, sizeof(g_plugins));
+    PrestageShutdown();
+    DirWatcherStop();
+    g_watching = false;
+
+    // Let an in-flight refresh finish before the buffers go away
+    while (PluginBrowserIsRefreshing()) {
+        usleep(10000);
+    }
+    for (int i = 0; i < 3; i++) {
+        PluginListFree(&g_listBuffers[i]);
+    }
+    PluginListFree(&g_scanList);
+    PluginListFree(&g_prevScan);
+    PluginListFree(&g_knownDevice);
+    PluginListFree(&g_cacheList);
+    SshBufferFree(&g_inventoryOutput);
+    FileHasherClear();
+    for (int s = 0; s < 3; s++) {
+        free(g_sectionView.sections[s].slots);
+    }
+    memset(&g_sectionView, 0, sizeof(g_sectionView));
 }
 
 void PluginBrowserSetLocalPath(const char *path) {
     if (path) {
         strncpy(g_localPath, path, sizeof(g_localPath) - 1);
+        if (g_watching) {
+            PluginBrowserSetWatching(false);
+            PluginBrowserSetWatching(true);
+        }
     }
 }
 
@@ -86,394 +242,1381 @@ const char *PluginBrowserGetLocalPath(void) {
     return g_localPath;
 }
 
-// Find or create plugin entry by name
-static PluginInfo *FindOrCreatePlugin(const char *name) {
-    // First try to find existing
-    for (int i = 0; i < g_plugins.count; i++) {
-        if (strcmp(g_plugins.plugins[i].name, name) == 0) {
-            return &g_plugins.plugins[i];
+void PluginBrowserSetRemoteHashing(bool enabled) {
+    g_remoteHashing = enabled;
+}
+
+void PluginBrowserSetInventoryCache(bool enabled) {
+    g_inventoryCache = enabled;
+}
+
+void PluginBrowserSetElfChecks(bool enabled) {
+    g_elfChecks = enabled;
+}
+
+// Derive status from which sides the plugin was found on, and sync state
+// from the content hashes (sizes when the device didn't send hashes)
+static void UpdatePluginStatus(PluginInfo *p) {
+    if (p->remotePath[0] == '\0') {
+        p->status = PLUGIN_LOCAL_ONLY;
+    } else if (p->localPath[0] != '\0') {
+        p->status = PLUGIN_INSTALLED;
+    } else {
+        p->status = PLUGIN_DEVICE_ONLY;
+    }
+
+    p->syncState = PLUGIN_SYNC_UNKNOWN;
+    if (p->status == PLUGIN_INSTALLED) {
+        if (p->detail->localHash[0] != '\0' && p->detail->remoteHash[0] != '\0') {
+            p->syncState = (strcmp(p->detail->localHash, p->detail->remoteHash) == 0) ?
+                           PLUGIN_SYNC_UP_TO_DATE : PLUGIN_SYNC_STALE;
+        } else if (p->localSize != p->remoteSize) {
+            p->syncState = PLUGIN_SYNC_STALE;
         }
     }
+}
 
-    // Create new if space available
-    if (g_plugins.count < MAX_PLUGINS) {
-        PluginInfo *p = &g_plugins.plugins[g_plugins.count++];
-        memset(p, 0, sizeof(*p));
-        strncpy(p->name, name, sizeof(p->name) - 1);
-        MakeDisplayName(name, p->displayName, sizeof(p->displayName));
-        p->status = PLUGIN_LOCAL_ONLY;
-        return p;
+// Copy remote-side fields from src into dst (creating device-only entries)
+static void MergeRemoteInfo(PluginList *dst, const PluginList *src) {
+    TRACE_SCOPE("Merge", TRACE_CAT_LOCAL);
+    for (int i = 0; i < src->count; i++) {
+        const PluginInfo *from = &src->plugins[i];
+        if (from->remotePath[0] == '\0') continue;
+
+        PluginInfo *to = PluginListFindOrAdd(dst, from->name);
+        if (to) {
+            to->remotePath = PluginListIntern(dst, from->remotePath);
+            to->remoteSize = from->remoteSize;
+            to->remoteMtime = from->remoteMtime;
+            memcpy(to->detail->remoteHash, from->detail->remoteHash, sizeof(to->detail->remoteHash));
+            UpdatePluginStatus(to);
+        }
     }
+}
 
-    return NULL;
+static bool ClearRemoteFields(PluginInfo *p) {
+    if (p->localPath[0] == '\0') return false;
+
+    p->remotePath = "";
+    p->remoteSize = 0;
+    p->remoteMtime = 0;
+    p->detail->remoteHash[0] = '\0';
+    UpdatePluginStatus(p);
+    return true;
 }
 
-// Scan local directory for .so files
-static void ScanLocalPlugins(void) {
-    if (g_localPath[0] == '\0') {
-        printf("Plugins: No local path configured\n");
+// Drop all remote-side fields, removing entries that only existed remotely
+static void ClearRemoteInfo(PluginList *list) {
+    PluginListFilter(list, ClearRemoteFields);
+}
+
+static bool ClearLocalFields(PluginInfo *p) {
+    if (p->remotePath[0] == '\0') return false;
+
+    p->localPath = "";
+    p->localSize = 0;
+    p->localMtime = 0;
+    p->detail->localHash[0] = '\0';
+    memset(&p->detail->elf, 0, sizeof(p->detail->elf));
+    UpdatePluginStatus(p);
+    return true;
+}
+
+// FNV-1a over everything the UI shows, to spot passes that changed nothing
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t ListDigest(const PluginList *list) {
+    uint64_t hash = HashBytes(14695981039346656037ull, &list->count, sizeof(list->count));
+    for (int i = 0; i < list->count; i++) {
+        const PluginInfo *p = &list->plugins[i];
+        // Terminators included so field boundaries can't shift
+        hash = HashBytes(hash, p->name, strlen(p->name) + 1);
+        hash = HashBytes(hash, p->localPath, strlen(p->localPath) + 1);
+        hash = HashBytes(hash, p->remotePath, strlen(p->remotePath) + 1);
+        hash = HashBytes(hash, p->detail->localHash, strlen(p->detail->localHash) + 1);
+        hash = HashBytes(hash, p->detail->remoteHash, strlen(p->detail->remoteHash) + 1);
+        long numbers[4] = {p->localSize, p->remoteSize, p->localMtime, p->remoteMtime};
+        int states[3] = {p->status, p->syncState, p->detail->elf.state};
+        hash = HashBytes(hash, numbers, sizeof(numbers));
+        hash = HashBytes(hash, states, sizeof(states));
+    }
+    return hash;
+}
+
+// Hand the current scan state to the UI as a complete snapshot
+// Passes that found exactly what is already shown publish nothing, so the
+// UI keeps its list (and section index) untouched.
+static void PublishScanList(void) {
+    TRACE_SCOPE("Publish", TRACE_CAT_LOCAL);
+    uint64_t digest = ListDigest(&g_scanList);
+    if (digest == g_publishedDigest) return;
+    g_publishedDigest = digest;
+
+    PluginListCopy(g_backList, &g_scanList);
+
+    // Format display strings here rather than every frame in the UI
+    for (int i = 0; i < g_backList->count; i++) {
+        PluginInfo *p = &g_backList->plugins[i];
+        FormatFileSize(p->localSize, p->detail->localSizeText, sizeof(p->detail->localSizeText));
+        FormatFileSize(p->remoteSize, p->detail->remoteSizeText, sizeof(p->detail->remoteSizeText));
+    }
+
+    pthread_mutex_lock(&g_listMutex);
+    PluginList *tmp = g_pendingList;
+    g_pendingList = g_backList;
+    g_backList = tmp;
+    g_pendingReady = true;
+    pthread_mutex_unlock(&g_listMutex);
+}
+
+// ============================================================================
+// Inventory Cache
+// ============================================================================
+
+static void LoadInventoryCache(void) {
+    PluginCacheMeta meta;
+    if (!PluginCacheLoad(g_cachePath, &g_scanList, &meta)) return;
+
+    // Device side from another address can't be trusted; local side from
+    // another build directory neither
+    if (strcmp(meta.host, SshGetHost()) != 0) {
+        ClearRemoteInfo(&g_scanList);
+    } else {
+        PluginListCopy(&g_knownDevice, &g_scanList);
+        snprintf(g_deviceId, sizeof(g_deviceId), "%s", meta.deviceId);
+    }
+    if (strcmp(meta.localDir, g_localPath) != 0) {
+        PluginListFilter(&g_scanList, ClearLocalFields);
+    }
+    g_savedDigest = ListDigest(&g_scanList);
+
+    printf("Plugins: Loaded %d cached plugins from %s\n", g_scanList.count, g_cachePath);
+    PublishScanList();
+}
+
+// Persist this pass: local results plus the latest device inventory known
+static void SaveInventoryCache(bool remoteScanned) {
+    if (g_cachePath[0] == '\0') return;
+    TRACE_SCOPE("Cache save", TRACE_CAT_LOCAL);
+
+    if (remoteScanned) {
+        PluginListCopy(&g_knownDevice, &g_scanList);
+        PluginListCopy(&g_cacheList, &g_scanList);
+    } else {
+        PluginListCopy(&g_cacheList, &g_scanList);
+        ClearRemoteInfo(&g_cacheList);
+        MergeRemoteInfo(&g_cacheList, &g_knownDevice);
+    }
+
+    uint64_t digest = ListDigest(&g_cacheList);
+    if (digest == g_savedDigest) return;
+
+    PluginCacheMeta meta;
+    memset(&meta, 0, sizeof(meta));
+    snprintf(meta.localDir, sizeof(meta.localDir), "%s", g_localPath);
+    snprintf(meta.host, sizeof(meta.host), "%s", SshGetHost());
+    snprintf(meta.deviceId, sizeof(meta.deviceId), "%s", g_deviceId);
+    if (PluginCacheSave(g_cachePath, &g_cacheList, &meta)) {
+        g_savedDigest = digest;
+    }
+}
+
+// Validate a local build's ELF headers, reusing last's verdict when it
+// describes the same file
+static void CheckLocalBuild(PluginInfo *plugin, const PluginInfo *last) {
+    if (!g_elfChecks) {
+        memset(&plugin->detail->elf, 0, sizeof(plugin->detail->elf));
+        return;
+    }
+    if (last && last->detail->elf.state != ELF_UNCHECKED) {
+        plugin->detail->elf = last->detail->elf;
         return;
     }
+    if (!ElfCheckFile(plugin->localPath, &plugin->detail->elf)) {
+        printf("Plugins:   %s rejected: %s\n", plugin->name, plugin->detail->elf.error);
+    }
+}
 
-    printf("Plugins: Scanning local directory: %s\n", g_localPath);
+void PluginBrowserScanLocalDir(const char *localDir, PluginList *list, const PluginList *prev) {
+    TRACE_SCOPE("Local scan", TRACE_CAT_LOCAL);
+    printf("Plugins: Scanning local directory: %s\n", localDir);
 
-    DIR *dir = opendir(g_localPath);
+    DIR *dir = opendir(localDir);
     if (!dir) {
-        printf("Plugins: Cannot open local directory: %s\n", g_localPath);
+        printf("Plugins: Cannot open local directory: %s\n", localDir);
         printf("Plugins: (You can specify a different path as command line argument)\n");
         return;
     }
 
-    int found = 0;
+    // List first, then hash everything in one parallel pass
+    int *found = NULL;
+    int foundCount = 0;
+    int foundCapacity = 0;
     struct dirent *entry;
     while ((entry = readdir(dir)) != NULL) {
         // Only process .so files
         size_t len = strlen(entry->d_name);
         if (len > 3 && strcmp(entry->d_name + len - 3, ".so") == 0) {
-            char name[64];
+            char name[PLUGIN_NAME_MAX];
             ExtractPluginName(entry->d_name, name, sizeof(name));
 
-            PluginInfo *plugin = FindOrCreatePlugin(name);
+            PluginInfo *plugin = PluginListFindOrAdd(list, name);
             if (plugin) {
-                snprintf(plugin->localPath, sizeof(plugin->localPath),
-                         "%s/%s", g_localPath, entry->d_name);
+                char path[1024];
+                snprintf(path, sizeof(path), "%s/%s", localDir, entry->d_name);
+                plugin->localPath = PluginListIntern(list, path);
 
                 // Get file size
                 struct stat st;
                 if (stat(plugin->localPath, &st) == 0) {
                     plugin->localSize = st.st_size;
+                    plugin->localMtime = (long)st.st_mtime;
+                }
+
+                if (foundCount == foundCapacity) {
+                    int capacity = foundCapacity ? foundCapacity * 2 : 64;
+                    int *grown = realloc(found, (size_t)capacity * sizeof(int));
+                    if (grown) {
+                        found = grown;
+                        foundCapacity = capacity;
+                    }
                 }
-                found++;
+                if (foundCount < foundCapacity) found[foundCount++] = (int)(plugin - list->plugins);
                 printf("Plugins:   Found local: %s (%ld bytes)\n", name, plugin->localSize);
             }
         }
     }
-
-    printf("Plugins: Found %d local plugins\n", found);
     closedir(dir);
+
+    FileHashJob *jobs = foundCount > 0 ? calloc((size_t)foundCount, sizeof(FileHashJob)) : NULL;
+    if (jobs) {
+        for (int i = 0; i < foundCount; i++) {
+            const PluginInfo *plugin = &list->plugins[found[i]];
+            // The last scan (possibly from the disk cache) vouches for
+            // files whose size and mtime haven't changed
+            const PluginInfo *last = prev ? PluginListFind(prev, plugin->name) : NULL;
+            jobs[i].path = plugin->localPath;
+            if (last && last->localSize == plugin->localSize && last->localMtime == plugin->localMtime) {
+                jobs[i].knownHash = last->detail->localHash;
+            } else {
+                last = NULL;
+            }
+            CheckLocalBuild(&list->plugins[found[i]], last);
+        }
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t traceStart = TraceBegin();
+        int read = FileHasherRun(jobs, foundCount);
+        TraceEndArgs("Hash", TRACE_CAT_LOCAL, traceStart, "files read", read, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        for (int i = 0; i < foundCount; i++) {
+            memcpy(list->plugins[found[i]].detail->localHash, jobs[i].hex, sizeof(jobs[i].hex));
+        }
+        if (read > 0) {
+            printf("Plugins: Hashed %d of %d local plugins in %.1f ms\n", read, foundCount,
+                   (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+        }
+    }
+    free(jobs);
+    free(found);
+
+    printf("Plugins: Found %d local plugins\n", foundCount);
+}
+
+// Scan the configured local directory
+static void ScanLocalPlugins(PluginList *list) {
+    if (g_localPath[0] == '\0') {
+        printf("Plugins: No local path configured\n");
+        return;
+    }
+    PluginBrowserScanLocalDir(g_localPath, list, &g_prevScan);
+}
+
+// Parse one inventory line ("F size mtime name" or "H hash  name") into list
+static void ParseInventoryLine(PluginList *list, char *line) {
+    char kind = line[0];
+    if ((kind != 'F' && kind != 'H') || line[1] != ' ') return;
+
+    char *rest = line + 2;
+    long size = 0, mtime = 0;
+    char hash[65] = "";
+    int consumed = 0;
+
+    if (kind == 'F') {
+        if (sscanf(rest, "%ld %ld %n", &size, &mtime, &consumed) != 2) return;
+    } else {
+        if (sscanf(rest, "%64s %n", hash, &consumed) != 1 || strlen(hash) != 64) return;
+    }
+
+    const char *filename = rest + consumed;
+    size_t len = strlen(filename);
+    if (len <= 3 || strcmp(filename + len - 3, ".so") != 0) return;
+
+    char name[PLUGIN_NAME_MAX];
+    ExtractPluginName(filename, name, sizeof(name));
+
+    PluginInfo *plugin = PluginListFindOrAdd(list, name);
+    if (!plugin) return;
+
+    if (plugin->remotePath[0] == '\0') {
+        char path[sizeof(SSH_PLUGIN_PATH) + PLUGIN_NAME_MAX + 4];
+        snprintf(path, sizeof(path), "%s/%s.so", SSH_PLUGIN_PATH, name);
+        plugin->remotePath = PluginListIntern(list, path);
+        UpdatePluginStatus(plugin);
+    }
+
+    if (kind == 'F') {
+        plugin->remoteSize = size;
+        plugin->remoteMtime = mtime;
+    } else {
+        memcpy(plugin->detail->remoteHash, hash, sizeof(plugin->detail->remoteHash));
+    }
+}
+
+// Remember which device answered ("I <machine-id>" inventory line)
+static void UpdateDeviceId(const char *id) {
+    if (strcmp(id, g_deviceId) == 0) return;
+    if (g_deviceId[0] != '\0') {
+        printf("Plugins: Different device (%s, was %s)\n", id, g_deviceId);
+    }
+    snprintf(g_deviceId, sizeof(g_deviceId), "%s", id);
+}
+
+// Scan into list, reading the listing through output (kept by the caller)
+static bool ScanDeviceInto(PluginList *list, bool withHashes, char *deviceId, size_t idSize,
+                           SshBuffer *output) {
+    TRACE_SCOPE("Device scan", TRACE_CAT_SSH);
+    if (deviceId && idSize) deviceId[0] = '\0';
+
+    SshBuffer errors = {0};
+    int exitCode = SshListInventory(SSH_PLUGIN_PATH, withHashes, output, &errors);
+    if (exitCode != 0 || !output->data) {
+        size_t len = errors.data ? strcspn(errors.data, "\n") : 0;
+        printf("Plugins: Could not list plugins on %s (exit %d): %.*s\n", SshGetHost(), exitCode,
+               (int)len, errors.data ? errors.data : "");
+        SshBufferFree(&errors);
+        return false;
+    }
+    SshBufferFree(&errors);
+
+    char *save = NULL;
+    for (char *line = strtok_r(output->data, "\n", &save); line;
+         line = strtok_r(NULL, "\n", &save)) {
+        if (line[0] == 'I' && line[1] == ' ') {
+            if (deviceId && idSize) snprintf(deviceId, idSize, "%s", line + 2);
+            continue;
+        }
+        ParseInventoryLine(list, line);
+    }
+
+    // Hashes arrive after the stat lines, so compare once everything is in
+    for (int i = 0; i < list->count; i++) {
+        UpdatePluginStatus(&list->plugins[i]);
+    }
+    return true;
 }
 
-// Scan remote device for plugins
-static void ScanRemotePlugins(void) {
+bool PluginBrowserScanDevice(PluginList *list, bool withHashes, char *deviceId, size_t idSize) {
+    SshBuffer output = {0};
+    bool ok = ScanDeviceInto(list, withHashes, deviceId, idSize, &output);
+    SshBufferFree(&output);
+    return ok;
+}
+
+// Scan remote device for plugins (single round trip)
+// Returns false if the device couldn't be listed
+static bool ScanRemotePlugins(PluginList *list) {
     if (SshGetStatus() != SSH_STATUS_CONNECTED) {
         printf("Plugins: Skipping remote scan (device not connected)\n");
-        return;
+        return false;
     }
 
     printf("Plugins: Scanning device at %s...\n", SSH_PLUGIN_PATH);
 
-    SshResult result = SshListDirectory(SSH_PLUGIN_PATH "/*.so");
-    if (!result.success) {
-        printf("Plugins: No plugins found on device (or error listing)\n");
-        return;
+    int before = list->count;
+    char deviceId[PLUGIN_CACHE_ID_MAX];
+    if (!ScanDeviceInto(list, g_remoteHashing, deviceId, sizeof(deviceId), &g_inventoryOutput)) {
+        return false;
+    }
+    if (deviceId[0] != '\0') UpdateDeviceId(deviceId);
+
+    int found = 0;
+    for (int i = 0; i < list->count; i++) {
+        if (list->plugins[i].remotePath[0] != '\0') found++;
     }
+    printf("Plugins: Found %d device plugins (%d device only)\n", found, list->count - before);
+    return true;
+}
 
-    // Parse output line by line
-    char *line = strtok(result.output, "\n");
-    while (line) {
-        // Extract just the filename
-        const char *basename = strrchr(line, '/');
-        basename = basename ? basename + 1 : line;
+// Refresh progress only lands in the op state while no install/uninstall
+// owns it
+static void SetRefreshState(float progress, bool complete, const char *message) {
+    LockOpState();
+    if (g_opState.operation == OP_REFRESHING) {
+        g_opState.progress = progress;
+        snprintf(g_opState.message, sizeof(g_opState.message), "%s", message);
+        if (complete) {
+            g_opState.operation = OP_NONE;
+            g_opState.complete = true;
+            g_opState.success = true;
+        }
+    }
+    UnlockOpState();
+}
 
-        size_t len = strlen(basename);
-        if (len > 3 && strcmp(basename + len - 3, ".so") == 0) {
-            char name[64];
-            ExtractPluginName(basename, name, sizeof(name));
+static bool HasEitherSide(PluginInfo *p) {
+    return p->localPath[0] != '\0' || p->remotePath[0] != '\0';
+}
 
-            PluginInfo *plugin = FindOrCreatePlugin(name);
-            if (plugin) {
-                snprintf(plugin->remotePath, sizeof(plugin->remotePath),
-                         "%s/%s.so", SSH_PLUGIN_PATH, name);
+// Apply watcher-reported changes to the current scan in place
+static void ApplyLocalChanges(void) {
+    TRACE_SCOPE("Watcher update", TRACE_CAT_OP);
+    static char names[PLUGIN_QUEUE_SIZE][PLUGIN_NAME_MAX];
+    pthread_mutex_lock(&g_listMutex);
+    int count = g_changedCount;
+    memcpy(names, g_changedNames, (size_t)count * sizeof(names[0]));
+    g_changedCount = 0;
+    bool autoPush = g_autoPush;
+    pthread_mutex_unlock(&g_listMutex);
+
+    bool removed = false;
+    for (int i = 0; i < count; i++) {
+        char path[sizeof(g_localPath) + PLUGIN_NAME_MAX + 4];
+        snprintf(path, sizeof(path), "%s/%s.so", g_localPath, names[i]);
+
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            PluginInfo *plugin = PluginListFind(&g_scanList, names[i]);
+            if (!plugin || plugin->localPath[0] == '\0') continue;
+            printf("Watch: %s removed\n", names[i]);
+            plugin->localPath = "";
+            plugin->localSize = 0;
+            plugin->localMtime = 0;
+            plugin->detail->localHash[0] = '\0';
+            memset(&plugin->detail->elf, 0, sizeof(plugin->detail->elf));
+            UpdatePluginStatus(plugin);
+            removed = true;
+            continue;
+        }
 
-                // Get remote file size
-                plugin->remoteSize = SshGetFileSize(plugin->remotePath);
+        PluginInfo *plugin = PluginListFindOrAdd(&g_scanList, names[i]);
+        if (!plugin) continue;
+        if (plugin->localSize == (long)st.st_size && plugin->localMtime == (long)st.st_mtime &&
+            plugin->detail->localHash[0] != '\0') {
+            continue;
+        }
 
-                // Update status based on local presence
-                if (plugin->localPath[0] != '\0') {
-                    plugin->status = PLUGIN_INSTALLED;
-                } else {
-                    plugin->status = PLUGIN_DEVICE_ONLY;
-                }
+        plugin->localPath = PluginListIntern(&g_scanList, path);
+        plugin->localSize = (long)st.st_size;
+        plugin->localMtime = (long)st.st_mtime;
+        if (!FileHasherHash(path, plugin->detail->localHash)) {
+            plugin->detail->localHash[0] = '\0';
+        }
+        CheckLocalBuild(plugin, NULL);
+        UpdatePluginStatus(plugin);
+        printf("Watch: %s changed (%ld bytes)\n", names[i], plugin->localSize);
+
+        if (autoPush && plugin->status == PLUGIN_INSTALLED && plugin->detail->elf.state != ELF_INVALID &&
+            plugin->syncState != PLUGIN_SYNC_UP_TO_DATE) {
+            pthread_mutex_lock(&g_listMutex);
+            if (g_pushCount < PLUGIN_QUEUE_SIZE) {
+                snprintf(g_pushNames[g_pushCount++], PLUGIN_NAME_MAX, "%s", names[i]);
             }
+            pthread_mutex_unlock(&g_listMutex);
+        }
+    }
+
+    // Entries that were only local are gone now
+    if (removed) {
+        PluginListFilter(&g_scanList, HasEitherSide);
+    }
+    PublishScanList();
+    SaveInventoryCache(false);
+}
+
+static void RunFullRefresh(void) {
+    TRACE_SCOPE("Refresh", TRACE_CAT_OP);
+    // A full pass covers anything the watcher reported so far
+    pthread_mutex_lock(&g_listMutex);
+    g_changedCount = 0;
+    pthread_mutex_unlock(&g_listMutex);
+
+    // Keep the last scan around so remote results survive until the
+    // device answers again
+    PluginList tmp = g_prevScan;
+    g_prevScan = g_scanList;
+    g_scanList = tmp;
+    PluginListReset(&g_scanList);
+
+    SetRefreshState(0.0f, false, "Scanning local plugins...");
+    ScanLocalPlugins(&g_scanList);
+
+    // Publish local results right away. Until the device is known to be
+    // gone, show what it had last time instead of flashing everything
+    // to LOCAL ONLY.
+    SshConnectionStatus status = SshGetStatus();
+    if (status != SSH_STATUS_DISCONNECTED) {
+        MergeRemoteInfo(&g_scanList, &g_prevScan);
+    }
+    PublishScanList();
+
+    bool remoteScanned = false;
+    if (status == SSH_STATUS_CONNECTED) {
+        SetRefreshState(0.5f, false, "Scanning device plugins...");
+        ClearRemoteInfo(&g_scanList);
+        remoteScanned = ScanRemotePlugins(&g_scanList);
+        PublishScanList();
+    }
+    g_deviceScanned = remoteScanned;
+    SaveInventoryCache(remoteScanned);
+
+    char message[64];
+    snprintf(message, sizeof(message), "Found %d plugins", g_scanList.count);
+    SetRefreshState(1.0f, true, message);
+}
+
+static void *RefreshWorkerThread(void *arg) {
+    bool full = arg != NULL;
+    TraceNameThread("refresh");
+
+    for (;;) {
+        if (full) {
+            RunFullRefresh();
+        } else {
+            ApplyLocalChanges();
         }
 
-        line = strtok(NULL, "\n");
+        // Full rescans take priority over watcher updates
+        pthread_mutex_lock(&g_listMutex);
+        if (g_refreshQueued) {
+            g_refreshQueued = false;
+            full = true;
+        } else if (g_changedCount > 0) {
+            full = false;
+        } else {
+            __atomic_store_n(&g_refreshRunning, false, __ATOMIC_RELEASE);
+            pthread_mutex_unlock(&g_listMutex);
+            break;
+        }
+        pthread_mutex_unlock(&g_listMutex);
+    }
+
+    return NULL;
+}
+
+// Caller has set g_refreshRunning
+static bool StartRefreshWorker(bool full) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, RefreshWorkerThread, full ? (void *)1 : NULL) != 0) {
+        printf("Plugins: Failed to start refresh thread\n");
+        pthread_mutex_lock(&g_listMutex);
+        __atomic_store_n(&g_refreshRunning, false, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&g_listMutex);
+        return false;
     }
+    pthread_detach(thread);
+    return true;
+}
+
+// Watcher thread: queue one changed file (NULL = rescan everything)
+static void OnLocalChange(const char *fileName, void *userData) {
+    (void)userData;
+
+    pthread_mutex_lock(&g_listMutex);
+    if (!fileName || g_changedCount == PLUGIN_QUEUE_SIZE) {
+        g_refreshQueued = true;
+    } else {
+        char name[PLUGIN_NAME_MAX];
+        ExtractPluginName(fileName, name, sizeof(name));
+        bool queued = false;
+        for (int i = 0; i < g_changedCount && !queued; i++) {
+            queued = strcmp(g_changedNames[i], name) == 0;
+        }
+        if (!queued) {
+            snprintf(g_changedNames[g_changedCount++], PLUGIN_NAME_MAX, "%s", name);
+        }
+    }
+
+    bool start = !g_refreshRunning;
+    bool full = g_refreshQueued;
+    if (start) {
+        __atomic_store_n(&g_refreshRunning, true, __ATOMIC_RELEASE);
+        g_refreshQueued = false;
+    }
+    pthread_mutex_unlock(&g_listMutex);
+
+    if (start) {
+        StartRefreshWorker(full);
+    }
+}
+
+void PluginBrowserSetWatching(bool enabled) {
+    if (enabled == g_watching) return;
+    if (enabled) {
+        g_watching = DirWatcherStart(g_localPath, ".so", PLUGIN_WATCH_DEBOUNCE_MS, OnLocalChange, NULL);
+    } else {
+        DirWatcherStop();
+        g_watching = false;
+    }
+}
+
+void PluginBrowserSetAutoPush(bool enabled) {
+    pthread_mutex_lock(&g_listMutex);
+    g_autoPush = enabled;
+    pthread_mutex_unlock(&g_listMutex);
 }
 
 void PluginBrowserRefresh(void) {
-    g_opState.operation = OP_REFRESHING;
-    g_opState.progress = 0.0f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Scanning local plugins...");
+    pthread_mutex_lock(&g_listMutex);
+    if (g_refreshRunning) {
+        // Rescan once the current pass is done
+        g_refreshQueued = true;
+        pthread_mutex_unlock(&g_listMutex);
+        return;
+    }
+    __atomic_store_n(&g_refreshRunning, true, __ATOMIC_RELEASE);
+    g_refreshQueued = false;
+    pthread_mutex_unlock(&g_listMutex);
+
+    // Check before taking g_opMutex: the batch executor locks the queue
+    // first, then the op state
+    bool busy = PluginBrowserIsBusy();
+    LockOpState();
+    if (!busy) {
+        g_opState.operation = OP_REFRESHING;
+        g_opState.progress = 0.0f;
+        g_opState.complete = false;
+        snprintf(g_opState.message, sizeof(g_opState.message), "Refreshing...");
+    }
+    UnlockOpState();
+
+    if (!StartRefreshWorker(true)) {
+        SetRefreshState(0.0f, true, "Refresh failed");
+    }
+}
+
+bool PluginBrowserIsRefreshing(void) {
+    return __atomic_load_n(&g_refreshRunning, __ATOMIC_ACQUIRE);
+}
+
+bool PluginBrowserDeviceScanned(char *deviceId, size_t idSize) {
+    // Refresh worker state, stable once PluginBrowserIsRefreshing() is false
+    if (deviceId && idSize) snprintf(deviceId, idSize, "%s", g_deviceId);
+    return g_deviceScanned;
+}
+
+// Group the front list by status so the UI never has to scan it
+static void RebuildSectionView(void) {
+    for (int s = 0; s < 3; s++) {
+        g_sectionView.sections[s].count = 0;
+    }
 
-    // Reset plugin list
-    g_plugins.count = 0;
+    for (int i = 0; i < g_frontList->count; i++) {
+        PluginSection *section = &g_sectionView.sections[g_frontList->plugins[i].status];
+        if (section->count == section->capacity) {
+            int capacity = section->capacity ? section->capacity * 2 : 32;
+            int *slots = realloc(section->slots, (size_t)capacity * sizeof(int));
+            if (!slots) {
+                printf("Plugins: Out of memory indexing sections\n");
+                continue;
+            }
+            section->slots = slots;
+            section->capacity = capacity;
+        }
+        section->slots[section->count++] = i;
+    }
+    g_sectionView.generation++;
+}
 
-    // Scan local
-    ScanLocalPlugins();
+bool PluginBrowserUpdate(void) {
+    bool changed = false;
 
-    g_opState.progress = 0.5f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Scanning device plugins...");
+    pthread_mutex_lock(&g_listMutex);
+    if (g_pendingReady) {
+        PluginList *tmp = g_frontList;
+        g_frontList = g_pendingList;
+        g_pendingList = tmp;
+        g_pendingReady = false;
+        changed = true;
+    }
+    pthread_mutex_unlock(&g_listMutex);
 
-    // Scan remote
-    ScanRemotePlugins();
+    if (changed) {
+        RebuildSectionView();
+    }
 
-    g_opState.operation = OP_NONE;
-    g_opState.complete = true;
-    g_opState.success = true;
-    g_opState.progress = 1.0f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Found %d plugins", g_plugins.count);
+    // Re-push rebuilt plugins the watcher flagged (joins any running batch)
+    static char pushNames[PLUGIN_QUEUE_SIZE][PLUGIN_NAME_MAX];
+    pthread_mutex_lock(&g_listMutex);
+    int pushCount = g_pushCount;
+    memcpy(pushNames, g_pushNames, (size_t)pushCount * sizeof(pushNames[0]));
+    g_pushCount = 0;
+    pthread_mutex_unlock(&g_listMutex);
+
+    for (int i = 0; i < pushCount; i++) {
+        printf("Watch: Auto-pushing %s\n", pushNames[i]);
+        if (!PluginBrowserInstall(pushNames[i])) {
+            printf("Watch: Could not push %s: %s\n", pushNames[i], PluginBrowserGetOpState()->message);
+        }
+    }
+    return changed;
 }
 
 const PluginList *PluginBrowserGetList(void) {
-    return &g_plugins;
+    return g_frontList;
+}
+
+const PluginSectionView *PluginBrowserGetSections(void) {
+    return &g_sectionView;
 }
 
 const PluginInfo *PluginBrowserGetPlugin(int index) {
-    if (index < 0 || index >= g_plugins.count) return NULL;
-    return &g_plugins.plugins[index];
+    if (index < 0 || index >= g_frontList->count) return NULL;
+    return &g_frontList->plugins[index];
 }
 
 const PluginInfo *PluginBrowserFindPlugin(const char *name) {
-    for (int i = 0; i < g_plugins.count; i++) {
-        if (strcmp(g_plugins.plugins[i].name, name) == 0) {
-            return &g_plugins.plugins[i];
-        }
+    return PluginListFind(g_frontList, name);
+}
+
+// Overall batch progress: finished items plus the partial progress of every
+// running stream. Caller holds g_opMutex.
+static void UpdateBatchProgress(void) {
+    float partial = 0.0f;
+    double rate = 0.0, avgRate = 0.0, eta = -1.0;
+    for (int i = 0; i < PLUGIN_MAX_STREAMS; i++) {
+        const PluginStreamState *stream = &g_opState.streams[i];
+        if (!stream->active) continue;
+        partial += stream->progress;
+        rate += stream->bytesPerSec;
+        avgRate += stream->avgBytesPerSec;
+        if (stream->etaSeconds > eta) eta = stream->etaSeconds;
     }
-    return NULL;
+    g_opState.bytesPerSec = rate;
+    g_opState.avgBytesPerSec = avgRate;
+    g_opState.etaSeconds = eta;
+
+    int total = g_batchTotal > 0 ? g_batchTotal : 1;
+    g_opState.progress = (g_batchDone + partial) / total;
+    if (g_opState.progress > 1.0f) g_opState.progress = 1.0f;
 }
 
-// Progress callback for SCP
-static void InstallProgressCallback(float progress, const char *message, void *userData) {
-    (void)userData;
-    g_opState.progress = progress;
+// Progress callback for transfers; userData is the InstallStream
+static void InstallProgressCallback(float progress, const char *message,
+                                    const SshTransferStats *stats, void *userData) {
+    InstallStream *stream = (InstallStream *)userData;
+    LockOpState();
+    PluginStreamState *state = &g_opState.streams[stream->slot];
+    state->progress = progress;
+    if (stats) {
+        state->bytesSent = stats->bytesSent;
+        state->bytesTotal = stats->bytesTotal;
+        state->bytesPerSec = stats->instantBps;
+        state->avgBytesPerSec = stats->averageBps;
+        state->etaSeconds = stats->etaSeconds;
+        state->compressed = stats->compressed;
+        state->compressionRatio = stats->compressionRatio;
+        state->secondsSaved = stats->secondsSaved;
+        state->unverified = stats->unverified;
+    }
+    UpdateBatchProgress();
+    snprintf(g_opState.message, sizeof(g_opState.message), "%s: %s",
+             g_opState.streams[stream->slot].pluginName, message);
+    UnlockOpState();
+}
+
+static void SetBatchStep(float itemProgress, const char *message) {
+    LockOpState();
+    int total = g_batchTotal > 0 ? g_batchTotal : 1;
+    g_opState.progress = (g_batchDone + itemProgress) / total;
     snprintf(g_opState.message, sizeof(g_opState.message), "%s", message);
+    UnlockOpState();
 }
 
 // ============================================================================
-// Async Worker Threads
+// Batch Executor
 // ============================================================================
 
-static void *InstallWorkerThread(void *arg) {
-    (void)arg;
+static void FreeQueuedOp(QueuedOp *op) {
+    free(op->localPath);
+    free(op->remotePath);
+    op->localPath = NULL;
+    op->remotePath = NULL;
+}
+
+static bool PopQueuedOp(QueuedOp *out) {
+    pthread_mutex_lock(&g_queueMutex);
+    bool found = g_queueCount > 0;
+    if (found) {
+        *out = g_queue[g_queueHead];
+        g_queueHead = (g_queueHead + 1) % PLUGIN_QUEUE_SIZE;
+        __atomic_store_n(&g_queueCount, g_queueCount - 1, __ATOMIC_RELEASE);
+        // Items queued mid-batch join it
+        LockOpState();
+        g_batchTotal = g_batchDone + 1 + g_queueCount;
+        UnlockOpState();
+    }
+    pthread_mutex_unlock(&g_queueMutex);
+    return found;
+}
 
-    // Step 1: Enable read-write mode
-    printf("Install: Enabling read-write mode...\n");
-    g_opState.progress = 0.1f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Enabling write mode...");
-    SshResult rwResult = SshExecute("mount -o remount,rw /");
-    if (!rwResult.success) {
-        printf("Install: Warning - could not remount rw: %s\n", rwResult.output);
+// Pop the installs queued directly behind the one just popped, so they can
+// share the transfer streams. Stops at the first uninstall to keep ordering.
+static int PopInstallRun(QueuedOp *ops, int max) {
+    pthread_mutex_lock(&g_queueMutex);
+    int count = 0;
+    while (count < max && g_queueCount > 0 && g_queue[g_queueHead].operation == OP_INSTALLING) {
+        ops[count++] = g_queue[g_queueHead];
+        g_queueHead = (g_queueHead + 1) % PLUGIN_QUEUE_SIZE;
+        __atomic_store_n(&g_queueCount, g_queueCount - 1, __ATOMIC_RELEASE);
     }
+    pthread_mutex_unlock(&g_queueMutex);
+    return count;
+}
 
-    // Step 2: Ensure remote directory exists
-    printf("Install: Creating plugin directory...\n");
-    g_opState.progress = 0.2f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Creating directory...");
-    SshExecute("mkdir -p " SSH_PLUGIN_PATH);
+// Report one finished item. ring is the caller's own: a stream slot on
+// install and batch threads, RESULT_RING_UI on the UI thread.
+static void PushResult(int ring, const QueuedOp *op, bool success, const char *message) {
+    ResultRing *r = &g_resultRings[ring];
+    unsigned int tail = r->tail;
+    if (tail - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == RESULT_RING_SIZE) {
+        // UI isn't draining; only the consumer may advance head, so drop this one
+        printf("Batch: Result queue full, dropping result for %s\n", op->pluginName);
+    } else {
+        PluginOpResult *item = &r->items[tail & (RESULT_RING_SIZE - 1)];
+        item->operation = op->operation;
+        strncpy(item->pluginName, op->pluginName, sizeof(item->pluginName) - 1);
+        item->pluginName[sizeof(item->pluginName) - 1] = '\0';
+        item->success = success;
+        snprintf(item->message, sizeof(item->message), "%s", message);
+        __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    LockOpState();
+    snprintf(g_lastResultMessage, sizeof(g_lastResultMessage), "%s", message);
+    UnlockOpState();
+}
 
-    // Step 3: Copy file
-    printf("Install: Copying %s to %s...\n", g_pendingLocalPath, g_pendingRemotePath);
-    bool success = SshCopyToDevice(g_pendingLocalPath, g_pendingRemotePath,
-                                   InstallProgressCallback, NULL);
+static bool RunInstall(const QueuedOp *op, InstallStream *stream) {
+    // Uploaded ahead of time (prestage.h): only the check and rename are left
+    if (PrestagePromote(op->pluginName, op->localPath, op->remotePath)) {
+        printf("Install: Moved staged %s into place at %s\n", op->pluginName, op->remotePath);
+        InstallProgressCallback(1.0f, "Installed from staging", NULL, stream);
+        return true;
+    }
 
-    // Step 4: Sync filesystem
-    if (success) {
-        printf("Install: Syncing filesystem...\n");
-        g_opState.progress = 0.95f;
-        snprintf(g_opState.message, sizeof(g_opState.message), "Syncing...");
-        SshExecute("sync");
+    // Copy file (only the changed blocks when updating)
+    if (op->isUpdate) {
+        printf("Install: Updating %s from %s...\n", op->remotePath, op->localPath);
+        return SshSyncToDevice(op->localPath, op->remotePath, InstallProgressCallback, stream);
     }
+    printf("Install: Copying %s to %s...\n", op->localPath, op->remotePath);
+    return SshCopyToDevice(op->localPath, op->remotePath, InstallProgressCallback, stream);
+}
+
+// One transfer stream: keep taking installs from the run until it's empty
+static void *InstallStreamThread(void *arg) {
+    InstallStream *stream = (InstallStream *)arg;
+    InstallRun *run = stream->run;
+    if (stream->slot > 0) TraceNameThread("install stream");
+    PluginStreamState *state = &g_opState.streams[stream->slot];
+
+    for (;;) {
+        LockOpState();
+        if (run->next >= run->count) {
+            UnlockOpState();
+            break;
+        }
+        QueuedOp *op = &run->ops[run->next++];
+        memset(state, 0, sizeof(*state));
+        state->active = true;
+        state->etaSeconds = -1.0;
+        strncpy(state->pluginName, op->pluginName, sizeof(state->pluginName) - 1);
+        state->pluginName[sizeof(state->pluginName) - 1] = '\0';
+        strncpy(g_opState.pluginName, op->pluginName, sizeof(g_opState.pluginName) - 1);
+        UnlockOpState();
+
+        // The file may have been rebuilt since the scan: check what is
+        // about to be sent, before any network I/O
+        uint64_t traceStart = TraceBegin();
+        ElfPluginInfo elf;
+        bool loadable = !g_elfChecks || ElfCheckFile(op->localPath, &elf);
+        bool success = loadable && RunInstall(op, stream);
+        op->succeeded = success;
+        TraceEndArgs("Install", TRACE_CAT_SSH, traceStart, NULL, 0, op->pluginName);
+
+        char message[PLUGIN_MESSAGE_MAX];
+        if (!loadable) {
+            snprintf(message, sizeof(message), "Rejected %s: %s", op->pluginName, elf.error);
+        } else if (success && state->compressed) {
+            snprintf(message, sizeof(message), "Installed %s (gzip %.0f%%, %.1fs saved)",
+                     op->pluginName, state->compressionRatio * 100.0, state->secondsSaved);
+        } else {
+            snprintf(message, sizeof(message), success ? "Installed %s" : "Failed to install %s",
+                     op->pluginName);
+        }
+        if (success && state->unverified) {
+            size_t len = strlen(message);
+            snprintf(message + len, sizeof(message) - len, "%s",
+                     " - unverified, no sha256sum on the device");
+        }
+        printf("Batch: %s\n", message);
 
-    g_opState.complete = true;
-    g_opState.success = success;
+        LockOpState();
+        memset(state, 0, sizeof(*state));
+        g_batchDone++;
+        if (success) run->succeeded++; else run->failed++;
+        UpdateBatchProgress();
+        UnlockOpState();
 
-    if (success) {
-        printf("Install: Successfully installed %s\n", g_pendingPluginName);
-        snprintf(g_opState.message, sizeof(g_opState.message), "Installed %s", g_pendingPluginName);
-    } else {
-        printf("Install: Failed to install %s\n", g_pendingPluginName);
-        snprintf(g_opState.message, sizeof(g_opState.message), "Failed to install %s", g_pendingPluginName);
+        PushResult(stream->slot, op, success, message);
+        FreeQueuedOp(op);
     }
 
-    g_threadRunning = false;
     return NULL;
 }
 
-static void *UninstallWorkerThread(void *arg) {
-    (void)arg;
+// Hand the collected reload requests to the host. If it can't be told, the
+// batch restarts the service instead (g_reloadMissed).
+static void FlushReloads(void) {
+    if (g_reloadCount == 0) return;
 
-    // Step 1: Enable read-write mode
-    printf("Uninstall: Enabling read-write mode...\n");
-    g_opState.progress = 0.1f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Enabling write mode...");
-    SshResult rwResult = SshExecute("mount -o remount,rw /");
-    if (!rwResult.success) {
-        printf("Uninstall: Warning - could not remount rw: %s\n", rwResult.output);
-    }
-
-    // Step 2: Stop llizardgui service if running
-    printf("Uninstall: Stopping llizardgui service...\n");
-    g_opState.progress = 0.2f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Stopping service...");
-    SshExecute("sv stop llizardgui 2>/dev/null || true");
-    SshExecute("pkill -f llizardgui-host 2>/dev/null || true");
-
-    // Step 3: Delete the plugin file
-    printf("Uninstall: Deleting plugin file: %s\n", g_pendingRemotePath);
-    g_opState.progress = 0.4f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Deleting plugin...");
-
-    char deleteCmd[1024];
-    snprintf(deleteCmd, sizeof(deleteCmd), "rm -f '%s'", g_pendingRemotePath);
-    SshResult deleteResult = SshExecute(deleteCmd);
-    printf("Uninstall: Delete result: success=%d, output=%s\n", deleteResult.success, deleteResult.output);
-
-    // Step 4: Delete any related config/data files
-    printf("Uninstall: Cleaning up related files for %s...\n", g_pendingPluginName);
-    g_opState.progress = 0.6f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Cleaning up...");
-
-    char cleanupCmd[1024];
-    snprintf(cleanupCmd, sizeof(cleanupCmd),
-             "rm -rf /var/lib/llizard/plugins/%s 2>/dev/null || true; "
-             "rm -rf /tmp/llizard/%s 2>/dev/null || true; "
-             "rm -f /etc/llizard/plugins/%s.conf 2>/dev/null || true",
-             g_pendingPluginName, g_pendingPluginName, g_pendingPluginName);
-    SshExecute(cleanupCmd);
-
-    // Step 5: Sync filesystem
-    printf("Uninstall: Syncing filesystem...\n");
-    g_opState.progress = 0.8f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Syncing...");
-    SshExecute("sync");
-
-    // Step 6: Restart llizardgui service
-    printf("Uninstall: Restarting llizardgui service...\n");
-    g_opState.progress = 0.9f;
-    snprintf(g_opState.message, sizeof(g_opState.message), "Restarting service...");
-    SshExecute("sv start llizardgui 2>/dev/null || true");
-
-    // Verify the file is actually deleted
-    bool success = !SshFileExists(g_pendingRemotePath);
-
-    g_opState.complete = true;
-    g_opState.success = success;
-    g_opState.progress = 1.0f;
-
-    if (success) {
-        printf("Uninstall: Successfully uninstalled %s\n", g_pendingPluginName);
-        snprintf(g_opState.message, sizeof(g_opState.message), "Uninstalled %s", g_pendingPluginName);
+    const char *lines[PLUGIN_QUEUE_SIZE];
+    for (int i = 0; i < g_reloadCount; i++) {
+        lines[i] = g_reloadLines[i];
+    }
+    int sent = SshNotifyReload(lines, g_reloadCount);
+    if (sent > 0) {
+        printf("Batch: Asked llizardgui-host to reload %d plugins\n", g_reloadCount);
     } else {
-        printf("Uninstall: Failed to uninstall %s (file may still exist)\n", g_pendingPluginName);
-        snprintf(g_opState.message, sizeof(g_opState.message), "Failed to uninstall %s", g_pendingPluginName);
+        printf("Batch: Could not reach llizardgui-host on %s%s\n", SSH_RELOAD_FIFO,
+               sent == 0 ? " (not listening)" : "");
+        g_reloadMissed = true;
+    }
+    g_reloadCount = 0;
+}
+
+static void QueueReload(const char *verb, const char *pluginName) {
+    if (g_reloadMode != PLUGIN_RELOAD_HOT) return;
+    if (g_reloadCount == PLUGIN_QUEUE_SIZE) FlushReloads();
+    snprintf(g_reloadLines[g_reloadCount++], sizeof(g_reloadLines[0]), "%s %s", verb, pluginName);
+}
+
+// Push a run of installs over up to g_streamLimit concurrent streams
+static void RunInstalls(QueuedOp *ops, int count, int *succeeded, int *failed) {
+    InstallRun run = { .ops = ops, .count = count };
+    InstallStream streams[PLUGIN_MAX_STREAMS];
+    pthread_t threads[PLUGIN_MAX_STREAMS];
+    bool started[PLUGIN_MAX_STREAMS] = {0};
+
+    int streamCount = g_streamLimit < count ? g_streamLimit : count;
+    if (streamCount > 1) {
+        printf("Batch: Installing %d plugins over %d streams\n", count, streamCount);
+    }
+
+    // Stream 0 runs on this thread; the rest get their own
+    for (int i = 0; i < streamCount; i++) {
+        streams[i].run = &run;
+        streams[i].slot = i;
+        if (i > 0) {
+            started[i] = (pthread_create(&threads[i], NULL, InstallStreamThread, &streams[i]) == 0);
+        }
+    }
+    InstallStreamThread(&streams[0]);
+    for (int i = 1; i < streamCount; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (ops[i].succeeded) QueueReload("load", ops[i].pluginName);
+    }
+
+    *succeeded += run.succeeded;
+    *failed += run.failed;
+}
+
+// Agent version of RunUninstall: the same deletes and check, one round trip.
+// Returns -1 if the agent went away before answering.
+static int UninstallViaAgent(DeviceAgent *agent, const QueuedOp *op) {
+    char dataDir[PLUGIN_NAME_MAX + 32];
+    char tmpDir[PLUGIN_NAME_MAX + 32];
+    char config[PLUGIN_NAME_MAX + 32];
+    snprintf(dataDir, sizeof(dataDir), "/var/lib/llizard/plugins/%s", op->pluginName);
+    snprintf(tmpDir, sizeof(tmpDir), "/tmp/llizard/%s", op->pluginName);
+    snprintf(config, sizeof(config), "/etc/llizard/plugins/%s.conf", op->pluginName);
+
+    AgentBatch batch = {0};
+    int deleted = AgentAddDelete(&batch, op->remotePath, false);
+    AgentAddDelete(&batch, dataDir, true);
+    AgentAddDelete(&batch, tmpDir, true);
+    AgentAddDelete(&batch, config, false);
+    int check = AgentAddStat(&batch, op->remotePath);
+    if (!AgentBatchRun(agent, &batch)) {
+        AgentBatchFree(&batch);
+        return -1;
+    }
+
+    // Like the shell version, only the plugin file itself decides success
+    bool gone = batch.replies[check].status == ENOENT;
+    if (!gone) {
+        printf("Uninstall: Delete failed: %s\n", batch.replies[deleted].status != AGENT_OK
+                   ? strerror(batch.replies[deleted].status) : "file still present");
+    }
+    AgentBatchFree(&batch);
+    return gone ? 1 : 0;
+}
+
+static bool RunUninstall(const QueuedOp *op) {
+    // Delete the plugin and its config/data, then verify, in one round trip
+    printf("Uninstall: Deleting plugin file: %s\n", op->remotePath);
+    SetBatchStep(0.4f, "Deleting plugin...");
+
+    DeviceAgent *agent = SshGetAgent();
+    int removed = agent ? UninstallViaAgent(agent, op) : -1;
+    if (removed >= 0) return removed == 1;
+
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd),
+             "rm -f '%s'; "
+             "rm -rf /var/lib/llizard/plugins/%s 2>/dev/null; "
+             "rm -rf /tmp/llizard/%s 2>/dev/null; "
+             "rm -f /etc/llizard/plugins/%s.conf 2>/dev/null; "
+             "test ! -e '%s'",
+             op->remotePath, op->pluginName, op->pluginName, op->pluginName, op->remotePath);
+    SshResult result = SshExecute(cmd);
+    if (!result.success) {
+        printf("Uninstall: Delete failed: %s\n", result.output);
+    }
+    return result.success;
+}
+
+static void *BatchWorkerThread(void *arg) {
+    (void)arg;
+    TraceNameThread("batch");
+
+    // Kept across the batches a long queue is drained in, until reported
+    bool restartNeeded = false;
+    for (;;) {
+        uint64_t traceStart = TraceBegin();
+        bool remounted = false;
+        bool serviceStopped = false;
+        int succeeded = 0;
+        int failed = 0;
+        g_batchDone = 0;
+        g_reloadMissed = false;
+
+        QueuedOp op;
+        while (PopQueuedOp(&op)) {
+            LockOpState();
+            g_opState.operation = op.operation;
+            strncpy(g_opState.pluginName, op.pluginName, sizeof(g_opState.pluginName) - 1);
+            UnlockOpState();
+
+            // Once per batch: writable rootfs and plugin directory
+            if (!remounted) {
+                printf("Batch: Enabling read-write mode...\n");
+                SetBatchStep(0.05f, "Enabling write mode...");
+                if (!SshPrepareWrite(SSH_PLUGIN_PATH)) {
+                    printf("Batch: Warning - could not remount rw\n");
+                }
+                remounted = true;
+            }
+
+            // Restart mode: once per batch, and only if something is being
+            // removed (hot reload unloads it instead)
+            if (op.operation == OP_UNINSTALLING && !serviceStopped &&
+                g_reloadMode == PLUGIN_RELOAD_RESTART) {
+                printf("Batch: Stopping llizardgui service...\n");
+                SetBatchStep(0.2f, "Stopping service...");
+                SshExecute("sv stop llizardgui 2>/dev/null; pkill -f llizardgui-host 2>/dev/null; true");
+                serviceStopped = true;
+            }
+
+            if (op.operation == OP_INSTALLING) {
+                // Take every install queued right behind this one
+                g_runOps[0] = op;
+                int count = 1 + PopInstallRun(g_runOps + 1, PLUGIN_QUEUE_SIZE - 1);
+                RunInstalls(g_runOps, count, &succeeded, &failed);
+                continue;
+            }
+
+            uint64_t uninstallStart = TraceBegin();
+            bool success = RunUninstall(&op);
+            TraceEndArgs("Uninstall", TRACE_CAT_SSH, uninstallStart, NULL, 0, op.pluginName);
+            char message[PLUGIN_MESSAGE_MAX];
+            snprintf(message, sizeof(message), success ? "Uninstalled %s" : "Failed to uninstall %s",
+                     op.pluginName);
+            printf("Batch: %s\n", message);
+
+            if (success) {
+                succeeded++;
+                QueueReload("unload", op.pluginName);
+            } else {
+                failed++;
+            }
+            LockOpState();
+            g_batchDone++;
+            UnlockOpState();
+            PushResult(0, &op, success, message);
+            FreeQueuedOp(&op);
+        }
+
+        // Once per batch: flush and bring the UI back
+        if (remounted) {
+            printf("Batch: Syncing filesystem...\n");
+            SetBatchStep(0.0f, "Syncing...");
+            SshSyncFilesystem();
+        }
+        if (g_reloadCount > 0) {
+            SetBatchStep(0.0f, "Reloading plugins...");
+            FlushReloads();
+        }
+        if (serviceStopped) {
+            printf("Batch: Restarting llizardgui service...\n");
+            SetBatchStep(0.0f, "Restarting service...");
+            SshExecute("sv start llizardgui 2>/dev/null || true");
+        } else if (g_reloadMode == PLUGIN_RELOAD_RESTART && succeeded > 0) {
+            // Installs only: the running host still has the old code mapped
+            printf("Batch: Restarting llizardgui service...\n");
+            SetBatchStep(0.0f, "Restarting service...");
+            SshExecute("sv restart llizardgui 2>/dev/null || true");
+        } else if (g_reloadMissed) {
+            // Hot reload didn't land: restart once rather than leave the
+            // host running the old set
+            printf("Batch: Restarting llizardgui service instead...\n");
+            SetBatchStep(0.0f, "Restarting service...");
+            if (!SshExecute("sv restart llizardgui 2>/dev/null").success) {
+                printf("Batch: Could not restart llizardgui; changes apply on its next restart\n");
+                restartNeeded = true;
+            }
+        }
+
+        TraceEndArgs("Batch", TRACE_CAT_OP, traceStart, "items", succeeded + failed, NULL);
+
+        // Anything queued during finalization starts a new batch
+        pthread_mutex_lock(&g_queueMutex);
+        bool more = g_queueCount > 0;
+        if (!more) {
+            LockOpState();
+            g_opState.complete = true;
+            g_opState.success = (failed == 0);
+            g_opState.progress = 1.0f;
+            g_opState.restartNeeded = restartNeeded;
+            if (succeeded + failed == 1) {
+                snprintf(g_opState.message, sizeof(g_opState.message), "%s", g_lastResultMessage);
+            } else {
+                snprintf(g_opState.message, sizeof(g_opState.message), "Batch done: %d succeeded, %d failed",
+                         succeeded, failed);
+            }
+            if (restartNeeded) {
+                size_t len = strlen(g_opState.message);
+                snprintf(g_opState.message + len, sizeof(g_opState.message) - len, "%s",
+                         " (not applied until llizardgui restarts)");
+            }
+            UnlockOpState();
+            __atomic_store_n(&g_batchRunning, false, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&g_queueMutex);
+
+        if (!more) break;
     }
 
-    g_threadRunning = false;
     return NULL;
 }
 
-// ============================================================================
-// Public API (now async)
-// ============================================================================
+// Add an op to the queue and start the executor if it's idle
+static bool EnqueueOp(const QueuedOp *op) {
+    pthread_mutex_lock(&g_queueMutex);
 
-bool PluginBrowserInstall(const char *pluginName) {
-    // Don't start if already busy
-    if (g_threadRunning) {
-        snprintf(g_opState.message, sizeof(g_opState.message), "Operation in progress");
-        return false;
+    // Ignore duplicates still waiting in the queue
+    for (int i = 0; i < g_queueCount; i++) {
+        const QueuedOp *q = &g_queue[(g_queueHead + i) % PLUGIN_QUEUE_SIZE];
+        if (q->operation == op->operation && strcmp(q->pluginName, op->pluginName) == 0) {
+            pthread_mutex_unlock(&g_queueMutex);
+            return true;
+        }
     }
 
-    const PluginInfo *plugin = PluginBrowserFindPlugin(pluginName);
-    if (!plugin || plugin->localPath[0] == '\0') {
-        snprintf(g_opState.message, sizeof(g_opState.message), "Plugin not found locally");
+    if (g_queueCount == PLUGIN_QUEUE_SIZE) {
+        pthread_mutex_unlock(&g_queueMutex);
+        SetOpMessage("Queue full");
         return false;
     }
 
-    if (SshGetStatus() != SSH_STATUS_CONNECTED) {
-        snprintf(g_opState.message, sizeof(g_opState.message), "Device not connected");
+    QueuedOp *slot = &g_queue[(g_queueHead + g_queueCount) % PLUGIN_QUEUE_SIZE];
+    *slot = *op;
+    slot->localPath = op->localPath ? strdup(op->localPath) : NULL;
+    slot->remotePath = strdup(op->remotePath);
+    if ((op->localPath && !slot->localPath) || !slot->remotePath) {
+        FreeQueuedOp(slot);
+        pthread_mutex_unlock(&g_queueMutex);
+        SetOpMessage("Out of memory");
         return false;
     }
+    __atomic_store_n(&g_queueCount, g_queueCount + 1, __ATOMIC_RELEASE);
+
+    if (g_batchRunning) {
+        pthread_mutex_unlock(&g_queueMutex);
+        return true;
+    }
 
-    // Setup operation state
-    g_opState.operation = OP_INSTALLING;
+    // Setup operation state (takes it over from a running refresh)
+    LockOpState();
+    g_opState.operation = op->operation;
     g_opState.progress = 0.0f;
     g_opState.complete = false;
-    strncpy(g_opState.pluginName, pluginName, sizeof(g_opState.pluginName) - 1);
-    snprintf(g_opState.message, sizeof(g_opState.message), "Installing %s...", pluginName);
-
-    // Copy paths for worker thread
-    strncpy(g_pendingPluginName, pluginName, sizeof(g_pendingPluginName) - 1);
-    strncpy(g_pendingLocalPath, plugin->localPath, sizeof(g_pendingLocalPath) - 1);
-    snprintf(g_pendingRemotePath, sizeof(g_pendingRemotePath), "%s/%s.so", SSH_PLUGIN_PATH, pluginName);
-
-    // Start worker thread
-    g_threadRunning = true;
-    if (pthread_create(&g_workerThread, NULL, InstallWorkerThread, NULL) != 0) {
-        g_threadRunning = false;
+    g_opState.success = false;
+    g_opState.restartNeeded = false;
+    strncpy(g_opState.pluginName, op->pluginName, sizeof(g_opState.pluginName) - 1);
+    snprintf(g_opState.message, sizeof(g_opState.message), "%s %s...",
+             op->operation == OP_INSTALLING ? "Installing" : "Uninstalling", op->pluginName);
+    UnlockOpState();
+
+    __atomic_store_n(&g_batchRunning, true, __ATOMIC_RELEASE);
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, BatchWorkerThread, NULL) != 0) {
+        __atomic_store_n(&g_batchRunning, false, __ATOMIC_RELEASE);
+        __atomic_store_n(&g_queueCount, g_queueCount - 1, __ATOMIC_RELEASE);
+        FreeQueuedOp(slot);
+        pthread_mutex_unlock(&g_queueMutex);
+        LockOpState();
         g_opState.complete = true;
         g_opState.success = false;
-        snprintf(g_opState.message, sizeof(g_opState.message), "Failed to start install thread");
+        snprintf(g_opState.message, sizeof(g_opState.message), "Failed to start worker thread");
+        UnlockOpState();
         return false;
     }
 
     // Detach thread so it cleans up automatically
-    pthread_detach(g_workerThread);
+    pthread_detach(thread);
+    pthread_mutex_unlock(&g_queueMutex);
 
+    // Speculative uploads give way; g_batchRunning keeps new ones off until
+    // the batch is done
+    PrestageCancel();
     return true;
 }
 
-bool PluginBrowserUninstall(const char *pluginName) {
-    // Don't start if already busy
-    if (g_threadRunning) {
-        snprintf(g_opState.message, sizeof(g_opState.message), "Operation in progress");
+// ============================================================================
+// Public API (queued, async)
+// ============================================================================
+
+bool PluginBrowserInstall(const char *pluginName) {
+    const PluginInfo *plugin = PluginBrowserFindPlugin(pluginName);
+    if (!plugin || plugin->localPath[0] == '\0') {
+        SetOpMessage("Plugin not found locally");
+        return false;
+    }
+    if (plugin->detail->elf.state == ELF_INVALID) {
+        printf("Install: Refusing %s: %s\n", pluginName, plugin->detail->elf.error);
+        SetOpMessage(plugin->detail->elf.error);
+        return false;
+    }
+
+    if (SshGetStatus() != SSH_STATUS_CONNECTED) {
+        SetOpMessage("Device not connected");
         return false;
     }
 
+    // Paths are borrowed here; EnqueueOp keeps its own copies
+    char remotePath[sizeof(SSH_PLUGIN_PATH) + PLUGIN_NAME_MAX + 4];
+    snprintf(remotePath, sizeof(remotePath), "%s/%s.so", SSH_PLUGIN_PATH, pluginName);
+
+    QueuedOp op = {0};
+    op.operation = OP_INSTALLING;
+    strncpy(op.pluginName, pluginName, sizeof(op.pluginName) - 1);
+    op.localPath = (char *)plugin->localPath;
+    op.remotePath = remotePath;
+    op.isUpdate = (plugin->remotePath[0] != '\0');
+
+    // Same bytes already on the device: nothing to send
+    if (plugin->syncState == PLUGIN_SYNC_UP_TO_DATE) {
+        printf("Install: %s is already up to date\n", pluginName);
+        char message[PLUGIN_MESSAGE_MAX];
+        snprintf(message, sizeof(message), "%s is up to date", pluginName);
+        PushResult(RESULT_RING_UI, &op, true, message);
+        return true;
+    }
+
+    return EnqueueOp(&op);
+}
+
+bool PluginBrowserUninstall(const char *pluginName) {
     const PluginInfo *plugin = PluginBrowserFindPlugin(pluginName);
     if (!plugin || plugin->remotePath[0] == '\0') {
-        snprintf(g_opState.message, sizeof(g_opState.message), "Plugin not installed on device");
+        SetOpMessage("Plugin not installed on device");
         return false;
     }
 
     if (SshGetStatus() != SSH_STATUS_CONNECTED) {
-        snprintf(g_opState.message, sizeof(g_opState.message), "Device not connected");
+        SetOpMessage("Device not connected");
         return false;
     }
 
-    // Setup operation state
-    g_opState.operation = OP_UNINSTALLING;
-    g_opState.progress = 0.0f;
-    g_opState.complete = false;
-    strncpy(g_opState.pluginName, pluginName, sizeof(g_opState.pluginName) - 1);
-    snprintf(g_opState.message, sizeof(g_opState.message), "Uninstalling %s...", pluginName);
+    QueuedOp op = {0};
+    op.operation = OP_UNINSTALLING;
+    strncpy(op.pluginName, pluginName, sizeof(op.pluginName) - 1);
+    op.remotePath = (char *)plugin->remotePath;
+    return EnqueueOp(&op);
+}
 
-    // Copy paths for worker thread
-    strncpy(g_pendingPluginName, pluginName, sizeof(g_pendingPluginName) - 1);
-    strncpy(g_pendingRemotePath, plugin->remotePath, sizeof(g_pendingRemotePath) - 1);
+void PluginBrowserSetReloadMode(PluginReloadMode mode) {
+    g_reloadMode = mode;
+}
 
-    // Start worker thread
-    g_threadRunning = true;
-    if (pthread_create(&g_workerThread, NULL, UninstallWorkerThread, NULL) != 0) {
-        g_threadRunning = false;
-        g_opState.complete = true;
-        g_opState.success = false;
-        snprintf(g_opState.message, sizeof(g_opState.message), "Failed to start uninstall thread");
-        return false;
-    }
+void PluginBrowserSetStreams(int streams) {
+    if (streams < 1) streams = 1;
+    if (streams > PLUGIN_MAX_STREAMS) streams = PLUGIN_MAX_STREAMS;
+    g_streamLimit = streams;
+}
 
-    // Detach thread so it cleans up automatically
-    pthread_detach(g_workerThread);
+int PluginBrowserQueuedCount(void) {
+    return __atomic_load_n(&g_queueCount, __ATOMIC_ACQUIRE);
+}
 
+static bool PopResult(ResultRing *r, PluginOpResult *out) {
+    unsigned int head = r->head;
+    if (head == __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE)) return false;
+    *out = r->items[head & (RESULT_RING_SIZE - 1)];
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
     return true;
 }
 
+bool PluginBrowserPollResult(PluginOpResult *out) {
+    // Requests answered on the spot come before anything the batch finished
+    if (PopResult(&g_resultRings[RESULT_RING_UI], out)) return true;
+    for (int i = 0; i < PLUGIN_MAX_STREAMS; i++) {
+        if (PopResult(&g_resultRings[i], out)) return true;
+    }
+    return false;
+}
+
 const PluginOpState *PluginBrowserGetOpState(void) {
-    return &g_opState;
+    // Seqlock read: retry if a writer published while we were copying
+    for (;;) {
+        unsigned int seq = __atomic_load_n(&g_opSeq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(&g_opSnapshot, &g_opPublished, sizeof(g_opSnapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&g_opSeq, __ATOMIC_RELAXED) == seq) break;
+    }
+    return &g_opSnapshot;
 }
 
 bool PluginBrowserIsBusy(void) {
-    return g_threadRunning || (g_opState.operation != OP_NONE && !g_opState.complete);
+    // Refreshes run alongside installs and don't count as busy
+    return __atomic_load_n(&g_batchRunning, __ATOMIC_ACQUIRE);
 }
 
 void FormatFileSize(long bytes, char *buffer, size_t bufSize) {
@@ -1,6 +1,7 @@
 #ifndef PLUGIN_BROWSER_H
 #define PLUGIN_BROWSER_H
 
+#include "plugin_registry.h"
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -8,32 +9,40 @@
 // Plugin Browser - Local and remote plugin discovery and management
 // ============================================================================
 
-// Maximum number of plugins to track
-#define MAX_PLUGINS 64
+// Maximum number of queued install/uninstall requests
+#define PLUGIN_QUEUE_SIZE 128
 
-// Plugin installation status
+// Concurrent transfers per batch (each is its own channel on the shared
+// SSH session)
+#define PLUGIN_MAX_STREAMS 8
+#define PLUGIN_DEFAULT_STREAMS 4
+
+// Quiet time before a changed local plugin is picked up (linkers write in
+// bursts)
+#define PLUGIN_WATCH_DEBOUNCE_MS 300
+
+// Status and result text: a whole plugin name plus what happened to it
+// (room for "Rejected <name>: " and a full ElfPluginInfo.error)
+#define PLUGIN_MESSAGE_MAX (PLUGIN_NAME_MAX + 128)
+
+// How installed and removed plugins take effect on the device
 typedef enum {
-    PLUGIN_LOCAL_ONLY,      // Only on local machine
-    PLUGIN_INSTALLED,       // On both local and device
-    PLUGIN_DEVICE_ONLY      // Only on device (unknown plugin)
-} PluginStatus;
+    PLUGIN_RELOAD_HOT,      // Ask llizardgui-host to (re)load just those plugins
+    PLUGIN_RELOAD_RESTART   // Restart the whole llizardgui service once per batch
+} PluginReloadMode;
 
-// Plugin info structure
+// Front-list plugins with one status, in list order
 typedef struct {
-    char name[64];          // Plugin name (without .so extension)
-    char displayName[64];   // Human-readable name
-    char localPath[512];    // Full path on local machine (empty if not local)
-    char remotePath[512];   // Full path on device (empty if not on device)
-    long localSize;         // File size in bytes (local)
-    long remoteSize;        // File size in bytes (device)
-    PluginStatus status;    // Installation status
-} PluginInfo;
-
-// Plugin list
-typedef struct {
-    PluginInfo plugins[MAX_PLUGINS];
+    int *slots;             // Indices into PluginList.plugins
     int count;
-} PluginList;
+    int capacity;
+} PluginSection;
+
+// Front list grouped by status, rebuilt only when the list changes
+typedef struct {
+    PluginSection sections[3];  // Indexed by PluginStatus
+    unsigned int generation;    // Bumped on every rebuild
+} PluginSectionView;
 
 // Operation state for async operations
 typedef enum {
@@ -43,15 +52,45 @@ typedef enum {
     OP_REFRESHING
 } PluginOperation;
 
+// One in-flight transfer
 typedef struct {
-    PluginOperation operation;
-    char pluginName[64];
+    bool active;
+    char pluginName[PLUGIN_NAME_MAX];
     float progress;
-    char message[256];
-    bool complete;
-    bool success;
+    long bytesSent;
+    long bytesTotal;
+    double bytesPerSec;      // Instantaneous
+    double avgBytesPerSec;   // Since this file started
+    double etaSeconds;       // < 0 until known
+    bool compressed;         // Set when the file finished sending gzip'd
+    double compressionRatio;
+    double secondsSaved;
+    bool unverified;         // Landed with only its size checked (no sha256sum on the device)
+} PluginStreamState;
+
+typedef struct {
+    PluginOperation operation;  // Item currently running
+    char pluginName[PLUGIN_NAME_MAX];
+    float progress;             // Across the whole batch
+    char message[PLUGIN_MESSAGE_MAX];
+    bool complete;              // Whole batch finished
+    bool success;               // No item in the batch failed
+    bool restartNeeded;         // Neither hot reload nor a restart reached the
+                                // host: changes apply on its next restart
+    PluginStreamState streams[PLUGIN_MAX_STREAMS];  // Per-file progress of parallel installs
+    double bytesPerSec;         // Sum over running transfers (0 when none)
+    double avgBytesPerSec;
+    double etaSeconds;          // Longest remaining transfer; < 0 if unknown
 } PluginOpState;
 
+// Outcome of one queued install/uninstall
+typedef struct {
+    PluginOperation operation;
+    char pluginName[PLUGIN_NAME_MAX];
+    bool success;
+    char message[PLUGIN_MESSAGE_MAX];
+} PluginOpResult;
+
 // Initialize plugin browser
 // localPluginDir: path to local plugins (e.g., "../build-armv7-drm/")
 void PluginBrowserInit(const char *localPluginDir);
@@ -65,30 +104,105 @@ void PluginBrowserSetLocalPath(const char *path);
 // Get local plugin directory
 const char *PluginBrowserGetLocalPath(void);
 
-// Refresh plugin lists (scans local and remote)
-// This is synchronous and may take time
+// Watch the local plugin directory (inotify, or polling where unavailable)
+// and apply created, rebuilt and deleted plugins to the list without a full
+// rescan. Restarted automatically when the local path changes.
+void PluginBrowserSetWatching(bool enabled);
+
+// While watching, re-install plugins that are on the device whenever their
+// local build changes. Plugins only present locally are never pushed.
+void PluginBrowserSetAutoPush(bool enabled);
+
+// Scan localDir's plugins into the local side of list (hashing each file).
+// Hashes are carried over from prev (may be NULL) for files whose size and
+// mtime haven't changed. Safe from any thread.
+void PluginBrowserScanLocalDir(const char *localDir, PluginList *list, const PluginList *prev);
+
+// Read the plugins on the device bound to the calling thread (SshBindDevice)
+// into the remote side of list, in one round trip, and update every entry's
+// status. deviceId (may be NULL) receives the device's identity. Returns
+// false if the device couldn't be listed. Safe from any thread.
+bool PluginBrowserScanDevice(PluginList *list, bool withHashes, char *deviceId, size_t idSize);
+
+// Include SHA-256 hashes in the device inventory (off by default: every
+// refresh would hash every installed plugin on the device's CPU). Without
+// them, mismatched sizes count as stale and equal sizes stay unknown.
+void PluginBrowserSetRemoteHashing(bool enabled);
+
+// Load and save the inventory cache (on by default; call before
+// PluginBrowserInit). Its hashes are trusted while size and whole-second
+// mtime match, which a one-shot run shouldn't rely on.
+void PluginBrowserSetInventoryCache(bool enabled);
+
+// Validate local builds (architecture, float ABI, entry point, plugin API
+// version) and refuse to send ones that can't load (on by default; call
+// before PluginBrowserInit)
+void PluginBrowserSetElfChecks(bool enabled);
+
+// Refresh plugin lists (scans local and remote) on a background thread
+// Returns immediately. Local results are published first and device results
+// merge in when the remote scan finishes. A refresh requested while one is
+// running is queued and runs once the current pass completes.
 void PluginBrowserRefresh(void);
 
-// Get merged plugin list
+// Check if a refresh is running (lock-free)
+bool PluginBrowserIsRefreshing(void);
+
+// Whether the last full refresh listed the device; copies the device's
+// machine id (may be empty) to deviceId. Only valid while no refresh runs.
+bool PluginBrowserDeviceScanned(char *deviceId, size_t idSize);
+
+// Swap in the latest snapshot published by the refresh worker
+// Call once per frame from the UI thread, before PluginBrowserGetList.
+// Returns true if the list changed.
+bool PluginBrowserUpdate(void);
+
+// Get merged plugin list (UI thread; stays valid until the next
+// PluginBrowserUpdate)
 const PluginList *PluginBrowserGetList(void);
 
+// Get the section index for the current list (UI thread; same lifetime as
+// PluginBrowserGetList)
+const PluginSectionView *PluginBrowserGetSections(void);
+
 // Get plugin at index
 const PluginInfo *PluginBrowserGetPlugin(int index);
 
 // Find plugin by name
 const PluginInfo *PluginBrowserFindPlugin(const char *name);
 
-// Install a plugin to device
-// Returns true if operation started successfully
+// Queue a plugin install to device, or an update of a stale one
+// Up-to-date plugins are skipped; stale ones send only changed blocks when
+// delta sync is available. Requests made while a batch is running join it:
+// the batch remounts, syncs and restarts the service once for all items.
+// Returns true if the request was queued
 bool PluginBrowserInstall(const char *pluginName);
 
-// Uninstall a plugin from device
+// Queue a plugin uninstall from device (batched like installs)
 bool PluginBrowserUninstall(const char *pluginName);
 
-// Get current operation state
+// Number of plugins a batch transfers at once (1..PLUGIN_MAX_STREAMS)
+void PluginBrowserSetStreams(int streams);
+
+// Choose how batches apply their changes (default PLUGIN_RELOAD_HOT)
+// Hot reload needs a host listening on SSH_RELOAD_FIFO; without one the
+// files are still installed and take effect on the next restart.
+void PluginBrowserSetReloadMode(PluginReloadMode mode);
+
+// Number of requests waiting behind the running one
+int PluginBrowserQueuedCount(void);
+
+// Pop the next per-item result (UI thread, lock-free). Returns false when
+// none are left. Results from one transfer stream arrive in order.
+bool PluginBrowserPollResult(PluginOpResult *out);
+
+// Get a consistent snapshot of the operation state (UI thread, lock-free;
+// never waits on the workers). Valid until the next call, so take it once
+// per frame.
 const PluginOpState *PluginBrowserGetOpState(void);
 
-// Check if an operation is in progress
+// Check if an install/uninstall batch is running (refreshes don't count;
+// lock-free)
 bool PluginBrowserIsBusy(void);
 
 // Format file size as human-readable string
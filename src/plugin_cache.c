@@ -0,0 +1,228 @@
+#include "plugin_cache.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// Plugin Cache Implementation
+// ============================================================================
+//
+// Layout (host byte order; the file never leaves this machine):
+//   "SLMC" u32 version u32 count
+//   str localDir, str host, str deviceId
+//   count x { str name, str localPath, str remotePath,
+//             i64 localSize, remoteSize, localMtime, remoteMtime,
+//             u8 status, u8 syncState, u8 hashFlags,
+//             [32] localHash if flag 1, [32] remoteHash if flag 2 }
+// where str is a u16 length followed by the bytes.
+
+#define CACHE_MAGIC "SLMC"
+#define CACHE_VERSION 1
+#define CACHE_FILE_NAME "inventory.bin"
+#define CACHE_MAX_ENTRIES 100000
+
+#define HASH_FLAG_LOCAL  1
+#define HASH_FLAG_REMOTE 2
+
+bool PluginCacheDefaultPath(char *path, size_t pathSize) {
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    int n;
+    if (xdg && xdg[0] == '/') {
+        n = snprintf(path, pathSize, "%s/salamander/%s", xdg, CACHE_FILE_NAME);
+    } else if (home && home[0]) {
+        n = snprintf(path, pathSize, "%s/.cache/salamander/%s", home, CACHE_FILE_NAME);
+    } else {
+        return false;
+    }
+    return n > 0 && (size_t)n < pathSize;
+}
+
+// mkdir -p for the directory part of path
+static bool MakeParentDirs(const char *path) {
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (!slash || slash == dir) return true;
+    *slash = '\0';
+
+    for (char *p = dir + 1; ; p++) {
+        if (*p == '/' || *p == '\0') {
+            char saved = *p;
+            *p = '\0';
+            if (mkdir(dir, 0700) != 0 && errno != EEXIST) return false;
+            *p = saved;
+            if (saved == '\0') break;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Encoding helpers
+// ============================================================================
+
+static bool WriteString(FILE *fp, const char *str) {
+    size_t len = strlen(str);
+    if (len > UINT16_MAX) len = UINT16_MAX;
+    uint16_t len16 = (uint16_t)len;
+    return fwrite(&len16, sizeof(len16), 1, fp) == 1 && fwrite(str, 1, len, fp) == len;
+}
+
+static bool ReadString(FILE *fp, char *buffer, size_t bufSize) {
+    uint16_t len;
+    if (fread(&len, sizeof(len), 1, fp) != 1 || len >= bufSize) return false;
+    if (fread(buffer, 1, len, fp) != len) return false;
+    buffer[len] = '\0';
+    return true;
+}
+
+static int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// 64 lowercase hex chars -> 32 bytes (false if hex isn't a full digest)
+static bool HexToDigest(const char *hex, uint8_t digest[32]) {
+    for (int i = 0; i < 32; i++) {
+        int hi = HexValue(hex[i * 2]);
+        int lo = hi >= 0 ? HexValue(hex[i * 2 + 1]) : -1;
+        if (lo < 0) return false;
+        digest[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return hex[64] == '\0';
+}
+
+static void DigestToHex(const uint8_t digest[32], char hex[65]) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < 32; i++) {
+        hex[i * 2] = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 0xf];
+    }
+    hex[64] = '\0';
+}
+
+// ============================================================================
+// Save / Load
+// ============================================================================
+
+static bool WriteEntry(FILE *fp, const PluginInfo *p) {
+    uint8_t localDigest[32], remoteDigest[32];
+    uint8_t flags = 0;
+    if (HexToDigest(p->detail->localHash, localDigest)) flags |= HASH_FLAG_LOCAL;
+    if (HexToDigest(p->detail->remoteHash, remoteDigest)) flags |= HASH_FLAG_REMOTE;
+
+    int64_t numbers[4] = {p->localSize, p->remoteSize, p->localMtime, p->remoteMtime};
+    uint8_t state[3] = {(uint8_t)p->status, (uint8_t)p->syncState, flags};
+
+    return WriteString(fp, p->name) && WriteString(fp, p->localPath) && WriteString(fp, p->remotePath) &&
+           fwrite(numbers, sizeof(numbers), 1, fp) == 1 &&
+           fwrite(state, sizeof(state), 1, fp) == 1 &&
+           (!(flags & HASH_FLAG_LOCAL) || fwrite(localDigest, 32, 1, fp) == 1) &&
+           (!(flags & HASH_FLAG_REMOTE) || fwrite(remoteDigest, 32, 1, fp) == 1);
+}
+
+bool PluginCacheSave(const char *path, const PluginList *list, const PluginCacheMeta *meta) {
+    if (!MakeParentDirs(path)) {
+        printf("Plugins: Cannot create cache directory for %s\n", path);
+        return false;
+    }
+
+    char tmpPath[1100];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE *fp = fopen(tmpPath, "wb");
+    if (!fp) {
+        printf("Plugins: Cannot write cache %s\n", tmpPath);
+        return false;
+    }
+
+    uint32_t header[2] = {CACHE_VERSION, (uint32_t)list->count};
+    bool ok = fwrite(CACHE_MAGIC, 4, 1, fp) == 1 &&
+              fwrite(header, sizeof(header), 1, fp) == 1 &&
+              WriteString(fp, meta->localDir) &&
+              WriteString(fp, meta->host) &&
+              WriteString(fp, meta->deviceId);
+    for (int i = 0; ok && i < list->count; i++) {
+        ok = WriteEntry(fp, &list->plugins[i]);
+    }
+
+    if (fclose(fp) != 0) ok = false;
+    if (!ok || rename(tmpPath, path) != 0) {
+        printf("Plugins: Failed to write cache %s\n", path);
+        unlink(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+static bool ReadEntry(FILE *fp, PluginList *list) {
+    char name[PLUGIN_NAME_MAX];
+    char localPath[1024];
+    char remotePath[1024];
+    int64_t numbers[4];
+    uint8_t state[3];
+    uint8_t digest[32];
+
+    if (!ReadString(fp, name, sizeof(name)) || name[0] == '\0' ||
+        !ReadString(fp, localPath, sizeof(localPath)) ||
+        !ReadString(fp, remotePath, sizeof(remotePath)) ||
+        fread(numbers, sizeof(numbers), 1, fp) != 1 ||
+        fread(state, sizeof(state), 1, fp) != 1 ||
+        state[0] > PLUGIN_DEVICE_ONLY || state[1] > PLUGIN_SYNC_STALE) {
+        return false;
+    }
+
+    PluginInfo *p = PluginListFindOrAdd(list, name);
+    if (!p) return false;
+    p->localPath = PluginListIntern(list, localPath);
+    p->remotePath = PluginListIntern(list, remotePath);
+    p->localSize = (long)numbers[0];
+    p->remoteSize = (long)numbers[1];
+    p->localMtime = (long)numbers[2];
+    p->remoteMtime = (long)numbers[3];
+    p->status = (PluginStatus)state[0];
+    p->syncState = (PluginSyncState)state[1];
+
+    if (state[2] & HASH_FLAG_LOCAL) {
+        if (fread(digest, 32, 1, fp) != 1) return false;
+        DigestToHex(digest, p->detail->localHash);
+    }
+    if (state[2] & HASH_FLAG_REMOTE) {
+        if (fread(digest, 32, 1, fp) != 1) return false;
+        DigestToHex(digest, p->detail->remoteHash);
+    }
+    return true;
+}
+
+bool PluginCacheLoad(const char *path, PluginList *list, PluginCacheMeta *meta) {
+    PluginListReset(list);
+    memset(meta, 0, sizeof(*meta));
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    char magic[4];
+    uint32_t header[2];
+    bool ok = fread(magic, 4, 1, fp) == 1 && memcmp(magic, CACHE_MAGIC, 4) == 0 &&
+              fread(header, sizeof(header), 1, fp) == 1 &&
+              header[0] == CACHE_VERSION && header[1] <= CACHE_MAX_ENTRIES &&
+              ReadString(fp, meta->localDir, sizeof(meta->localDir)) &&
+              ReadString(fp, meta->host, sizeof(meta->host)) &&
+              ReadString(fp, meta->deviceId, sizeof(meta->deviceId));
+    for (uint32_t i = 0; ok && i < header[1]; i++) {
+        ok = ReadEntry(fp, list);
+    }
+    fclose(fp);
+
+    if (!ok) {
+        printf("Plugins: Ignoring unreadable cache %s\n", path);
+        PluginListReset(list);
+        memset(meta, 0, sizeof(*meta));
+    }
+    return ok;
+}
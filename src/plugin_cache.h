@@ -0,0 +1,36 @@
+#ifndef PLUGIN_CACHE_H
+#define PLUGIN_CACHE_H
+
+#include "plugin_registry.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// Plugin Cache - Last known inventory persisted between launches
+// ============================================================================
+//
+// A compact binary snapshot of the merged plugin list (paths, sizes, mtimes
+// and hashes on both sides) plus what it was scanned against. Stored under
+// $XDG_CACHE_HOME/salamander (or ~/.cache/salamander) and replaced
+// atomically, so a crash mid-write leaves the previous file in place.
+
+#define PLUGIN_CACHE_ID_MAX 128
+
+// What a cached inventory describes
+typedef struct {
+    char localDir[512];                 // Local plugin directory scanned
+    char host[PLUGIN_CACHE_ID_MAX];     // Device address
+    char deviceId[PLUGIN_CACHE_ID_MAX]; // Device identity ("" if never seen)
+} PluginCacheMeta;
+
+// Default cache file path (false if no cache directory can be determined)
+bool PluginCacheDefaultPath(char *path, size_t pathSize);
+
+// Write list and meta to path, creating the directory if needed
+bool PluginCacheSave(const char *path, const PluginList *list, const PluginCacheMeta *meta);
+
+// Replace list with the cached one (false if missing, corrupt or from
+// another version; list is left empty then)
+bool PluginCacheLoad(const char *path, PluginList *list, PluginCacheMeta *meta);
+
+#endif // PLUGIN_CACHE_H
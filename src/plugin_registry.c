@@ -0,0 +1,261 @@
+#include "plugin_registry.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// ============================================================================
+// Plugin Registry Implementation
+// ============================================================================
+
+#define ARENA_BLOCK_SIZE 16384
+#define INITIAL_CAPACITY 32
+
+struct PluginArenaBlock {
+    PluginArenaBlock *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+// ============================================================================
+// Arena
+// ============================================================================
+
+static char *ArenaAlloc(PluginList *list, size_t len) {
+    // Walk forward through blocks kept from earlier fills before growing
+    PluginArenaBlock *block = list->arenaCurrent;
+    while (block && block->size - block->used < len) {
+        block = block->next;
+        if (block) block->used = 0;
+    }
+
+    if (!block) {
+        size_t size = len > ARENA_BLOCK_SIZE ? len : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(PluginArenaBlock) + size);
+        if (!block) return NULL;
+        block->size = size;
+        block->used = 0;
+        block->next = NULL;
+        if (list->arenaCurrent) {
+            // Splice in after the current block so any blocks left over
+            // from earlier fills stay reachable for the next reset
+            block->next = list->arenaCurrent->next;
+            list->arenaCurrent->next = block;
+        } else {
+            block->next = list->arena;
+            list->arena = block;
+        }
+    }
+
+    list->arenaCurrent = block;
+    char *ptr = block->data + block->used;
+    block->used += len;
+    return ptr;
+}
+
+const char *PluginListIntern(PluginList *list, const char *str) {
+    if (!str || !str[0]) return "";
+    size_t len = strlen(str) + 1;
+    char *copy = ArenaAlloc(list, len);
+    if (!copy) {
+        printf("Plugins: Out of memory storing \"%s\"\n", str);
+        return "";
+    }
+    memcpy(copy, str, len);
+    return copy;
+}
+
+// ============================================================================
+// Name Index
+// ============================================================================
+
+// FNV-1a
+static uint32_t HashName(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void IndexInsert(int *index, int capacity, const char *name, int slot) {
+    uint32_t mask = (uint32_t)capacity - 1;
+    uint32_t pos = HashName(name) & mask;
+    while (index[pos] >= 0) {
+        pos = (pos + 1) & mask;
+    }
+    index[pos] = slot;
+}
+
+static bool RebuildIndex(PluginList *list, int capacity) {
+    int *index = malloc((size_t)capacity * sizeof(int));
+    if (!index) return false;
+    memset(index, 0xff, (size_t)capacity * sizeof(int));  // All -1
+    for (int i = 0; i < list->count; i++) {
+        IndexInsert(index, capacity, list->plugins[i].name, i);
+    }
+    free(list->index);
+    list->index = index;
+    list->indexCapacity = capacity;
+    return true;
+}
+
+// ============================================================================
+// List
+// ============================================================================
+
+// Convert plugin name to display name (now_playing -> Now Playing)
+static void MakeDisplayName(const char *name, char *display, size_t maxLen) {
+    size_t outIdx = 0;
+    bool capitalizeNext = true;
+
+    for (size_t i = 0; name[i] && outIdx < maxLen - 1; i++) {
+        char c = name[i];
+        if (c == '_') {
+            display[outIdx++] = ' ';
+            capitalizeNext = true;
+        } else if (capitalizeNext && isalpha((unsigned char)c)) {
+            display[outIdx++] = (char)toupper((unsigned char)c);
+            capitalizeNext = false;
+        } else {
+            display[outIdx++] = c;
+            capitalizeNext = false;
+        }
+    }
+    display[outIdx] = '\0';
+}
+
+static bool Reserve(PluginList *list, int count) {
+    if (count > list->capacity) {
+        int capacity = list->capacity ? list->capacity : INITIAL_CAPACITY;
+        while (capacity < count) capacity *= 2;
+        PluginInfo *plugins = realloc(list->plugins, (size_t)capacity * sizeof(PluginInfo));
+        if (!plugins) return false;
+        list->plugins = plugins;
+        PluginDetail *details = realloc(list->details, (size_t)capacity * sizeof(PluginDetail));
+        if (!details) return false;
+        list->details = details;
+        list->capacity = capacity;
+        for (int i = 0; i < list->count; i++) {
+            plugins[i].detail = &details[i];
+        }
+    }
+    // Keep the index at most half full
+    if (count * 2 > list->indexCapacity) {
+        int capacity = list->indexCapacity ? list->indexCapacity : INITIAL_CAPACITY * 2;
+        while (count * 2 > capacity) capacity *= 2;
+        if (!RebuildIndex(list, capacity)) return false;
+    }
+    return true;
+}
+
+void PluginListReset(PluginList *list) {
+    list->count = 0;
+    if (list->index) {
+        memset(list->index, 0xff, (size_t)list->indexCapacity * sizeof(int));
+    }
+    list->arenaCurrent = list->arena;
+    if (list->arena) list->arena->used = 0;
+}
+
+void PluginListFree(PluginList *list) {
+    PluginArenaBlock *block = list->arena;
+    while (block) {
+        PluginArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(list->plugins);
+    free(list->details);
+    free(list->index);
+    memset(list, 0, sizeof(*list));
+}
+
+bool PluginListCopy(PluginList *dst, const PluginList *src) {
+    PluginListReset(dst);
+    if (!Reserve(dst, src->count)) {
+        printf("Plugins: Out of memory copying plugin list\n");
+        return false;
+    }
+
+    for (int i = 0; i < src->count; i++) {
+        PluginInfo *p = &dst->plugins[i];
+        *p = src->plugins[i];
+        p->name = PluginListIntern(dst, p->name);
+        p->displayName = PluginListIntern(dst, p->displayName);
+        p->localPath = PluginListIntern(dst, p->localPath);
+        p->remotePath = PluginListIntern(dst, p->remotePath);
+        p->detail = &dst->details[i];
+    }
+    if (src->count > 0) {
+        memcpy(dst->details, src->details, (size_t)src->count * sizeof(PluginDetail));
+    }
+    dst->count = src->count;
+
+    // Same names in the same slots, so the probe layout carries over
+    if (dst->indexCapacity == src->indexCapacity && src->index) {
+        memcpy(dst->index, src->index, (size_t)src->indexCapacity * sizeof(int));
+    } else if (dst->indexCapacity > 0) {
+        RebuildIndex(dst, dst->indexCapacity);
+    }
+    return true;
+}
+
+PluginInfo *PluginListFind(const PluginList *list, const char *name) {
+    if (list->count == 0) return NULL;
+
+    uint32_t mask = (uint32_t)list->indexCapacity - 1;
+    uint32_t pos = HashName(name) & mask;
+    while (list->index[pos] >= 0) {
+        PluginInfo *p = &list->plugins[list->index[pos]];
+        if (strcmp(p->name, name) == 0) return p;
+        pos = (pos + 1) & mask;
+    }
+    return NULL;
+}
+
+PluginInfo *PluginListFindOrAdd(PluginList *list, const char *name) {
+    PluginInfo *p = PluginListFind(list, name);
+    if (p) return p;
+
+    if (!Reserve(list, list->count + 1)) {
+        printf("Plugins: Out of memory adding %s\n", name);
+        return NULL;
+    }
+
+    char display[PLUGIN_NAME_MAX];
+    MakeDisplayName(name, display, sizeof(display));
+
+    int slot = list->count++;
+    p = &list->plugins[slot];
+    memset(p, 0, sizeof(*p));
+    p->detail = &list->details[slot];
+    memset(p->detail, 0, sizeof(*p->detail));
+    p->name = PluginListIntern(list, name);
+    p->displayName = PluginListIntern(list, display);
+    p->localPath = "";
+    p->remotePath = "";
+    p->status = PLUGIN_LOCAL_ONLY;
+    IndexInsert(list->index, list->indexCapacity, p->name, slot);
+    return p;
+}
+
+void PluginListFilter(PluginList *list, bool (*keep)(PluginInfo *p)) {
+    int kept = 0;
+    for (int i = 0; i < list->count; i++) {
+        if (!keep(&list->plugins[i])) continue;
+        if (kept != i) {
+            list->plugins[kept] = list->plugins[i];
+            list->details[kept] = list->details[i];
+            list->plugins[kept].detail = &list->details[kept];
+        }
+        kept++;
+    }
+    if (kept != list->count) {
+        list->count = kept;
+        RebuildIndex(list, list->indexCapacity);
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef PLUGIN_REGISTRY_H
+#define PLUGIN_REGISTRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "elf_check.h"
+
+// ============================================================================
+// Plugin Registry - Growable plugin list with O(1) name lookup
+// ============================================================================
+//
+// Entries live in one growable array; a name -> index hash map makes lookups
+// constant time. Strings (names, paths) are copied into a per-list arena, so
+// memory tracks the real string lengths and the whole list is released or
+// reused in one go. String fields are never NULL: absent ones point at "".
+
+// Longest plugin file name handled anywhere (matches NAME_MAX)
+#define PLUGIN_NAME_MAX 256
+
+// Plugin installation status
+typedef enum {
+    PLUGIN_LOCAL_ONLY,      // Only on local machine
+    PLUGIN_INSTALLED,       // On both local and device
+    PLUGIN_DEVICE_ONLY      // Only on device (unknown plugin)
+} PluginStatus;
+
+// Content comparison for plugins on both sides
+typedef enum {
+    PLUGIN_SYNC_UNKNOWN,    // Not on both sides, or no hashes to compare
+    PLUGIN_SYNC_UP_TO_DATE, // Device has the same bytes as the local build
+    PLUGIN_SYNC_STALE       // Device copy differs from the local build
+} PluginSyncState;
+
+// Per-plugin fields only the sync logic and the detail panel read, kept out
+// of the hot array the UI walks every frame
+typedef struct {
+    char localHash[65];        // SHA-256 hex (local)
+    char remoteHash[65];       // SHA-256 hex on device (empty if hashing disabled)
+    char localSizeText[16];    // localSize formatted for display
+    char remoteSizeText[16];   // remoteSize formatted for display
+    ElfPluginInfo elf;         // Validation of the local build (local plugins only)
+} PluginDetail;
+
+// Plugin info structure (strings are owned by the list's arena)
+typedef struct {
+    const char *name;          // Plugin name (without .so extension)
+    const char *displayName;   // Human-readable name
+    const char *localPath;     // Full path on local machine ("" if not local)
+    const char *remotePath;    // Full path on device ("" if not on device)
+    long localSize;            // File size in bytes (local)
+    long remoteSize;           // File size in bytes (device)
+    long localMtime;           // Modification time, seconds since epoch (local)
+    long remoteMtime;          // Modification time, seconds since epoch (device)
+    PluginStatus status;       // Installation status
+    PluginSyncState syncState; // Content comparison (installed plugins only)
+    PluginDetail *detail;      // Cold fields, in the list's details[] (same slot)
+} PluginInfo;
+
+typedef struct PluginArenaBlock PluginArenaBlock;
+
+// Plugin list (zero-initialized is an empty list)
+typedef struct {
+    PluginInfo *plugins;
+    PluginDetail *details;     // Parallel to plugins
+    int count;
+    int capacity;
+    int *index;                // Open-addressed name hash -> plugins[] slot, -1 = empty
+    int indexCapacity;         // Power of two
+    PluginArenaBlock *arena;   // String storage, reused across resets
+    PluginArenaBlock *arenaCurrent;
+} PluginList;
+
+// Empty the list, keeping its memory for the next fill
+void PluginListReset(PluginList *list);
+
+// Release all memory held by the list (leaves an empty list)
+void PluginListFree(PluginList *list);
+
+// Make dst a deep copy of src (dst's strings are its own)
+bool PluginListCopy(PluginList *dst, const PluginList *src);
+
+// Find plugin by name (NULL if absent)
+PluginInfo *PluginListFind(const PluginList *list, const char *name);
+
+// Find plugin by name, adding a LOCAL_ONLY entry if absent
+// Returns NULL only when out of memory. Pointers into the list (detail
+// included) stay valid until the next add, remove or reset.
+PluginInfo *PluginListFindOrAdd(PluginList *list, const char *name);
+
+// Keep only the entries keep() returns true for
+void PluginListFilter(PluginList *list, bool (*keep)(PluginInfo *p));
+
+// Copy a string into the list's arena (returns "" when out of memory)
+const char *PluginListIntern(PluginList *list, const char *str);
+
+#endif // PLUGIN_REGISTRY_H
@@ -0,0 +1,278 @@
+#include "prestage.h"
+#include "plugin_browser.h"
+#include "ssh_manager.h"
+#include "file_hasher.h"
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+// ============================================================================
+// Prestage Implementation
+// ============================================================================
+
+typedef struct {
+    char name[PLUGIN_NAME_MAX];
+    char hex[SHA256_HEX_SIZE];      // Contents of the staged copy
+} StagedUpload;
+
+static PrestageMode g_mode = PRESTAGE_OFF;
+
+// Worker state and the latest hint (guarded by g_mutex). A hint is acted on
+// once, when g_handled catches up with g_generation.
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond;
+static pthread_t g_thread;
+static bool g_running = false;
+static bool g_stopping = false;
+static char g_hintName[PLUGIN_NAME_MAX] = "";
+static char g_hintPath[1024] = "";
+static bool g_hintImmediate = false;
+static unsigned int g_generation = 0;
+static unsigned int g_handled = 0;
+
+// Raised by PrestageCancel, watched by the transfer (SshBindCancelFlag)
+static int g_cancel = 0;
+
+// Uploads on the device, oldest first (guarded by g_mutex)
+static StagedUpload g_staged[PRESTAGE_MAX_STAGED];
+static int g_stagedCount = 0;
+
+// Staging directory emptied and created this session (worker thread only)
+static bool g_stagingReady = false;
+
+void PrestageSetMode(PrestageMode mode) {
+    __atomic_store_n(&g_mode, mode, __ATOMIC_RELEASE);
+}
+
+PrestageMode PrestageGetMode(void) {
+    return __atomic_load_n(&g_mode, __ATOMIC_ACQUIRE);
+}
+
+static bool IsIdle(void) {
+    return !PluginBrowserIsBusy() && !PluginBrowserIsRefreshing();
+}
+
+static void StagedPath(const char *pluginName, char *path, size_t size) {
+    snprintf(path, size, "%s/%s.so", SSH_STAGING_PATH, pluginName);
+}
+
+// Caller holds g_mutex
+static int FindStaged(const char *pluginName) {
+    for (int i = 0; i < g_stagedCount; i++) {
+        if (strcmp(g_staged[i].name, pluginName) == 0) return i;
+    }
+    return -1;
+}
+
+// Caller holds g_mutex
+static void DropStaged(int i) {
+    memmove(&g_staged[i], &g_staged[i + 1], sizeof(StagedUpload) * (size_t)(g_stagedCount - i - 1));
+    g_stagedCount--;
+}
+
+// Upload to the staging directory, giving up if a real operation starts
+static void Upload(const char *pluginName, const char *localPath, const char *hex) {
+    if (!g_stagingReady) {
+        // Whatever an earlier session left there is unknown: start empty
+        if (!SshPrepareWrite(SSH_STAGING_PATH)) {
+            printf("Prestage: Cannot create %s on the device\n", SSH_STAGING_PATH);
+            return;
+        }
+        SshExecute("rm -f '" SSH_STAGING_PATH "'/*");
+        g_stagingReady = true;
+    }
+
+    char stagedPath[512];
+    StagedPath(pluginName, stagedPath, sizeof(stagedPath));
+    SshBindCancelFlag(&g_cancel);
+    bool ok = SshCopyToDevice(localPath, stagedPath, NULL, NULL);
+    SshBindCancelFlag(NULL);
+    if (!ok) {
+        bool cancelled = __atomic_load_n(&g_cancel, __ATOMIC_ACQUIRE);
+        printf("Prestage: %s not staged%s\n", pluginName, cancelled ? " (cancelled)" : "");
+        return;
+    }
+
+    // Recorded with the hash from before the copy; if the build changed in
+    // between, the check in PrestagePromote catches it
+    char evicted[PLUGIN_NAME_MAX] = "";
+    pthread_mutex_lock(&g_mutex);
+    int i = FindStaged(pluginName);
+    if (i >= 0) DropStaged(i);
+    if (g_stagedCount == PRESTAGE_MAX_STAGED) {
+        snprintf(evicted, sizeof(evicted), "%s", g_staged[0].name);
+        DropStaged(0);
+    }
+    snprintf(g_staged[g_stagedCount].name, PLUGIN_NAME_MAX, "%s", pluginName);
+    snprintf(g_staged[g_stagedCount].hex, SHA256_HEX_SIZE, "%s", hex);
+    g_stagedCount++;
+    pthread_mutex_unlock(&g_mutex);
+
+    if (evicted[0]) {
+        StagedPath(evicted, stagedPath, sizeof(stagedPath));
+        SshDeleteFile(stagedPath);
+    }
+    printf("Prestage: Staged %s on the device\n", pluginName);
+}
+
+static void Prepare(const char *pluginName, const char *localPath) {
+    char hex[SHA256_HEX_SIZE];
+    if (!FileHasherHash(localPath, hex)) return;
+
+    pthread_mutex_lock(&g_mutex);
+    int i = FindStaged(pluginName);
+    bool staged = i >= 0 && strcmp(g_staged[i].hex, hex) == 0;
+    pthread_mutex_unlock(&g_mutex);
+    if (staged) return;
+
+    TRACE_SCOPE("Prestage", TRACE_CAT_OP);
+    SshPrecompress(localPath);
+    if (PrestageGetMode() == PRESTAGE_UPLOAD && SshGetStatus() == SSH_STATUS_CONNECTED &&
+        !__atomic_load_n(&g_cancel, __ATOMIC_ACQUIRE)) {
+        Upload(pluginName, localPath, hex);
+    }
+}
+
+static void *PrestageThread(void *arg) {
+    (void)arg;
+    TraceNameThread("prestage");
+    // Linux nice values are per thread; gzip and ssh started from here inherit it
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), PRESTAGE_NICE);
+
+    pthread_mutex_lock(&g_mutex);
+    while (!g_stopping) {
+        if (g_handled == g_generation) {
+            pthread_cond_wait(&g_cond, &g_mutex);
+            continue;
+        }
+
+        // Let the hint settle (a newer one restarts the wait); while an
+        // operation runs, check back at the same pace
+        unsigned int generation = g_generation;
+        if (!g_hintImmediate || !IsIdle()) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            long nsec = deadline.tv_nsec + PRESTAGE_SETTLE_MS * 1000000L;
+            deadline.tv_sec += nsec / 1000000000L;
+            deadline.tv_nsec = nsec % 1000000000L;
+            while (!g_stopping && generation == g_generation &&
+                   pthread_cond_timedwait(&g_cond, &g_mutex, &deadline) != ETIMEDOUT) {
+            }
+            if (g_stopping || generation != g_generation) continue;
+        }
+
+        // Cleared and checked under g_mutex, the same lock PrestageCancel
+        // takes: an operation queued from here on cancels this work
+        __atomic_store_n(&g_cancel, 0, __ATOMIC_RELEASE);
+        if (!IsIdle()) {
+            g_hintImmediate = false;
+            continue;
+        }
+        g_handled = generation;
+        char pluginName[PLUGIN_NAME_MAX], localPath[1024];
+        snprintf(pluginName, sizeof(pluginName), "%s", g_hintName);
+        snprintf(localPath, sizeof(localPath), "%s", g_hintPath);
+        pthread_mutex_unlock(&g_mutex);
+
+        Prepare(pluginName, localPath);
+
+        pthread_mutex_lock(&g_mutex);
+    }
+    pthread_mutex_unlock(&g_mutex);
+    return NULL;
+}
+
+// Caller holds g_mutex
+static bool StartWorker(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&g_thread, NULL, PrestageThread, NULL) != 0) {
+        printf("Prestage: Failed to start worker thread\n");
+        pthread_cond_destroy(&g_cond);
+        return false;
+    }
+    g_running = true;
+    return true;
+}
+
+void PrestageHint(const char *pluginName, const char *localPath, bool immediate) {
+    if (PrestageGetMode() == PRESTAGE_OFF || !pluginName || !localPath || !localPath[0]) return;
+
+    pthread_mutex_lock(&g_mutex);
+    if (g_stopping || (!g_running && !StartWorker())) {
+        pthread_mutex_unlock(&g_mutex);
+        return;
+    }
+    snprintf(g_hintName, sizeof(g_hintName), "%s", pluginName);
+    snprintf(g_hintPath, sizeof(g_hintPath), "%s", localPath);
+    g_hintImmediate = immediate;
+    g_generation++;
+    pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void PrestageCancel(void) {
+    pthread_mutex_lock(&g_mutex);
+    __atomic_store_n(&g_cancel, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_mutex);
+}
+
+bool PrestagePromote(const char *pluginName, const char *localPath, const char *remotePath) {
+    if (PrestageGetMode() != PRESTAGE_UPLOAD) return false;
+
+    // Taken out of the table first, so the worker never evicts it meanwhile
+    StagedUpload staged;
+    pthread_mutex_lock(&g_mutex);
+    int i = FindStaged(pluginName);
+    if (i >= 0) {
+        staged = g_staged[i];
+        DropStaged(i);
+    }
+    pthread_mutex_unlock(&g_mutex);
+    if (i < 0) return false;
+
+    char stagedPath[512];
+    StagedPath(pluginName, stagedPath, sizeof(stagedPath));
+    char hex[SHA256_HEX_SIZE];
+    if (!FileHasherHash(localPath, hex) || strcmp(hex, staged.hex) != 0) {
+        printf("Prestage: %s was rebuilt since it was staged\n", pluginName);
+        SshDeleteFile(stagedPath);
+        return false;
+    }
+    if (!SshPromoteStaged(stagedPath, remotePath, hex)) {
+        printf("Prestage: Staged %s did not check out on the device\n", pluginName);
+        SshDeleteFile(stagedPath);
+        return false;
+    }
+    return true;
+}
+
+void PrestageShutdown(void) {
+    pthread_mutex_lock(&g_mutex);
+    bool running = g_running;
+    g_stopping = true;
+    __atomic_store_n(&g_cancel, 1, __ATOMIC_RELEASE);
+    if (running) pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_mutex);
+    if (!running) return;
+
+    pthread_join(g_thread, NULL);
+    pthread_cond_destroy(&g_cond);
+    g_running = false;
+
+    if (g_stagingReady && SshGetStatus() == SSH_STATUS_CONNECTED) {
+        SshExecute("rm -rf '" SSH_STAGING_PATH "'");
+    }
+    g_stagingReady = false;
+    g_stagedCount = 0;
+}
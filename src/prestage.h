@@ -0,0 +1,48 @@
+#ifndef PRESTAGE_H
+#define PRESTAGE_H
+
+#include <stdbool.h>
+
+// ============================================================================
+// Prestage - Speculative preparation of likely installs
+// ============================================================================
+//
+// The UI hints at what the user is probably about to install (the selected
+// plugin, or one whose drag just started). Once a hint has settled and no
+// refresh or batch is running, a low-priority worker hashes and gzips that
+// build ahead of time and, in PRESTAGE_UPLOAD mode, copies it (checked on
+// the device like any install) into SSH_STAGING_PATH. Installing it is then
+// a hash check and a rename on the device. Any queued operation cancels the
+// work in flight. Off unless a mode is set.
+
+#define PRESTAGE_SETTLE_MS  400     // A hint must hold this long before work starts
+#define PRESTAGE_MAX_STAGED 4       // Uploads kept on the device (oldest removed)
+#define PRESTAGE_NICE       10      // Worker priority, inherited by its gzip and ssh
+
+typedef enum {
+    PRESTAGE_OFF,
+    PRESTAGE_LOCAL,         // Hash and compress on the host only
+    PRESTAGE_UPLOAD         // Also upload to the device's staging directory
+} PrestageMode;
+
+// Choose the mode (default PRESTAGE_OFF); set it before the first hint
+void PrestageSetMode(PrestageMode mode);
+PrestageMode PrestageGetMode(void);
+
+// pluginName (built at localPath) is likely to be installed next. Each hint
+// replaces the last; immediate skips the settle delay (a drag has started).
+// Called from the UI thread, never blocks on work.
+void PrestageHint(const char *pluginName, const char *localPath, bool immediate);
+
+// A real operation is starting: stop any speculative transfer now
+void PrestageCancel(void);
+
+// Install pluginName from staging if what is staged still matches the build
+// at localPath: check it on the device and rename it to remotePath. False
+// means nothing usable was staged and the caller should copy as usual.
+bool PrestagePromote(const char *pluginName, const char *localPath, const char *remotePath);
+
+// Stop the worker and remove this session's uploads from the device
+void PrestageShutdown(void);
+
+#endif // PRESTAGE_H
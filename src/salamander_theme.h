@@ -40,6 +40,7 @@ static const Color COLOR_CARD_HOVER    = {48, 42, 44, 255};     // Hover state
 #define WINDOW_WIDTH  900
 #define WINDOW_HEIGHT 600
 #define TARGET_FPS    60
+#define IDLE_FPS      5     // Frame rate while idle in --low-power mode
 
 // Header
 #define HEADER_HEIGHT 56
@@ -0,0 +1,157 @@
+#include "sha256.h"
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================================
+// SHA-256 Implementation (FIPS 180-4)
+// ============================================================================
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void ProcessBlock(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 64; i++) {
+        uint32_t S1 = ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + S1 + ch + K[i] + w[i];
+        uint32_t S0 = ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = S0 + maj;
+
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256Init(Sha256Context *ctx) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(ctx->state, initial, sizeof(initial));
+    ctx->length = 0;
+    ctx->blockLen = 0;
+}
+
+void Sha256Update(Sha256Context *ctx, const void *data, size_t len) {
+    const uint8_t *bytes = data;
+    ctx->length += len;
+
+    // Top up a partial block first
+    if (ctx->blockLen > 0) {
+        size_t take = 64 - ctx->blockLen;
+        if (take > len) take = len;
+        memcpy(ctx->block + ctx->blockLen, bytes, take);
+        ctx->blockLen += take;
+        bytes += take;
+        len -= take;
+        if (ctx->blockLen < 64) return;
+        ProcessBlock(ctx->state, ctx->block);
+        ctx->blockLen = 0;
+    }
+
+    // Whole blocks straight from the input
+    while (len >= 64) {
+        ProcessBlock(ctx->state, bytes);
+        bytes += 64;
+        len -= 64;
+    }
+
+    memcpy(ctx->block, bytes, len);
+    ctx->blockLen = len;
+}
+
+void Sha256Final(Sha256Context *ctx, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    uint64_t bitLength = ctx->length * 8;
+
+    // Padding: 0x80, zeros, then the 64-bit big-endian length
+    uint8_t pad[72] = {0x80};
+    size_t padLen = (ctx->blockLen < 56) ? (56 - ctx->blockLen) : (120 - ctx->blockLen);
+    for (int i = 0; i < 8; i++) {
+        pad[padLen + i] = (uint8_t)(bitLength >> (56 - i * 8));
+    }
+    uint64_t length = ctx->length;
+    Sha256Update(ctx, pad, padLen + 8);
+    ctx->length = length;
+
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4]     = (uint8_t)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)ctx->state[i];
+    }
+}
+
+static void DigestToHex(const uint8_t digest[SHA256_DIGEST_SIZE], char hex[SHA256_HEX_SIZE]) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        hex[i * 2] = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 0x0f];
+    }
+    hex[SHA256_HEX_SIZE - 1] = '\0';
+}
+
+void Sha256Hex(const void *data, size_t len, char hex[SHA256_HEX_SIZE]) {
+    Sha256Context ctx;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    Sha256Init(&ctx);
+    Sha256Update(&ctx, data, len);
+    Sha256Final(&ctx, digest);
+    DigestToHex(digest, hex);
+}
+
+bool Sha256File(const char *path, char hex[SHA256_HEX_SIZE]) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        hex[0] = '\0';
+        return false;
+    }
+
+    Sha256Context ctx;
+    Sha256Init(&ctx);
+
+    unsigned char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        Sha256Update(&ctx, buffer, n);
+    }
+
+    bool ok = !ferror(fp);
+    fclose(fp);
+    if (!ok) {
+        hex[0] = '\0';
+        return false;
+    }
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    Sha256Final(&ctx, digest);
+    DigestToHex(digest, hex);
+    return true;
+}
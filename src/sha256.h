@@ -0,0 +1,33 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// SHA-256 - Content hashing for plugin sync (matches `sha256sum` on device)
+// ============================================================================
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_HEX_SIZE    65   // 64 hex chars + terminator
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;        // Total bytes hashed
+    uint8_t block[64];
+    size_t blockLen;
+} Sha256Context;
+
+// Incremental hashing
+void Sha256Init(Sha256Context *ctx);
+void Sha256Update(Sha256Context *ctx, const void *data, size_t len);
+void Sha256Final(Sha256Context *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+// Hash a buffer into lowercase hex
+void Sha256Hex(const void *data, size_t len, char hex[SHA256_HEX_SIZE]);
+
+// Hash a file into lowercase hex (returns false if it can't be read)
+bool Sha256File(const char *path, char hex[SHA256_HEX_SIZE]);
+
+#endif // SHA256_H
@@ -1,79 +1,366 @@
 #include "ssh_manager.h"
+#include "sha256.h"
+#include "file_hasher.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 
 // ============================================================================
 // SSH Manager Implementation using sshpass + popen
 // ============================================================================
 
-static char g_host[256] = SSH_DEFAULT_HOST;
-static char g_user[64] = SSH_DEFAULT_USER;
-static char g_pass[64] = SSH_DEFAULT_PASS;
-static SshConnectionStatus g_status = SSH_STATUS_UNKNOWN;
+// Everything that belongs to one device: calls act on the device bound to
+// the calling thread (SshBindDevice), or on the default device SshInit sets up
+struct SshDevice {
+    char host[256];
+    char user[64];
+    char pass[64];
+    SshConnectionStatus status;     // Atomic: written by workers, read every frame
+
+    // Persistent session (OpenSSH ControlMaster socket shared by every command)
+    bool sessionActive;
+    pthread_mutex_t sessionMutex;
+
+    // Device-side tools (-1 = not checked yet)
+    int remoteRsync;
+    int remoteGunzip;
+    pthread_mutex_t probeMutex;
+
+    // Learned from completed installs; parallel installs share these
+    double linkBps;                 // Measured host -> device rate
+    double inflateBps;              // Device gunzip
+    double compressRatio;           // Compressed / original
+    pthread_mutex_t rateMutex;
+
+    // Device agent (see SshSetAgentBinary); created on first use
+    DeviceAgent *agent;             // Atomic; set once, under agentMutex
+    bool agentFailed;               // Atomic; didn't start, retried on the next session
+    pthread_mutex_t agentMutex;     // Serializes starting and stopping
+};
+
+// Conservative guesses for the CarThing's A53 cores until measured
+#define DEFAULT_INFLATE_BPS (20.0 * 1024 * 1024)
+#define DEFAULT_COMPRESS_RATIO 0.45
+
+static SshDevice g_defaultDevice = {
+    .host = SSH_DEFAULT_HOST,
+    .user = SSH_DEFAULT_USER,
+    .pass = SSH_DEFAULT_PASS,
+    .status = SSH_STATUS_UNKNOWN,
+    .sessionMutex = PTHREAD_MUTEX_INITIALIZER,
+    .remoteRsync = -1,
+    .remoteGunzip = -1,
+    .probeMutex = PTHREAD_MUTEX_INITIALIZER,
+    .inflateBps = DEFAULT_INFLATE_BPS,
+    .compressRatio = DEFAULT_COMPRESS_RATIO,
+    .rateMutex = PTHREAD_MUTEX_INITIALIZER,
+    .agentMutex = PTHREAD_MUTEX_INITIALIZER,
+};
+static __thread SshDevice *t_device = NULL;
+
+// ControlMaster socket. %u/%C are expanded by ssh (local user, hash of
+// host/port/user), which keeps the path short and unique per device.
+static const char g_controlPath[] = "/tmp/salamander-%u-%C";
+
+// Host-side tools (-1 = not checked yet)
+static int g_localRsync = -1;
+static int g_localGzip = -1;
+static pthread_mutex_t g_probeMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Compressed transfers. Host gzip speed is the same for every device.
+static SshCompressMode g_compressMode = SSH_COMPRESS_AUTO;
+static double g_deflateBps = 40.0 * 1024 * 1024;  // Host gzip -6
+static pthread_mutex_t g_deflateMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Payloads gzip'd ahead of time (SshPrecompress), as <sha256>.gz in a
+// private directory made on first use; the newest SSH_GZ_CACHE_MAX are kept
+static char g_gzCacheDir[64] = "";
+static char g_gzCache[SSH_GZ_CACHE_MAX][SHA256_HEX_SIZE];    // Oldest first
+static int g_gzCacheCount = 0;
+static pthread_mutex_t g_gzCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Set by SshBindCancelFlag; checked between chunks of a streamed copy
+static __thread const int *t_cancel = NULL;
+
+// Local salamander-agent build; empty when the agent is off
+static char g_agentBinary[1024] = "";
+
+// Background connection monitor
+static pthread_t g_monitorThread;
+static bool g_monitorRunning = false;
+static bool g_monitorStop = false;
+static bool g_monitorPoked = false;
+static float g_monitorInterval = 5.0f;
+static pthread_mutex_t g_monitorMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_monitorCond;
 
 // SSH options for faster connections (no host key checking, short timeouts)
 #define SSH_OPTS "-o StrictHostKeyChecking=no -o UserKnownHostsFile=/dev/null -o ConnectTimeout=3 -o BatchMode=no"
 
+// Master connection options: stay up between commands, die quickly if the
+// device goes away so clients fall back to a fresh connection
+#define SSH_MASTER_OPTS "-o ControlMaster=yes -o ControlPersist=" SSH_SESSION_PERSIST \
+                        " -o ServerAliveInterval=2 -o ServerAliveCountMax=2"
+
+static SshDevice *CurrentDevice(void) {
+    return t_device ? t_device : &g_defaultDevice;
+}
+
+// New settings mean a possibly different device: forget what was learned
+static void ConfigureDevice(SshDevice *dev, const char *host, const char *user, const char *password) {
+    if (host) snprintf(dev->host, sizeof(dev->host), "%s", host);
+    if (user) snprintf(dev->user, sizeof(dev->user), "%s", user);
+    if (password) snprintf(dev->pass, sizeof(dev->pass), "%s", password);
+    __atomic_store_n(&dev->status, SSH_STATUS_UNKNOWN, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&dev->probeMutex);
+    dev->remoteRsync = -1;
+    dev->remoteGunzip = -1;
+    pthread_mutex_unlock(&dev->probeMutex);
+
+    pthread_mutex_lock(&dev->rateMutex);
+    dev->linkBps = 0.0;
+    dev->inflateBps = DEFAULT_INFLATE_BPS;
+    dev->compressRatio = DEFAULT_COMPRESS_RATIO;
+    pthread_mutex_unlock(&dev->rateMutex);
+
+    __atomic_store_n(&dev->agentFailed, false, __ATOMIC_RELEASE);
+
+    // A transfer pipe whose ssh died must fail the write, not kill the app
+    signal(SIGPIPE, SIG_IGN);
+}
+
 void SshInit(const char *host, const char *user, const char *password) {
-    if (host) strncpy(g_host, host, sizeof(g_host) - 1);
-    if (user) strncpy(g_user, user, sizeof(g_user) - 1);
-    if (password) strncpy(g_pass, password, sizeof(g_pass) - 1);
-    g_status = SSH_STATUS_UNKNOWN;
+    SshDevice *dev = &g_defaultDevice;
+    ConfigureDevice(dev, host, user, password);
 
     printf("SSH: Initialized connection settings:\n");
-    printf("SSH:   Host: %s\n", g_host);
-    printf("SSH:   User: %s\n", g_user);
-    printf("SSH:   Pass: %s\n", g_pass);
+    printf("SSH:   Host: %s\n", dev->host);
+    printf("SSH:   User: %s\n", dev->user);
 }
 
+static void ClearGzCache(void);
+
 void SshShutdown(void) {
-    g_status = SSH_STATUS_UNKNOWN;
+    SshMonitorStop();
+    SshBindDevice(NULL);
+    SshSessionClose();
+    ClearGzCache();
+    __atomic_store_n(&g_defaultDevice.status, SSH_STATUS_UNKNOWN, __ATOMIC_RELEASE);
+}
+
+SshDevice *SshDeviceCreate(const char *host, const char *user, const char *password) {
+    SshDevice *dev = calloc(1, sizeof(SshDevice));
+    if (!dev) return NULL;
+    snprintf(dev->user, sizeof(dev->user), "%s", SSH_DEFAULT_USER);
+    snprintf(dev->pass, sizeof(dev->pass), "%s", SSH_DEFAULT_PASS);
+    pthread_mutex_init(&dev->sessionMutex, NULL);
+    pthread_mutex_init(&dev->probeMutex, NULL);
+    pthread_mutex_init(&dev->rateMutex, NULL);
+    pthread_mutex_init(&dev->agentMutex, NULL);
+    ConfigureDevice(dev, host, user, password);
+    return dev;
+}
+
+void SshDeviceDestroy(SshDevice *device) {
+    if (!device || device == &g_defaultDevice) return;
+
+    SshDevice *previous = t_device;
+    SshBindDevice(device);
+    SshSessionClose();
+    SshBindDevice(previous == device ? NULL : previous);
+
+    pthread_mutex_destroy(&device->sessionMutex);
+    pthread_mutex_destroy(&device->probeMutex);
+    pthread_mutex_destroy(&device->rateMutex);
+    pthread_mutex_destroy(&device->agentMutex);
+    AgentDestroy(device->agent);
+    free(device);
+}
+
+void SshBindDevice(SshDevice *device) {
+    t_device = device;
 }
 
 const char *SshGetHost(void) {
-    return g_host;
+    return CurrentDevice()->host;
 }
 
 const char *SshGetUser(void) {
-    return g_user;
+    return CurrentDevice()->user;
+}
+
+// Status is written by the monitor/worker threads and read every frame
+static void SetStatus(SshConnectionStatus status) {
+    __atomic_store_n(&CurrentDevice()->status, status, __ATOMIC_RELEASE);
 }
 
 SshConnectionStatus SshGetStatus(void) {
-    return g_status;
+    return __atomic_load_n(&CurrentDevice()->status, __ATOMIC_ACQUIRE);
 }
 
 // Build sshpass command prefix
+// Commands attach to the master socket when it exists and silently fall
+// back to a direct connection when it does not
 static void BuildSshpassPrefix(char *buffer, size_t bufSize) {
-    snprintf(buffer, bufSize, "sshpass -p '%s' ssh %s %s@%s",
-             g_pass, SSH_OPTS, g_user, g_host);
+    SshDevice *dev = CurrentDevice();
+    snprintf(buffer, bufSize, "sshpass -p '%s' ssh %s -o ControlMaster=no -o ControlPath='%s' %s@%s",
+             dev->pass, SSH_OPTS, g_controlPath, dev->user, dev->host);
+}
+
+// Wrap a remote command in single quotes for the local shell, escaping any
+// single quotes it contains so commands can use quoting of their own.
+// Returns false (out empty) if it doesn't fit: a shortened command must
+// never run.
+static bool QuoteForShell(const char *in, char *out, size_t outSize) {
+    size_t o = 0;
+    if (outSize) out[0] = '\0';
+    if (outSize < 3) return false;
+    out[o++] = '\'';
+    for (const char *c = in; *c; c++) {
+        size_t need = *c == '\'' ? 4 : 1;
+        if (o + need + 2 > outSize) {     // + closing quote and NUL
+            out[0] = '\0';
+            return false;
+        }
+        if (*c == '\'') {
+            memcpy(out + o, "'\\''", 4);
+        } else {
+            out[o] = *c;
+        }
+        o += need;
+    }
+    out[o++] = '\'';
+    out[o] = '\0';
+    return true;
+}
+
+// Run an ssh control command (-O check / -O exit) against the master socket
+static int RunControlCommand(const char *operation) {
+    SshDevice *dev = CurrentDevice();
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "ssh -o ControlPath='%s' -O %s %s@%s >/dev/null 2>&1",
+             g_controlPath, operation, dev->user, dev->host);
+    int status = system(cmd);
+    return (status == -1) ? -1 : WEXITSTATUS(status);
+}
+
+// ============================================================================
+// Persistent Session
+// ============================================================================
+
+bool SshSessionIsActive(void) {
+    SshDevice *dev = CurrentDevice();
+    pthread_mutex_lock(&dev->sessionMutex);
+    bool active = (RunControlCommand("check") == 0);
+    dev->sessionActive = active;
+    pthread_mutex_unlock(&dev->sessionMutex);
+    return active;
+}
+
+bool SshSessionOpen(void) {
+    SshDevice *dev = CurrentDevice();
+    pthread_mutex_lock(&dev->sessionMutex);
+
+    // Another thread may have opened it while we waited
+    if (RunControlCommand("check") == 0) {
+        dev->sessionActive = true;
+        pthread_mutex_unlock(&dev->sessionMutex);
+        return true;
+    }
+
+    printf("SSH: Opening persistent session to %s@%s...\n", dev->user, dev->host);
+
+    // -f -N: authenticate once, then background the master with no command.
+    // Output goes to /dev/null so the backgrounded process holds no pipes.
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd),
+             "sshpass -p '%s' ssh %s %s -o ControlPath='%s' -f -N %s@%s >/dev/null 2>&1",
+             dev->pass, SSH_OPTS, SSH_MASTER_OPTS, g_controlPath, dev->user, dev->host);
+
+    uint64_t handshake = TraceBegin();
+    int status = system(cmd);
+    dev->sessionActive = (status != -1 && WEXITSTATUS(status) == 0 &&
+                       RunControlCommand("check") == 0);
+    TraceEndArgs("Session open", TRACE_CAT_SSH, handshake, NULL, 0, dev->host);
+
+    if (dev->sessionActive) {
+        printf("SSH: Persistent session established\n");
+        // New master: worth trying an agent that failed on the old one.
+        // (No agentMutex here: starting the agent can open the session.)
+        __atomic_store_n(&dev->agentFailed, false, __ATOMIC_RELEASE);
+    } else {
+        printf("SSH: Could not open persistent session (commands will connect directly)\n");
+    }
+
+    pthread_mutex_unlock(&dev->sessionMutex);
+    return dev->sessionActive;
 }
 
-// Build scp command prefix
-static void BuildScpPrefix(char *buffer, size_t bufSize) {
-    snprintf(buffer, bufSize, "sshpass -p '%s' scp %s",
-             g_pass, SSH_OPTS);
+void SshSessionClose(void) {
+    SshDevice *dev = CurrentDevice();
+
+    // The agent's channel runs over the session; end it cleanly first
+    pthread_mutex_lock(&dev->agentMutex);
+    if (AgentIsAlive(dev->agent)) printf("SSH: Stopping agent\n");
+    AgentStop(dev->agent);
+    pthread_mutex_unlock(&dev->agentMutex);
+
+    pthread_mutex_lock(&dev->sessionMutex);
+    if (dev->sessionActive || RunControlCommand("check") == 0) {
+        printf("SSH: Closing persistent session\n");
+        RunControlCommand("exit");
+    }
+    dev->sessionActive = false;
+    pthread_mutex_unlock(&dev->sessionMutex);
+}
+
+// Open the session on first use; a dead master is detected by the next
+// connection check, and until then commands just connect directly
+static void EnsureSession(void) {
+    SshDevice *dev = CurrentDevice();
+    if (!dev->sessionActive) {
+        SshSessionOpen();
+    }
 }
 
 void SshCheckConnection(void) {
-    g_status = SSH_STATUS_CHECKING;
+    TRACE_SCOPE("Connection check", TRACE_CAT_SSH);
+    SshDevice *dev = CurrentDevice();
+    SetStatus(SSH_STATUS_CHECKING);
+
+    printf("SSH: Checking connection to %s@%s...\n", dev->user, dev->host);
 
-    printf("SSH: Checking connection to %s@%s...\n", g_user, g_host);
+    // The echo below runs over the master, so make sure one is up (or
+    // re-establish it if the device went away and came back)
+    if (!SshSessionIsActive() && !SshSessionOpen()) {
+        printf("SSH: No response (device may be offline or unreachable)\n");
+        SetStatus(SSH_STATUS_DISCONNECTED);
+        return;
+    }
 
     // Quick ping-style check using ssh echo
-    char cmd[512];
-    char sshPrefix[256];
+    char cmd[1024];
+    char sshPrefix[512];
     BuildSshpassPrefix(sshPrefix, sizeof(sshPrefix));
     snprintf(cmd, sizeof(cmd), "%s 'echo ok' 2>/dev/null", sshPrefix);
 
-    printf("SSH: Running: sshpass -p '%s' ssh %s %s@%s 'echo ok'\n", g_pass, SSH_OPTS, g_user, g_host);
-
     FILE *fp = popen(cmd, "r");
     if (!fp) {
         printf("SSH: Failed to execute ssh command\n");
-        g_status = SSH_STATUS_DISCONNECTED;
+        SetStatus(SSH_STATUS_DISCONNECTED);
         return;
     }
 
@@ -81,49 +368,299 @@ void SshCheckConnection(void) {
     if (fgets(output, sizeof(output), fp) != NULL) {
         if (strstr(output, "ok") != NULL) {
             printf("SSH: Connection successful!\n");
-            g_status = SSH_STATUS_CONNECTED;
+            SetStatus(SSH_STATUS_CONNECTED);
         } else {
             printf("SSH: Unexpected response: %s\n", output);
-            g_status = SSH_STATUS_DISCONNECTED;
+            SetStatus(SSH_STATUS_DISCONNECTED);
         }
     } else {
         printf("SSH: No response (device may be offline or unreachable)\n");
-        g_status = SSH_STATUS_DISCONNECTED;
+        SetStatus(SSH_STATUS_DISCONNECTED);
     }
 
     pclose(fp);
 }
 
-SshResult SshExecute(const char *command) {
-    SshResult result = {0};
-    result.success = false;
-    result.exitCode = -1;
+// ============================================================================
+// Background Connection Monitor
+// ============================================================================
 
-    char cmd[2048];
-    char sshPrefix[256];
+// Cheap reachability test: plain TCP connect to the ssh port, no auth
+static bool ProbeTcp(int timeoutMs) {
+    SshDevice *dev = CurrentDevice();
+    struct addrinfo hints = {0};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    char port[8];
+    snprintf(port, sizeof(port), "%d", SSH_DEFAULT_PORT);
+
+    struct addrinfo *addrs = NULL;
+    if (getaddrinfo(dev->host, port, &hints, &addrs) != 0) {
+        return false;
+    }
+
+    bool reachable = false;
+    for (struct addrinfo *ai = addrs; ai && !reachable; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            reachable = true;
+        } else if (errno == EINPROGRESS) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, timeoutMs) == 1) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                reachable = (err == 0);
+            }
+        }
+        close(fd);
+    }
+
+    freeaddrinfo(addrs);
+    return reachable;
+}
+
+// One monitor pass; returns true if the device is connected
+static bool MonitorProbe(void) {
+    SshDevice *dev = CurrentDevice();
+    if (!ProbeTcp(SSH_MONITOR_TCP_TIMEOUT_MS)) {
+        if (SshGetStatus() != SSH_STATUS_DISCONNECTED) {
+            printf("SSH: %s:%d unreachable\n", dev->host, SSH_DEFAULT_PORT);
+        }
+        SetStatus(SSH_STATUS_DISCONNECTED);
+        return false;
+    }
+
+    // Port is open and the master is still up: nothing to authenticate
+    if (SshGetStatus() == SSH_STATUS_CONNECTED && SshSessionIsActive()) {
+        return true;
+    }
+
+    SshCheckConnection();
+    return SshGetStatus() == SSH_STATUS_CONNECTED;
+}
+
+static void *MonitorThread(void *arg) {
+    (void)arg;
+    TraceNameThread("monitor");
+    float delay = 0.0f;  // First probe runs immediately
+
+    pthread_mutex_lock(&g_monitorMutex);
+    while (!g_monitorStop) {
+        if (delay > 0.0f && !g_monitorPoked) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            long nsec = deadline.tv_nsec + (long)((delay - (long)delay) * 1e9f);
+            deadline.tv_sec += (time_t)delay + nsec / 1000000000L;
+            deadline.tv_nsec = nsec % 1000000000L;
+
+            while (!g_monitorStop && !g_monitorPoked &&
+                   pthread_cond_timedwait(&g_monitorCond, &g_monitorMutex, &deadline) != ETIMEDOUT) {
+            }
+            if (g_monitorStop) break;
+        }
+        g_monitorPoked = false;
+        pthread_mutex_unlock(&g_monitorMutex);
+
+        bool connected = MonitorProbe();
+
+        pthread_mutex_lock(&g_monitorMutex);
+        if (connected) {
+            delay = g_monitorInterval;
+        } else {
+            // Exponential backoff while the device is gone
+            delay = (delay < g_monitorInterval) ? g_monitorInterval : delay * 2.0f;
+            if (delay > SSH_MONITOR_MAX_BACKOFF) delay = SSH_MONITOR_MAX_BACKOFF;
+        }
+    }
+    pthread_mutex_unlock(&g_monitorMutex);
+    return NULL;
+}
+
+void SshMonitorStart(float intervalSeconds) {
+    if (g_monitorRunning) return;
+
+    g_monitorInterval = intervalSeconds > 0.0f ? intervalSeconds : 5.0f;
+    g_monitorStop = false;
+    g_monitorPoked = false;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_monitorCond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&g_monitorThread, NULL, MonitorThread, NULL) != 0) {
+        printf("SSH: Failed to start connection monitor\n");
+        pthread_cond_destroy(&g_monitorCond);
+        return;
+    }
+    g_monitorRunning = true;
+}
+
+void SshMonitorStop(void) {
+    if (!g_monitorRunning) return;
+
+    pthread_mutex_lock(&g_monitorMutex);
+    g_monitorStop = true;
+    pthread_cond_signal(&g_monitorCond);
+    pthread_mutex_unlock(&g_monitorMutex);
+
+    // A probe in flight finishes within its timeouts
+    pthread_join(g_monitorThread, NULL);
+    pthread_cond_destroy(&g_monitorCond);
+    g_monitorRunning = false;
+}
+
+void SshMonitorPoke(void) {
+    if (!g_monitorRunning) return;
+
+    pthread_mutex_lock(&g_monitorMutex);
+    g_monitorPoked = true;
+    pthread_cond_signal(&g_monitorCond);
+    pthread_mutex_unlock(&g_monitorMutex);
+}
+
+// ============================================================================
+// Remote Commands
+// ============================================================================
+
+#define SSH_READ_CHUNK 16384
+
+// Make room for at least extra more bytes plus the terminator
+static bool ReserveBuffer(SshBuffer *buffer, size_t extra) {
+    size_t needed = buffer->length + extra + 1;
+    if (needed <= buffer->capacity) return true;
+    size_t capacity = buffer->capacity ? buffer->capacity : SSH_READ_CHUNK;
+    while (capacity < needed) capacity *= 2;
+    char *grown = realloc(buffer->data, capacity);
+    if (!grown) return false;
+    buffer->data = grown;
+    buffer->capacity = capacity;
+    return true;
+}
+
+void SshBufferFree(SshBuffer *buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+// Run a remote command with stdout on a pipe and stderr in a temp file.
+// stdout is read either straight into the free tail of sink, or (sink NULL)
+// into one read block handed to onOutput; stderr goes the same way once the
+// command has exited, into errorSink in buffer mode.
+static int RunRemote(const char *command, SshBuffer *sink, SshBuffer *errorSink,
+                     SshOutputCallback onOutput, void *userData) {
+    char quoted[3072];
+    if (!QuoteForShell(command, quoted, sizeof(quoted))) {
+        printf("SSH: Command too long (%zu bytes), not run\n", strlen(command));
+        return -1;
+    }
+
+    EnsureSession();
+    uint64_t traceStart = TraceBegin();
+
+    char errPath[] = "/tmp/salamander-exec-XXXXXX";
+    int errFd = mkstemp(errPath);
+    if (errFd >= 0) close(errFd);
+
+    char cmd[4096];
+    char sshPrefix[512];
     BuildSshpassPrefix(sshPrefix, sizeof(sshPrefix));
-    snprintf(cmd, sizeof(cmd), "%s '%s' 2>&1", sshPrefix, command);
+    snprintf(cmd, sizeof(cmd), "%s %s 2>'%s'", sshPrefix, quoted,
+             errFd >= 0 ? errPath : "/dev/null");
 
     FILE *fp = popen(cmd, "r");
     if (!fp) {
-        snprintf(result.output, sizeof(result.output), "Failed to execute command");
-        return result;
+        if (errFd >= 0) unlink(errPath);
+        return -1;
     }
 
-    size_t totalRead = 0;
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), fp) != NULL) {
-        size_t len = strlen(buffer);
-        if (totalRead + len < sizeof(result.output) - 1) {
-            strcpy(result.output + totalRead, buffer);
-            totalRead += len;
+    // Raw reads on the descriptor: stdio would buffer everything once more
+    int fd = fileno(fp);
+    bool stopped = false;
+    char block[SSH_READ_CHUNK];
+    for (;;) {
+        ssize_t n;
+        if (sink) {
+            if (!ReserveBuffer(sink, SSH_READ_CHUNK)) break;
+            n = read(fd, sink->data + sink->length, sink->capacity - sink->length - 1);
+            if (n > 0) sink->length += (size_t)n;
+        } else {
+            n = read(fd, block, sizeof(block));
+            if (n > 0 && !onOutput(SSH_STDOUT, block, (size_t)n, userData)) {
+                stopped = true;
+                break;
+            }
         }
+        if (n == 0 || (n < 0 && errno != EINTR)) break;
     }
 
+    // Unread output is discarded; ssh sees a closed pipe and exits
     int status = pclose(fp);
-    result.exitCode = WEXITSTATUS(status);
-    result.success = (result.exitCode == 0);
+    int exitCode = (status == -1 || !WIFEXITED(status)) ? -1 : WEXITSTATUS(status);
 
+    if (errFd >= 0) {
+        int errIn = (sink && !errorSink) || stopped ? -1 : open(errPath, O_RDONLY);
+        unlink(errPath);
+        while (errIn >= 0) {
+            ssize_t n;
+            if (errorSink) {
+                if (!ReserveBuffer(errorSink, SSH_READ_CHUNK)) break;
+                n = read(errIn, errorSink->data + errorSink->length,
+                         errorSink->capacity - errorSink->length - 1);
+                if (n > 0) errorSink->length += (size_t)n;
+            } else {
+                n = read(errIn, block, sizeof(block));
+                if (n > 0 && !onOutput(SSH_STDERR, block, (size_t)n, userData)) break;
+            }
+            if (n == 0 || (n < 0 && errno != EINTR)) break;
+        }
+        if (errIn >= 0) close(errIn);
+    }
+    TraceEndArgs("Remote command", TRACE_CAT_SSH, traceStart, "exit", exitCode, command);
+    return exitCode;
+}
+
+int SshExecuteStream(const char *command, SshOutputCallback onOutput, void *userData) {
+    return RunRemote(command, NULL, NULL, onOutput, userData);
+}
+
+int SshExecuteToBuffer(const char *command, SshBuffer *out, SshBuffer *errors) {
+    out->length = 0;
+    if (errors) errors->length = 0;
+    int exitCode = RunRemote(command, out, errors, NULL, NULL);
+    // Always terminated, even when empty, so callers can parse in place
+    if (ReserveBuffer(out, 0)) out->data[out->length] = '\0';
+    if (errors && ReserveBuffer(errors, 0)) errors->data[errors->length] = '\0';
+    return exitCode;
+}
+
+// Collects both streams into a fixed SshResult, dropping what doesn't fit
+static bool CollectOutput(SshStream stream, const char *data, size_t length, void *userData) {
+    (void)stream;
+    SshResult *result = (SshResult *)userData;
+    size_t used = strlen(result->output);
+    size_t room = sizeof(result->output) - 1 - used;
+    if (length > room) length = room;
+    memcpy(result->output + used, data, length);
+    result->output[used + length] = '\0';
+    return true;
+}
+
+SshResult SshExecute(const char *command) {
+    SshResult result = {0};
+    result.exitCode = SshExecuteStream(command, CollectOutput, &result);
+    result.success = (result.exitCode == 0);
+    if (result.exitCode < 0 && result.output[0] == '\0') {
+        snprintf(result.output, sizeof(result.output), "Failed to execute command");
+    }
     return result;
 }
 
@@ -133,57 +670,730 @@ SshResult SshListDirectory(const char *remotePath) {
     return SshExecute(cmd);
 }
 
-bool SshCopyToDevice(const char *localPath, const char *remotePath,
-                     SshProgressCallback progressCb, void *userData) {
-    // Check if local file exists
-    if (access(localPath, R_OK) != 0) {
-        if (progressCb) progressCb(0.0f, "Local file not found", userData);
-        return false;
+// Run one request on the agent. Returns false if there is no agent or it
+// went away, and the caller should use the shell instead.
+static bool RunAgentRequest(AgentBatch *batch) {
+    DeviceAgent *agent = SshGetAgent();
+    return agent && AgentBatchRun(agent, batch);
+}
+
+// Copy a reply into the caller's buffer the way SshExecuteToBuffer would
+static bool SetBuffer(SshBuffer *buffer, const char *data, size_t length) {
+    buffer->length = 0;
+    if (!ReserveBuffer(buffer, length)) return false;
+    memcpy(buffer->data, data, length);
+    buffer->length = length;
+    buffer->data[length] = '\0';
+    return true;
+}
+
+int SshListInventory(const char *remoteDir, bool withHashes, SshBuffer *out, SshBuffer *errors) {
+    // The agent stats and hashes in-process: no shell, stat or sha256sum
+    AgentBatch batch = {0};
+    AgentAddInventory(&batch, remoteDir, withHashes);
+    if (RunAgentRequest(&batch)) {
+        const AgentReply *reply = &batch.replies[0];
+        int exitCode = 0;
+        if (reply->status != AGENT_OK) {
+            exitCode = 1;
+            if (errors) {
+                const char *message = strerror(reply->status);
+                SetBuffer(errors, message, strlen(message));
+            }
+            SetBuffer(out, "", 0);
+        } else {
+            if (errors) SetBuffer(errors, "", 0);
+            if (!SetBuffer(out, reply->data, reply->length)) exitCode = -1;
+        }
+        AgentBatchFree(&batch);
+        return exitCode;
     }
+    AgentBatchFree(&batch);
 
-    if (progressCb) progressCb(0.1f, "Starting transfer...", userData);
+    // One stat call covers every file; hashing is optional because it reads
+    // every byte on the device's CPU. The I line identifies the device.
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd),
+             "echo \"I $(cat /etc/machine-id 2>/dev/null || hostname)\"; "
+             "cd '%s' 2>/dev/null || exit 0; "
+             "stat -c 'F %%s %%Y %%n' -- *.so 2>/dev/null; "
+             "%s"
+             "exit 0",
+             remoteDir,
+             withHashes ? "sha256sum -- *.so 2>/dev/null | sed 's/^/H /'; " : "");
+    return SshExecuteToBuffer(cmd, out, errors);
+}
 
-    char cmd[2048];
-    char scpPrefix[256];
-    BuildScpPrefix(scpPrefix, sizeof(scpPrefix));
-    snprintf(cmd, sizeof(cmd), "%s '%s' %s@%s:'%s' 2>&1",
-             scpPrefix, localPath, g_user, g_host, remotePath);
+static double MonotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
-    if (progressCb) progressCb(0.3f, "Transferring...", userData);
+// Read the first part of a captured stderr file into buffer
+static void ReadErrorFile(const char *path, char *buffer, size_t bufSize) {
+    buffer[0] = '\0';
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    size_t n = fread(buffer, 1, bufSize - 1, fp);
+    buffer[n] = '\0';
+    fclose(fp);
+    // Keep the message to one line for the progress label
+    char *nl = strchr(buffer, '\n');
+    if (nl) *nl = '\0';
+}
 
-    FILE *fp = popen(cmd, "r");
+// Exit statuses of a streamed copy: ssh's own for a lost connection, the
+// receive command's when the bytes on the device didn't match (or matched
+// only by size, for lack of sha256sum), and ours when the caller's cancel
+// flag stopped it or the command was never run
+#define SSH_EXIT_CONNECTION 255
+#define SSH_EXIT_MISMATCH   86
+#define SSH_EXIT_UNVERIFIED 87
+#define SSH_EXIT_CANCELLED  (-2)
+#define SSH_EXIT_NOT_RUN    (-3)
+
+void SshBindCancelFlag(const int *flag) {
+    t_cancel = flag;
+}
+
+static bool CancelRequested(void) {
+    return t_cancel && __atomic_load_n(t_cancel, __ATOMIC_ACQUIRE);
+}
+
+// Pipe src into remoteCmd on the device (stdin of the remote shell),
+// reporting at most every 100ms. progressScale maps file progress into the
+// caller's range. stats->bytesTotal must be set by the caller, and
+// stats->bytesSent to where src starts. Returns the exit status: 0 on
+// success, SSH_EXIT_CONNECTION (or -1 if the pipe broke) when the link went,
+// SSH_EXIT_CANCELLED if the bound cancel flag was raised, SSH_EXIT_NOT_RUN
+// if remoteCmd didn't fit the ssh command line.
+static int StreamToDevice(FILE *src, const char *remoteCmd, SshTransferStats *stats,
+                          float progressScale, SshProgressCallback progressCb, void *userData,
+                          char *errors, size_t errorsSize) {
+    char quoted[2048];
+    if (!QuoteForShell(remoteCmd, quoted, sizeof(quoted))) {
+        snprintf(errors, errorsSize, "Remote path too long");
+        return SSH_EXIT_NOT_RUN;
+    }
+
+    // ssh's stderr goes to a temp file; stdout of the pipe is ours to write
+    char errPath[] = "/tmp/salamander-xfer-XXXXXX";
+    int errFd = mkstemp(errPath);
+    if (errFd >= 0) close(errFd);
+
+    char cmd[3072];
+    char sshPrefix[512];
+    BuildSshpassPrefix(sshPrefix, sizeof(sshPrefix));
+    snprintf(cmd, sizeof(cmd), "%s %s >/dev/null 2>'%s'", sshPrefix, quoted,
+             errFd >= 0 ? errPath : "/dev/null");
+
+    errors[0] = '\0';
+    FILE *fp = popen(cmd, "w");
     if (!fp) {
-        if (progressCb) progressCb(0.0f, "Transfer failed", userData);
+        if (errFd >= 0) unlink(errPath);
+        snprintf(errors, errorsSize, "Transfer failed");
+        return -1;
+    }
+
+    char buffer[64 * 1024];
+    long startBytes = stats->bytesSent;
+    uint64_t traceStart = TraceBegin();
+    double start = MonotonicSeconds();
+    double lastReport = start;
+    double windowStart = start;
+    long windowBytes = 0;
+    bool writeFailed = false;
+    bool cancelled = false;
+    size_t n;
+
+    while ((n = fread(buffer, 1, sizeof(buffer), src)) > 0) {
+        // Closing early hands the device a short file, which fails its check
+        if (CancelRequested()) {
+            cancelled = true;
+            break;
+        }
+        if (fwrite(buffer, 1, n, fp) != n) {
+            writeFailed = true;
+            break;
+        }
+        stats->bytesSent += (long)n;
+        windowBytes += (long)n;
+
+        double now = MonotonicSeconds();
+        if (now - windowStart >= 0.25) {
+            double rate = windowBytes / (now - windowStart);
+            // Light smoothing so the readout doesn't jitter frame to frame
+            stats->instantBps = stats->instantBps > 0 ? stats->instantBps * 0.5 + rate * 0.5 : rate;
+            windowStart = now;
+            windowBytes = 0;
+        }
+        if (progressCb && now - lastReport >= 0.1) {
+            double elapsed = now - start;
+            stats->averageBps = elapsed > 0 ? (stats->bytesSent - startBytes) / elapsed : 0;
+            double rate = stats->instantBps > 0 ? stats->instantBps : stats->averageBps;
+            stats->etaSeconds = rate > 0 ? (stats->bytesTotal - stats->bytesSent) / rate : -1.0;
+            float progress = stats->bytesTotal > 0 ? (float)stats->bytesSent / stats->bytesTotal : 0.0f;
+            progressCb(progress * progressScale, "Transferring...", stats, userData);
+            lastReport = now;
+        }
+    }
+
+    // Wait for ssh to flush the last bytes and the remote side to finish
+    if (progressCb) progressCb(progressScale, "Finishing...", NULL, userData);
+    int status = pclose(fp);
+    int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+    double elapsed = MonotonicSeconds() - start;
+    stats->averageBps = elapsed > 0 ? (stats->bytesSent - startBytes) / elapsed : 0;
+
+    if (errFd >= 0) {
+        ReadErrorFile(errPath, errors, errorsSize);
+        unlink(errPath);
+    }
+    TraceEndArgs("Stream", TRACE_CAT_SSH, traceStart, "bytes", stats->bytesSent - startBytes, NULL);
+    if (cancelled) return SSH_EXIT_CANCELLED;
+    if (exitCode == 0 && writeFailed) return -1;
+    return exitCode;
+}
+
+// Fold one measurement into a running estimate
+static void UpdateRate(double *estimate, double sample) {
+    if (sample <= 0) return;
+    *estimate = (*estimate > 0) ? *estimate * 0.7 + sample * 0.3 : sample;
+}
+
+// Check for a host tool once (caller holds g_probeMutex)
+static int ProbeLocalTool(int *cached, const char *tool, const char *feature) {
+    if (*cached < 0) {
+        char cmd[128];
+        snprintf(cmd, sizeof(cmd), "command -v %s >/dev/null 2>&1", tool);
+        *cached = (system(cmd) == 0) ? 1 : 0;
+        if (!*cached) printf("SSH: %s not installed locally, %s disabled\n", tool, feature);
+    }
+    return *cached;
+}
+
+// Check for a device tool once per device (caller holds its probeMutex)
+static int ProbeRemoteTool(SshDevice *dev, int *cached, const char *tool, const char *feature) {
+    if (*cached < 0 && SshGetStatus() == SSH_STATUS_CONNECTED) {
+        char cmd[128];
+        snprintf(cmd, sizeof(cmd), "command -v %s >/dev/null 2>&1 && echo yes", tool);
+        SshResult result = SshExecute(cmd);
+        *cached = (result.success && strstr(result.output, "yes") != NULL) ? 1 : 0;
+        if (!*cached) printf("SSH: %s not found on %s, %s disabled\n", tool, dev->host, feature);
+    }
+    return *cached;
+}
+
+// gzip on the host, gunzip on the device (busybox has both)
+// Parallel streams all ask at once, so the probes are serialized
+static bool CompressionAvailable(void) {
+    SshDevice *dev = CurrentDevice();
+    pthread_mutex_lock(&g_probeMutex);
+    bool local = ProbeLocalTool(&g_localGzip, "gzip", "compressed transfers") == 1;
+    pthread_mutex_unlock(&g_probeMutex);
+    if (!local) return false;
+
+    pthread_mutex_lock(&dev->probeMutex);
+    bool remote = ProbeRemoteTool(dev, &dev->remoteGunzip, "gunzip", "compressed transfers") == 1;
+    pthread_mutex_unlock(&dev->probeMutex);
+    return remote;
+}
+
+// Auto mode: compress when the predicted compressed path (compress on the
+// host, then whichever of link or device inflate is slower, since they
+// overlap) beats sending the raw bytes. Until the link has been measured,
+// compress: the USB gadget link is almost always the bottleneck.
+static bool ShouldCompress(long size) {
+    SshDevice *dev = CurrentDevice();
+    if (g_compressMode == SSH_COMPRESS_OFF || size < SSH_COMPRESS_MIN_SIZE) return false;
+    if (!CompressionAvailable()) return false;
+    if (g_compressMode == SSH_COMPRESS_ON) return true;
+
+    pthread_mutex_lock(&dev->rateMutex);
+    bool compress = true;
+    if (dev->linkBps > 0) {
+        double plain = size / dev->linkBps;
+        double sendTime = size * dev->compressRatio / dev->linkBps;
+        double inflateTime = size / dev->inflateBps;
+        pthread_mutex_lock(&g_deflateMutex);
+        double deflateTime = size / g_deflateBps;
+        pthread_mutex_unlock(&g_deflateMutex);
+        double compressed = deflateTime + (sendTime > inflateTime ? sendTime : inflateTime);
+        compress = compressed < plain;
+    }
+    pthread_mutex_unlock(&dev->rateMutex);
+    return compress;
+}
+
+void SshSetCompression(SshCompressMode mode) {
+    g_compressMode = mode;
+}
+
+// Index of hex in the gzip cache, or -1 (caller holds g_gzCacheMutex)
+static int FindGzCache(const char *hex) {
+    for (int i = 0; i < g_gzCacheCount; i++) {
+        if (strcmp(g_gzCache[i], hex) == 0) return i;
+    }
+    return -1;
+}
+
+static void GzCachePath(const char *hex, char *path, size_t size) {
+    snprintf(path, size, "%s/%s.gz", g_gzCacheDir, hex);
+}
+
+// Open the cached gzip of contents hashing to hex, or NULL
+static FILE *OpenGzCache(const char *hex, long *payloadSize) {
+    FILE *src = NULL;
+    pthread_mutex_lock(&g_gzCacheMutex);
+    if (FindGzCache(hex) >= 0) {
+        char path[160];
+        GzCachePath(hex, path, sizeof(path));
+        struct stat gzStat;
+        src = fopen(path, "rb");
+        if (src && fstat(fileno(src), &gzStat) == 0) {
+            *payloadSize = (long)gzStat.st_size;
+        } else if (src) {
+            fclose(src);
+            src = NULL;
+        }
+    }
+    pthread_mutex_unlock(&g_gzCacheMutex);
+    return src;
+}
+
+bool SshPrecompress(const char *localPath) {
+    struct stat st;
+    char hex[SHA256_HEX_SIZE];
+    if (stat(localPath, &st) != 0 || !ShouldCompress((long)st.st_size)) return false;
+    if (!FileHasherHash(localPath, hex)) return false;
+
+    pthread_mutex_lock(&g_gzCacheMutex);
+    if (g_gzCacheDir[0] == '\0') {
+        snprintf(g_gzCacheDir, sizeof(g_gzCacheDir), "/tmp/salamander-gzcache-XXXXXX");
+        if (!mkdtemp(g_gzCacheDir)) g_gzCacheDir[0] = '\0';
+    }
+    bool ready = g_gzCacheDir[0] != '\0';
+    bool cached = ready && FindGzCache(hex) >= 0;
+    char path[160], tmpPath[170];
+    GzCachePath(hex, path, sizeof(path));
+    pthread_mutex_unlock(&g_gzCacheMutex);
+    if (!ready) return false;
+    if (cached) return true;
+
+    // Written aside and renamed, so a reader never sees half a file
+    TRACE_SCOPE("Precompress", TRACE_CAT_LOCAL);
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    char cmd[1400];
+    snprintf(cmd, sizeof(cmd), "gzip -c -6 '%s' > '%s'", localPath, tmpPath);
+    double start = MonotonicSeconds();
+    if (system(cmd) != 0) {
+        unlink(tmpPath);
         return false;
     }
+    double deflateTime = MonotonicSeconds() - start;
 
-    // Read any output (errors)
-    char output[1024] = {0};
-    size_t totalRead = 0;
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), fp) != NULL) {
-        size_t len = strlen(buffer);
-        if (totalRead + len < sizeof(output) - 1) {
-            strcpy(output + totalRead, buffer);
-            totalRead += len;
+    // Rebuilt while compressing: the name would lie about the contents
+    char after[SHA256_HEX_SIZE];
+    if (!FileHasherHash(localPath, after) || strcmp(after, hex) != 0 || rename(tmpPath, path) != 0) {
+        unlink(tmpPath);
+        return false;
+    }
+    pthread_mutex_lock(&g_deflateMutex);
+    UpdateRate(&g_deflateBps, deflateTime > 0 ? st.st_size / deflateTime : 0);
+    pthread_mutex_unlock(&g_deflateMutex);
+
+    pthread_mutex_lock(&g_gzCacheMutex);
+    if (FindGzCache(hex) < 0) {
+        if (g_gzCacheCount == SSH_GZ_CACHE_MAX) {
+            // An open copy keeps reading the unlinked file
+            char oldest[160];
+            GzCachePath(g_gzCache[0], oldest, sizeof(oldest));
+            unlink(oldest);
+            memmove(g_gzCache[0], g_gzCache[1], sizeof(g_gzCache[0]) * (SSH_GZ_CACHE_MAX - 1));
+            g_gzCacheCount--;
         }
+        snprintf(g_gzCache[g_gzCacheCount++], SHA256_HEX_SIZE, "%s", hex);
+    }
+    pthread_mutex_unlock(&g_gzCacheMutex);
+    return true;
+}
+
+static void ClearGzCache(void) {
+    pthread_mutex_lock(&g_gzCacheMutex);
+    for (int i = 0; i < g_gzCacheCount; i++) {
+        char path[160];
+        GzCachePath(g_gzCache[i], path, sizeof(path));
+        unlink(path);
     }
+    g_gzCacheCount = 0;
+    if (g_gzCacheDir[0]) rmdir(g_gzCacheDir);
+    g_gzCacheDir[0] = '\0';
+    pthread_mutex_unlock(&g_gzCacheMutex);
+}
 
-    if (progressCb) progressCb(0.9f, "Finishing...", userData);
+// Agent writes are chunked well below AGENT_MAX_FRAME
+#define SSH_AGENT_CHUNK (64 * 1024)
 
-    int status = pclose(fp);
-    int exitCode = WEXITSTATUS(status);
+// Send a small file as WRITE frames, then rename it into place once every
+// chunk landed. Returns 1 if sent, 0 if the device refused it (error set),
+// -1 if the agent went away (nothing was decided; stream it instead).
+static int WriteViaAgent(DeviceAgent *agent, FILE *src, const char *remotePath,
+                         char *errors, size_t errorsSize) {
+    char partPath[1100];
+    snprintf(partPath, sizeof(partPath), "%s.part", remotePath);
 
-    if (exitCode == 0) {
-        if (progressCb) progressCb(1.0f, "Complete", userData);
-        return true;
+    AgentBatch batch = {0};
+    unsigned char buffer[SSH_AGENT_CHUNK];
+    size_t n;
+    bool append = false;
+    do {
+        n = fread(buffer, 1, sizeof(buffer), src);
+        AgentAddWrite(&batch, partPath, append, buffer, n);
+        append = true;
+    } while (n == sizeof(buffer));
+    if (ferror(src)) {
+        AgentBatchFree(&batch);
+        snprintf(errors, errorsSize, "Could not read local file");
+        return 0;
+    }
+
+    int sent = AgentBatchRun(agent, &batch) ? 1 : -1;
+    for (int i = 0; sent == 1 && i < batch.count; i++) {
+        if (batch.replies[i].status != AGENT_OK) {
+            snprintf(errors, errorsSize, "%s", strerror(batch.replies[i].status));
+            sent = 0;
+        }
+    }
+
+    // The rename waits for the write replies: a chunk that failed (device
+    // full) must not leave a truncated plugin in place
+    AgentBatchReset(&batch);
+    if (sent == 1) {
+        AgentAddRename(&batch, partPath, remotePath);
+        if (!AgentBatchRun(agent, &batch)) {
+            sent = -1;
+        } else if (batch.replies[0].status != AGENT_OK) {
+            snprintf(errors, errorsSize, "%s", strerror(batch.replies[0].status));
+            sent = 0;
+        }
+    }
+    AgentBatchFree(&batch);
+    return sent;
+}
+
+// What to send of localPath from offset on: the file itself, or its
+// remaining bytes gzip'd into gzPath (compress is cleared if that fails).
+// A whole file whose contents (hex) SshPrecompress already did comes from
+// the cache instead, and *precompressed is set: gzPath is left unused.
+static FILE *OpenPayload(const char *localPath, const char *hex, long size, long offset,
+                         bool *compress, char *gzPath, bool *precompressed, long *payloadSize,
+                         SshProgressCallback progressCb, void *userData) {
+    FILE *src = NULL;
+    *precompressed = false;
+    if (*compress && offset == 0 && hex) {
+        src = OpenGzCache(hex, payloadSize);
+        *precompressed = src != NULL;
+    }
+    if (*compress && !src) {
+        // Compress to a temp file first so the byte count (and progress) is exact
+        if (progressCb) progressCb(0.02f, "Compressing...", NULL, userData);
+        double start = MonotonicSeconds();
+        int gzFd = mkstemp(gzPath);
+        if (gzFd >= 0) {
+            close(gzFd);
+            char cmd[1200];
+            if (offset > 0) {
+                snprintf(cmd, sizeof(cmd), "tail -c +%ld '%s' | gzip -c -6 > '%s'", offset + 1,
+                         localPath, gzPath);
+            } else {
+                snprintf(cmd, sizeof(cmd), "gzip -c -6 '%s' > '%s'", localPath, gzPath);
+            }
+            struct stat gzStat;
+            if (system(cmd) == 0 && stat(gzPath, &gzStat) == 0) {
+                double deflateTime = MonotonicSeconds() - start;
+                pthread_mutex_lock(&g_deflateMutex);
+                UpdateRate(&g_deflateBps, deflateTime > 0 ? (size - offset) / deflateTime : 0);
+                pthread_mutex_unlock(&g_deflateMutex);
+                src = fopen(gzPath, "rb");
+                *payloadSize = (long)gzStat.st_size;
+            }
+            if (!src) unlink(gzPath);
+        }
+        if (!src) {
+            printf("SSH: Compression failed, sending %s uncompressed\n", localPath);
+            *compress = false;
+        }
+    }
+    if (!src) {
+        src = fopen(localPath, "rb");
+        if (src && offset > 0 && fseek(src, offset, SEEK_SET) != 0) {
+            fclose(src);
+            src = NULL;
+        }
+        *payloadSize = size - offset;
+    }
+    return src;
+}
+
+// Remote side of a streamed copy: write (or append to) partPath, check it
+// against the local SHA-256, and only then rename it over remotePath, so the
+// device never loads a half-written or damaged plugin. A mismatch removes
+// the part file and exits SSH_EXIT_MISMATCH. A device without sha256sum can
+// only compare the byte count with size; the file is renamed then, but the
+// command exits SSH_EXIT_UNVERIFIED. hex NULL skips the check. False if the
+// command doesn't fit.
+static bool BuildReceiveCommand(char *cmd, size_t cmdSize, bool compressed, bool append,
+                                const char *partPath, const char *remotePath, const char *hex,
+                                long size) {
+    int n = snprintf(cmd, cmdSize, "%s %s '%s'", compressed ? "gunzip -c" : "cat",
+                     append ? ">>" : ">", partPath);
+    if (n < 0 || (size_t)n >= cmdSize) return false;
+    int tail;
+    if (!hex) {
+        tail = snprintf(cmd + n, cmdSize - (size_t)n, " && mv -f '%s' '%s'", partPath, remotePath);
     } else {
-        if (progressCb) progressCb(0.0f, output[0] ? output : "Transfer failed", userData);
+        tail = snprintf(cmd + n, cmdSize - (size_t)n,
+                        " && { if command -v sha256sum >/dev/null; then h=$(sha256sum '%s'); "
+                        "[ \"${h%%%% *}\" = %s ] || { rm -f '%s'; exit %d; }; mv -f '%s' '%s'; "
+                        "else [ $(wc -c <'%s') -eq %ld ] || { rm -f '%s'; exit %d; }; "
+                        "mv -f '%s' '%s' && exit %d; fi; }",
+                        partPath, hex, partPath, SSH_EXIT_MISMATCH, partPath, remotePath,
+                        partPath, size, partPath, SSH_EXIT_MISMATCH,
+                        partPath, remotePath, SSH_EXIT_UNVERIFIED);
+    }
+    return tail >= 0 && (size_t)tail < cmdSize - (size_t)n;
+}
+
+// After a dropped transfer: probe the way the connection monitor does,
+// backing off, until the device answers again or SSH_TRANSFER_LINK_WAIT
+// seconds pass. Re-makes the target directory writable (the device may
+// have rebooted).
+static bool WaitForLink(const char *remotePath, float progress,
+                        SshProgressCallback progressCb, void *userData) {
+    if (progressCb) progressCb(progress, "Connection lost, waiting for device...", NULL, userData);
+    double deadline = MonotonicSeconds() + SSH_TRANSFER_LINK_WAIT;
+    double delay = 0.5;
+    while (!MonitorProbe()) {
+        if (MonotonicSeconds() + delay > deadline) return false;
+        usleep((useconds_t)(delay * 1e6));
+        delay = delay * 2.0 > 4.0 ? 4.0 : delay * 2.0;
+    }
+
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s", remotePath);
+    char *slash = strrchr(dir, '/');
+    if (slash && slash != dir) {
+        *slash = '\0';
+        SshPrepareWrite(dir);
+    }
+    return true;
+}
+
+// agent is NULL when the file must go over the shell (deploying the agent)
+static bool CopyToDevice(const char *localPath, const char *remotePath,
+                         SshProgressCallback progressCb, void *userData, DeviceAgent *agent) {
+    TRACE_SCOPE("Copy to device", TRACE_CAT_SSH);
+    SshDevice *dev = CurrentDevice();
+    struct stat st;
+    if (stat(localPath, &st) != 0 || access(localPath, R_OK) != 0) {
+        if (progressCb) progressCb(0.0f, "Local file not found", NULL, userData);
         return false;
     }
+    long size = (long)st.st_size;
+
+    if (progressCb) progressCb(0.0f, "Starting transfer...", NULL, userData);
+
+    EnsureSession();
+
+    SshTransferStats stats = {0};
+    stats.etaSeconds = -1.0;
+    bool compress = ShouldCompress(size);
+    double start = MonotonicSeconds();
+
+    char errors[256];
+    if (agent && !compress && size <= SSH_AGENT_WRITE_MAX) {
+        FILE *src = fopen(localPath, "rb");
+        if (!src) {
+            if (progressCb) progressCb(0.0f, "Local file not found", NULL, userData);
+            return false;
+        }
+        int sent = WriteViaAgent(agent, src, remotePath, errors, sizeof(errors));
+        fclose(src);
+        if (sent == 0) {
+            printf("SSH: Agent could not write %s: %s\n", remotePath, errors);
+            if (progressCb) progressCb(0.0f, errors, NULL, userData);
+            return false;
+        }
+        if (sent == 1) {
+            // Too small to say anything about the link rate: don't learn from it
+            double elapsed = MonotonicSeconds() - start;
+            stats.bytesSent = size;
+            stats.averageBps = elapsed > 0 ? size / elapsed : 0;
+            stats.compressionRatio = 1.0;
+            stats.etaSeconds = 0;
+            printf("SSH: Sent %ld bytes to %s via agent in %.2fs\n", size, remotePath, elapsed);
+            if (progressCb) progressCb(1.0f, "Complete", &stats, userData);
+            return true;
+        }
+        printf("SSH: Agent went away, streaming %s instead\n", remotePath);
+    }
+
+    // What the device has to end up with. Usually cached from the scan.
+    char hex[SHA256_HEX_SIZE];
+    bool verify = FileHasherHash(localPath, hex);
+
+    char partPath[1100];
+    snprintf(partPath, sizeof(partPath), "%s.part", remotePath);
+
+    // A dropped link resumes from however much of the part file made it;
+    // a mismatch starts over
+    long offset = 0;
+    long wireBytes = 0;         // Sent by the last attempt
+    double sendTime = 0;
+    int status = -1;
+    for (int attempt = 1; ; attempt++) {
+        char gzPath[] = "/tmp/salamander-gz-XXXXXX";
+        bool precompressed;
+        long payload = 0;
+        FILE *src = OpenPayload(localPath, verify ? hex : NULL, size, offset, &compress, gzPath,
+                                &precompressed, &payload, progressCb, userData);
+        if (!src) {
+            if (progressCb) progressCb(0.0f, "Local file not found", NULL, userData);
+            return false;
+        }
+
+        // Compressed resumes mix file and wire bytes; close enough for progress
+        stats.bytesSent = offset;
+        stats.bytesTotal = offset + payload;
+        char remoteCmd[2048];
+        if (!BuildReceiveCommand(remoteCmd, sizeof(remoteCmd), compress, offset > 0, partPath,
+                                 remotePath, verify ? hex : NULL, size)) {
+            fclose(src);
+            if (compress && !precompressed) unlink(gzPath);
+            printf("SSH: Path too long for the receive command: %s\n", remotePath);
+            if (progressCb) progressCb(0.0f, "Path too long", NULL, userData);
+            return false;
+        }
+
+        double sendStart = MonotonicSeconds();
+        status = StreamToDevice(src, remoteCmd, &stats, 0.98f, progressCb, userData,
+                                errors, sizeof(errors));
+        sendTime = MonotonicSeconds() - sendStart;
+        wireBytes = stats.bytesSent - offset;
+        fclose(src);
+        if (compress && !precompressed) unlink(gzPath);
+
+        // In place, but only the byte count vouches for it
+        if (status == SSH_EXIT_UNVERIFIED) {
+            stats.unverified = true;
+            status = 0;
+        }
+        if (status == 0 || status == SSH_EXIT_CANCELLED || attempt == SSH_TRANSFER_ATTEMPTS) break;
+        if (status == SSH_EXIT_MISMATCH) {
+            printf("SSH: %s did not match the local build on the device, sending it again\n",
+                   remotePath);
+            offset = 0;
+            continue;
+        }
+        // Anything else came from the device itself (full, read-only) or never ran
+        if (status != SSH_EXIT_CONNECTION && status != -1) break;
+
+        printf("SSH: Transfer of %s interrupted after %ld bytes\n", remotePath, stats.bytesSent);
+        float progress = stats.bytesTotal > 0 ? 0.98f * stats.bytesSent / stats.bytesTotal : 0.0f;
+        if (!WaitForLink(remotePath, progress, progressCb, userData)) {
+            snprintf(errors, sizeof(errors), "Device did not come back");
+            break;
+        }
+        long landed = SshGetFileSize(partPath);
+        offset = (landed > 0 && landed <= size) ? landed : 0;
+        printf("SSH: Resuming %s at %ld of %ld bytes (attempt %d of %d)\n", remotePath, offset, size,
+               attempt + 1, SSH_TRANSFER_ATTEMPTS);
+    }
+
+    double elapsed = MonotonicSeconds() - start;
+    if (status != 0) {
+        if (status == SSH_EXIT_MISMATCH) snprintf(errors, sizeof(errors), "Verification failed");
+        if (status == SSH_EXIT_CANCELLED) snprintf(errors, sizeof(errors), "Cancelled");
+        if (progressCb) progressCb(0.0f, errors[0] ? errors : "Transfer failed", NULL, userData);
+        return false;
+    }
+
+    // Rates come from the attempt that finished: size - offset file bytes
+    // went over as wireBytes
+    long fileBytes = size - offset;
+    if (compress) {
+        // Learn how well plugins pack and how fast the device inflates; the
+        // compressed send rate is a lower bound for the link
+        stats.compressed = true;
+        stats.compressionRatio = fileBytes > 0 ? (double)wireBytes / fileBytes : 1.0;
+        pthread_mutex_lock(&dev->rateMutex);
+        dev->compressRatio = dev->compressRatio * 0.7 + stats.compressionRatio * 0.3;
+        UpdateRate(&dev->linkBps, sendTime > 0 ? wireBytes / sendTime : 0);
+        UpdateRate(&dev->inflateBps, sendTime > 0 ? fileBytes / sendTime : 0);
+        stats.secondsSaved = (dev->linkBps > 0 ? size / dev->linkBps : elapsed) - elapsed;
+        pthread_mutex_unlock(&dev->rateMutex);
+        printf("SSH: Sent %s as %ld of %ld bytes (%.0f%%) in %.2fs, ~%.2fs saved\n",
+               remotePath, wireBytes, fileBytes, stats.compressionRatio * 100.0, elapsed,
+               stats.secondsSaved);
+    } else {
+        stats.compressionRatio = 1.0;
+        pthread_mutex_lock(&dev->rateMutex);
+        UpdateRate(&dev->linkBps, sendTime > 0 ? wireBytes / sendTime : 0);
+        pthread_mutex_unlock(&dev->rateMutex);
+        printf("SSH: Sent %ld bytes to %s in %.2fs (%.1f KB/s)\n",
+               wireBytes, remotePath, elapsed, stats.averageBps / 1024.0);
+    }
+    if (offset > 0) {
+        printf("SSH: %ld bytes of %s were already on the device\n", offset, remotePath);
+    }
+
+    if (stats.unverified) {
+        printf("SSH: No sha256sum on the device: %s checked by size only\n", remotePath);
+    }
+
+    stats.etaSeconds = 0;
+    if (progressCb) {
+        progressCb(1.0f, stats.unverified ? "Complete (unverified, size only)" : "Complete", &stats,
+                   userData);
+    }
+    return true;
+}
+
+bool SshCopyToDevice(const char *localPath, const char *remotePath,
+                     SshProgressCallback progressCb, void *userData) {
+    return CopyToDevice(localPath, remotePath, progressCb, userData, SshGetAgent());
+}
+
+// Same check as BuildReceiveCommand, then the rename; a staged file that
+// no longer matches is left for the caller to remove
+bool SshPromoteStaged(const char *stagedPath, const char *remotePath, const char *sha256) {
+    TRACE_SCOPE("Promote", TRACE_CAT_SSH);
+    // Without sha256sum nothing vouches for it: let the caller copy as usual,
+    // which at least compares sizes and reports the result as unverified
+    char cmd[1400];
+    snprintf(cmd, sizeof(cmd),
+             "command -v sha256sum >/dev/null || exit 3; h=$(sha256sum '%s') && "
+             "[ \"${h%%%% *}\" = %s ] && mv -f '%s' '%s'",
+             stagedPath, sha256, stagedPath, remotePath);
+    SshResult result = SshExecute(cmd);
+    if (result.exitCode == 3) {
+        printf("SSH: No sha256sum on the device, not promoting %s\n", stagedPath);
+    }
+    return result.success;
 }
 
 bool SshDeleteFile(const char *remotePath) {
+    AgentBatch batch = {0};
+    AgentAddDelete(&batch, remotePath, false);
+    if (RunAgentRequest(&batch)) {
+        bool deleted = batch.replies[0].status == AGENT_OK;
+        AgentBatchFree(&batch);
+        return deleted;
+    }
+    AgentBatchFree(&batch);
+
     char cmd[512];
     snprintf(cmd, sizeof(cmd), "rm -f '%s'", remotePath);
     SshResult result = SshExecute(cmd);
@@ -191,6 +1401,15 @@ bool SshDeleteFile(const char *remotePath) {
 }
 
 long SshGetFileSize(const char *remotePath) {
+    AgentBatch batch = {0};
+    AgentAddStat(&batch, remotePath);
+    if (RunAgentRequest(&batch)) {
+        long size = batch.replies[0].status == AGENT_OK ? atol(batch.replies[0].data) : -1;
+        AgentBatchFree(&batch);
+        return size;
+    }
+    AgentBatchFree(&batch);
+
     char cmd[512];
     snprintf(cmd, sizeof(cmd), "stat -c %%s '%s' 2>/dev/null || echo -1", remotePath);
     SshResult result = SshExecute(cmd);
@@ -202,8 +1421,360 @@ long SshGetFileSize(const char *remotePath) {
 }
 
 bool SshFileExists(const char *remotePath) {
+    AgentBatch batch = {0};
+    AgentAddStat(&batch, remotePath);
+    if (RunAgentRequest(&batch)) {
+        bool exists = batch.replies[0].status == AGENT_OK;
+        AgentBatchFree(&batch);
+        return exists;
+    }
+    AgentBatchFree(&batch);
+
     char cmd[512];
     snprintf(cmd, sizeof(cmd), "test -f '%s' && echo exists", remotePath);
     SshResult result = SshExecute(cmd);
     return result.success && strstr(result.output, "exists") != NULL;
 }
+
+// Shell commands are capped well below what RunRemote can quote, so long
+// batches go out in several writes
+#define SSH_RELOAD_CHUNK 1024
+
+// Without the agent, a shell can only open the FIFO for writing blocking
+// until the host reads it: this long (seconds) counts as "not listening"
+#define SSH_RELOAD_OPEN_TIMEOUT 1
+
+int SshNotifyReload(const char *const *lines, int count) {
+    // One write of every line; ENOENT: no FIFO, ENXIO: the host isn't reading
+    size_t total = 1;
+    for (int j = 0; j < count; j++) total += strlen(lines[j]) + 1;
+    char *joined = malloc(total);
+    if (joined) {
+        size_t used = 0;
+        for (int j = 0; j < count; j++) {
+            used += (size_t)snprintf(joined + used, total - used, "%s\n", lines[j]);
+        }
+        AgentBatch batch = {0};
+        AgentAddReload(&batch, SSH_RELOAD_FIFO, joined);
+        free(joined);
+        if (RunAgentRequest(&batch)) {
+            int status = batch.replies[0].status;
+            AgentBatchFree(&batch);
+            if (status == ENOENT || status == ENXIO) return 0;
+            if (status != AGENT_OK) {
+                printf("SSH: Reload request failed: %s\n", strerror(status));
+                return -1;
+            }
+            return 1;
+        }
+        AgentBatchFree(&batch);
+    }
+
+    int i = 0;
+    while (i < count) {
+        // A write-only open waits for a reader, so it is bounded by timeout
+        // (exit 124, or 143 from busybox); exit 3 means no FIFO or no
+        // timeout to bound the wait with
+        char cmd[SSH_RELOAD_CHUNK + 512];
+        int len = snprintf(cmd, sizeof(cmd),
+                           "[ -p '%s' ] && command -v timeout >/dev/null || exit 3; "
+                           "timeout %d sh -c 'exec 3>\"$0\" && printf \"%%s\\n\" \"$@\" >&3' '%s'",
+                           SSH_RELOAD_FIFO, SSH_RELOAD_OPEN_TIMEOUT, SSH_RELOAD_FIFO);
+        int added = 0;
+        while (i < count) {
+            char quoted[SSH_RELOAD_CHUNK];
+            if (!QuoteForShell(lines[i], quoted, sizeof(quoted))) {
+                printf("SSH: Reload request too long, skipped: %s\n", lines[i]);
+                i++;
+                continue;
+            }
+            if (added > 0 && len + strlen(quoted) + 64 >= SSH_RELOAD_CHUNK) break;
+            len += snprintf(cmd + len, sizeof(cmd) - (size_t)len, " %s", quoted);
+            added++;
+            i++;
+        }
+        if (added == 0) break;
+        snprintf(cmd + len, sizeof(cmd) - (size_t)len,
+                 "; s=$?; [ $s -eq 124 ] || [ $s -eq 143 ] && exit 3; exit $s");
+
+        SshResult result = SshExecute(cmd);
+        if (result.exitCode == 3) return 0;
+        if (!result.success) {
+            printf("SSH: Reload request failed (%d): %s\n", result.exitCode, result.output);
+            return -1;
+        }
+    }
+    return 1;
+}
+
+bool SshPrepareWrite(const char *dir) {
+    AgentBatch batch = {0};
+    AgentAddRemount(&batch, "/");
+    AgentAddMkdir(&batch, dir);
+    if (RunAgentRequest(&batch)) {
+        int status = batch.replies[0].status != AGENT_OK ? batch.replies[0].status
+                                                         : batch.replies[1].status;
+        AgentBatchFree(&batch);
+        if (status != AGENT_OK) {
+            printf("SSH: Could not make %s writable: %s\n", dir, strerror(status));
+        }
+        return status == AGENT_OK;
+    }
+    AgentBatchFree(&batch);
+
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "mount -o remount,rw / && mkdir -p '%s'", dir);
+    SshResult result = SshExecute(cmd);
+    if (!result.success) {
+        printf("SSH: Could not make %s writable: %s\n", dir, result.output);
+    }
+    return result.success;
+}
+
+void SshSyncFilesystem(void) {
+    AgentBatch batch = {0};
+    AgentAddSync(&batch);
+    bool synced = RunAgentRequest(&batch);
+    AgentBatchFree(&batch);
+    if (!synced) SshExecute("sync");
+}
+
+// ============================================================================
+// Device Agent
+// ============================================================================
+
+void SshSetAgentBinary(const char *localPath) {
+    snprintf(g_agentBinary, sizeof(g_agentBinary), "%s", localPath ? localPath : "");
+}
+
+// Copy the agent over if the device doesn't have this exact build, then
+// start it on the session (caller holds dev->agentMutex)
+static bool StartAgent(SshDevice *dev) {
+    TRACE_SCOPE("Agent start", TRACE_CAT_SSH);
+    char localHash[SHA256_HEX_SIZE];
+    if (!Sha256File(g_agentBinary, localHash)) {
+        printf("SSH: Can't read agent %s, using shell commands\n", g_agentBinary);
+        return false;
+    }
+
+    SshResult check = SshExecute("sha256sum " SSH_AGENT_PATH " 2>/dev/null");
+    if (!check.success || strncmp(check.output, localHash, SHA256_HEX_SIZE - 1) != 0) {
+        printf("SSH: Deploying agent to %s\n", dev->host);
+        if (!CopyToDevice(g_agentBinary, SSH_AGENT_PATH, NULL, NULL, NULL) ||
+            !SshExecute("chmod 755 " SSH_AGENT_PATH).success) {
+            printf("SSH: Could not deploy agent, using shell commands\n");
+            return false;
+        }
+    }
+
+    if (!dev->agent) __atomic_store_n(&dev->agent, AgentCreate(), __ATOMIC_RELEASE);
+    if (!dev->agent) return false;
+
+    char sshPrefix[512];
+    BuildSshpassPrefix(sshPrefix, sizeof(sshPrefix));
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "%s 'exec " SSH_AGENT_PATH "'", sshPrefix);
+    if (!AgentStart(dev->agent, cmd)) {
+        printf("SSH: Agent did not start on %s, using shell commands\n", dev->host);
+        return false;
+    }
+    printf("SSH: Agent running on %s\n", dev->host);
+    return true;
+}
+
+DeviceAgent *SshGetAgent(void) {
+    SshDevice *dev = CurrentDevice();
+    if (g_agentBinary[0] == '\0' || SshGetStatus() != SSH_STATUS_CONNECTED) return NULL;
+    DeviceAgent *current = __atomic_load_n(&dev->agent, __ATOMIC_ACQUIRE);
+    if (AgentIsAlive(current)) return current;
+    if (__atomic_load_n(&dev->agentFailed, __ATOMIC_ACQUIRE)) return NULL;
+
+    // Start it, or replace one that died with the session; one attempt per
+    // session so a broken agent doesn't cost every call a deploy
+    EnsureSession();
+    pthread_mutex_lock(&dev->agentMutex);
+    if (!AgentIsAlive(dev->agent) && !__atomic_load_n(&dev->agentFailed, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&dev->agentFailed, !StartAgent(dev), __ATOMIC_RELEASE);
+    }
+    DeviceAgent *agent = AgentIsAlive(dev->agent) ? dev->agent : NULL;
+    pthread_mutex_unlock(&dev->agentMutex);
+    return agent;
+}
+
+// ============================================================================
+// Delta Transfers (rsync rolling checksum over the persistent session)
+// ============================================================================
+
+bool SshDeltaAvailable(void) {
+    SshDevice *dev = CurrentDevice();
+    pthread_mutex_lock(&g_probeMutex);
+    bool local = ProbeLocalTool(&g_localRsync, "rsync", "delta sync") == 1;
+    pthread_mutex_unlock(&g_probeMutex);
+    if (!local) return false;
+
+    pthread_mutex_lock(&dev->probeMutex);
+    bool remote = ProbeRemoteTool(dev, &dev->remoteRsync, "rsync", "delta sync") == 1;
+    pthread_mutex_unlock(&dev->probeMutex);
+    return remote;
+}
+
+// Pull "<label>: <n> bytes" out of rsync --stats output
+static long ParseRsyncStat(const char *output, const char *label) {
+    const char *line = strstr(output, label);
+    if (!line) return -1;
+
+    // Numbers may contain thousands separators (e.g. "1,234,567")
+    long value = 0;
+    bool digits = false;
+    for (const char *c = line + strlen(label); *c && *c != '\n'; c++) {
+        if (*c >= '0' && *c <= '9') {
+            value = value * 10 + (*c - '0');
+            digits = true;
+        } else if (digits && *c != ',') {
+            break;
+        }
+    }
+    return digits ? value : -1;
+}
+
+// One --progress update ("   1,234,567  45%    1.23MB/s    0:00:03"): the
+// bytes of the file covered so far. False for any other line.
+static bool ParseRsyncProgress(const char *line, long *bytes) {
+    while (*line == ' ') line++;
+    long value = 0;
+    bool digits = false;
+    for (; (*line >= '0' && *line <= '9') || (digits && *line == ','); line++) {
+        if (*line == ',') continue;
+        value = value * 10 + (*line - '0');
+        digits = true;
+    }
+    int percent;
+    if (!digits || sscanf(line, " %d%%", &percent) != 1) return false;
+    *bytes = value;
+    return true;
+}
+
+bool SshSyncToDevice(const char *localPath, const char *remotePath,
+                     SshProgressCallback progressCb, void *userData) {
+    TRACE_SCOPE("Delta sync", TRACE_CAT_SSH);
+    SshDevice *dev = CurrentDevice();
+    if (!SshDeltaAvailable()) {
+        return SshCopyToDevice(localPath, remotePath, progressCb, userData);
+    }
+
+    if (access(localPath, R_OK) != 0) {
+        if (progressCb) progressCb(0.0f, "Local file not found", NULL, userData);
+        return false;
+    }
+
+    struct stat st;
+    if (stat(localPath, &st) != 0) st.st_size = 0;
+    SshTransferStats stats = {0};
+    stats.bytesTotal = (long)st.st_size;
+    stats.etaSeconds = -1.0;
+    stats.compressionRatio = 1.0;
+    if (progressCb) progressCb(0.0f, "Computing delta...", NULL, userData);
+
+    // rsync writes to a temp file next to the target and renames it into
+    // place, so the device never sees a half-written plugin. --progress
+    // reports how much of the file has been covered (sent or matched).
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd),
+             "sshpass -p '%s' rsync --no-whole-file --stats --progress "
+             "-e \"ssh %s -o ControlMaster=no -o ControlPath='%s'\" "
+             "'%s' %s@%s:'%s' 2>&1",
+             dev->pass, SSH_OPTS, g_controlPath, localPath, dev->user, dev->host, remotePath);
+
+    FILE *fp = popen(cmd, "r");
+    if (!fp) {
+        if (progressCb) progressCb(0.0f, "Transfer failed", NULL, userData);
+        return false;
+    }
+
+    // Progress updates end in \r, everything else in \n; keep the rest
+    // (errors, --stats) for after the exit
+    char output[4096] = {0};
+    size_t totalRead = 0;
+    char line[256];
+    size_t lineLength = 0;
+    char block[1024];
+    int fd = fileno(fp);
+    double start = MonotonicSeconds();
+    double lastReport = start;
+    double windowStart = start;
+    long windowBytes = 0;
+    for (;;) {
+        ssize_t n = read(fd, block, sizeof(block));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        for (ssize_t i = 0; i < n; i++) {
+            if (block[i] != '\r' && block[i] != '\n') {
+                if (lineLength < sizeof(line) - 1) line[lineLength++] = block[i];
+                continue;
+            }
+            line[lineLength] = '\0';
+            lineLength = 0;
+
+            long bytes;
+            if (!ParseRsyncProgress(line, &bytes)) {
+                size_t len = strlen(line);
+                if (len > 0 && totalRead + len + 1 < sizeof(output)) {
+                    memcpy(output + totalRead, line, len);
+                    output[totalRead + len] = '\n';
+                    totalRead += len + 1;
+                }
+                continue;
+            }
+
+            // Same rate and ETA bookkeeping as the streamed copy
+            if (stats.bytesTotal > 0 && bytes > stats.bytesTotal) bytes = stats.bytesTotal;
+            stats.bytesSent = bytes;
+            double now = MonotonicSeconds();
+            if (now - windowStart >= 0.25) {
+                double rate = (bytes - windowBytes) / (now - windowStart);
+                stats.instantBps = stats.instantBps > 0 ? stats.instantBps * 0.5 + rate * 0.5 : rate;
+                windowStart = now;
+                windowBytes = bytes;
+            }
+            if (progressCb && now - lastReport >= 0.1) {
+                double elapsed = now - start;
+                stats.averageBps = elapsed > 0 ? bytes / elapsed : 0;
+                double rate = stats.instantBps > 0 ? stats.instantBps : stats.averageBps;
+                stats.etaSeconds = rate > 0 ? (stats.bytesTotal - bytes) / rate : -1.0;
+                float progress = stats.bytesTotal > 0 ? (float)bytes / stats.bytesTotal : 0.0f;
+                progressCb(progress * 0.98f, "Syncing changes...", &stats, userData);
+                lastReport = now;
+            }
+        }
+    }
+    if (lineLength > 0 && totalRead + lineLength < sizeof(output)) {
+        memcpy(output + totalRead, line, lineLength);
+    }
+
+    int status = pclose(fp);
+    int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    double elapsed = MonotonicSeconds() - start;
+
+    if (exitCode != 0) {
+        printf("SSH: rsync failed (%d): %s\n", exitCode, output);
+        if (progressCb) progressCb(0.0f, "Delta transfer failed", NULL, userData);
+        return false;
+    }
+
+    long literal = ParseRsyncStat(output, "Literal data:");
+    long matched = ParseRsyncStat(output, "Matched data:");
+    char message[128];
+    if (literal >= 0 && matched >= 0) {
+        printf("SSH: Delta sync sent %ld bytes, reused %ld bytes already on device\n", literal, matched);
+        snprintf(message, sizeof(message), "Sent %ld KB of %ld KB",
+                 literal / 1024, (literal + matched) / 1024);
+    } else {
+        snprintf(message, sizeof(message), "Complete");
+    }
+    stats.bytesSent = stats.bytesTotal;
+    stats.averageBps = elapsed > 0 ? stats.bytesTotal / elapsed : 0;
+    stats.etaSeconds = 0;
+    if (progressCb) progressCb(1.0f, message, &stats, userData);
+    return true;
+}
@@ -1,18 +1,60 @@
 #ifndef SSH_MANAGER_H
 #define SSH_MANAGER_H
 
+#include "device_agent.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 // ============================================================================
 // SSH Manager - CarThing SSH/SCP operations via sshpass + popen
+//
+// All commands share one persistent connection (OpenSSH ControlMaster), so
+// only the first command pays for the TCP handshake, key exchange and auth.
 // ============================================================================
 
 // Default CarThing connection settings
 #define SSH_DEFAULT_HOST "172.16.42.2"
 #define SSH_DEFAULT_USER "root"
 #define SSH_DEFAULT_PASS "llizardos"
+#define SSH_DEFAULT_PORT 22
 #define SSH_PLUGIN_PATH  "/usr/lib/llizard/plugins"
 
+// Uploads made ahead of an install (see prestage.h). Inside the plugin
+// directory so moving one into place is a rename on the same filesystem;
+// llizardgui-host only loads *.so directly in SSH_PLUGIN_PATH.
+#define SSH_STAGING_PATH SSH_PLUGIN_PATH "/.staging"
+
+// llizardgui-host reads plugin reload requests from this FIFO, one per line:
+// "load <name>" (load, or reload if already loaded, SSH_PLUGIN_PATH/<name>.so)
+// or "unload <name>"
+#define SSH_RELOAD_FIFO  "/tmp/llizard/reload.fifo"
+
+// Where the optional device agent is installed. /tmp is tmpfs on the
+// device, so it is copied again after each reboot.
+#define SSH_AGENT_PATH   "/tmp/salamander-agent"
+
+// Files up to this size go through the agent in one batch; bigger ones
+// stream so they show progress and can share the link with other installs
+#define SSH_AGENT_WRITE_MAX (256 * 1024)
+
+// How long the persistent session stays open while idle (ssh time format)
+#define SSH_SESSION_PERSIST "10m"
+
+// Connection monitor tuning
+#define SSH_MONITOR_TCP_TIMEOUT_MS 500   // Port 22 connect probe
+#define SSH_MONITOR_MAX_BACKOFF    30.0f // Longest wait between probes when offline
+
+// Streamed copies that lose the link wait this long (seconds) for the
+// device to come back, then resume; at most this many attempts per file
+#define SSH_TRANSFER_LINK_WAIT 30.0
+#define SSH_TRANSFER_ATTEMPTS  4
+
+// Files smaller than this are never worth compressing
+#define SSH_COMPRESS_MIN_SIZE (16 * 1024)
+
+// Compressed payloads SshPrecompress keeps on the host (newest kept)
+#define SSH_GZ_CACHE_MAX 8
+
 // Connection status
 typedef enum {
     SSH_STATUS_UNKNOWN,
@@ -21,46 +63,192 @@ typedef enum {
     SSH_STATUS_CHECKING
 } SshConnectionStatus;
 
-// Operation result
+// Operation result (SshExecute; output past 4 KB is dropped)
 typedef struct {
     bool success;
     char output[4096];
     int exitCode;
 } SshResult;
 
+// Growable output buffer for SshExecuteToBuffer
+// Zero-initialize, and reuse it across calls to keep the allocation.
+// data is NUL-terminated after every call.
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} SshBuffer;
+
+typedef enum {
+    SSH_STDOUT,
+    SSH_STDERR
+} SshStream;
+
+// Output callback for SshExecuteStream. data points into the read buffer
+// (not NUL-terminated, only valid during the call). Return false to stop;
+// the rest of the output is discarded.
+typedef bool (*SshOutputCallback)(SshStream stream, const char *data, size_t length,
+                                  void *userData);
+
+// Byte-level transfer progress
+typedef struct {
+    long bytesSent;
+    long bytesTotal;
+    double instantBps;   // Smoothed rate over the last ~250ms
+    double averageBps;   // Since the transfer started
+    double etaSeconds;   // At the instantaneous rate; < 0 if unknown
+    // Filled in on completion
+    bool compressed;          // Sent gzip'd (bytesTotal is the compressed size)
+    double compressionRatio;  // Compressed / original, 1.0 when uncompressed
+    double secondsSaved;      // Estimated against an uncompressed send
+    bool unverified;          // The device had no sha256sum: only the size was checked
+} SshTransferStats;
+
+// Compressed transfer mode for SshCopyToDevice
+typedef enum {
+    SSH_COMPRESS_OFF,
+    SSH_COMPRESS_ON,
+    SSH_COMPRESS_AUTO     // Decide per file from measured link and CPU rates
+} SshCompressMode;
+
 // Progress callback for file transfers
-typedef void (*SshProgressCallback)(float progress, const char *message, void *userData);
+// stats is NULL for steps that don't move file bytes (setup, finishing)
+typedef void (*SshProgressCallback)(float progress, const char *message,
+                                    const SshTransferStats *stats, void *userData);
+
+// One device's connection settings, session and learned link rates
+typedef struct SshDevice SshDevice;
 
-// Initialize SSH manager with connection settings
+// Initialize SSH manager with connection settings (for the default device)
 void SshInit(const char *host, const char *user, const char *password);
 
 // Shutdown and cleanup
 void SshShutdown(void);
 
+// Create a context for another device (NULL user/password use the defaults)
+SshDevice *SshDeviceCreate(const char *host, const char *user, const char *password);
+
+// Close a device's session and free it
+void SshDeviceDestroy(SshDevice *device);
+
+// Make every call below on this thread act on device (NULL for the default
+// device). New threads start on the default device.
+void SshBindDevice(SshDevice *device);
+
 // Get current connection settings
 const char *SshGetHost(void);
 const char *SshGetUser(void);
 
-// Check connection status (fast ping test)
-// This is non-blocking and updates internal state
+// Open the persistent session (authenticates once)
+// Called automatically by the first command; safe to call repeatedly
+bool SshSessionOpen(void);
+
+// Close the persistent session (also done by SshShutdown)
+void SshSessionClose(void);
+
+// Check whether the persistent session is up (local check, no network)
+bool SshSessionIsActive(void);
+
+// Use salamander-agent (built for the device) at localPath for file
+// operations, reload requests and inventory: each call becomes one framed
+// request to a long-lived process instead of a shell command, and batches
+// of requests cost one round trip. NULL or "" turns it off (the default).
+void SshSetAgentBinary(const char *localPath);
+
+// The bound device's agent, deployed and started on first use over the
+// persistent session. NULL when turned off, not connected, or it couldn't
+// start; callers use shell commands instead.
+DeviceAgent *SshGetAgent(void);
+
+// Check connection status (authenticated echo over the session)
+// Blocks for up to the connect timeout; the UI should rely on the monitor
 void SshCheckConnection(void);
 
-// Get cached connection status
+// Start the background connection monitor
+// Probes immediately, then every intervalSeconds while connected. Each probe
+// is a TCP connect to port 22, with an authenticated echo only when the
+// session needs (re)establishing. Backs off exponentially while offline.
+void SshMonitorStart(float intervalSeconds);
+
+// Stop the monitor thread (also done by SshShutdown)
+void SshMonitorStop(void);
+
+// Ask the monitor to probe now instead of waiting for the next interval
+void SshMonitorPoke(void);
+
+// Get cached connection status (never blocks, safe from any thread)
 SshConnectionStatus SshGetStatus(void);
 
 // Execute a remote command
-// Returns result with output and exit code
+// Returns result with output (stdout, then stderr) and exit code. For
+// commands whose output can be large, use SshExecuteStream or
+// SshExecuteToBuffer.
 SshResult SshExecute(const char *command);
 
+// Execute a remote command, handing output to onOutput as it is read
+// stdout streams while the command runs; stderr is collected and delivered
+// after it exits. Returns the exit status, or -1 if it couldn't be run.
+int SshExecuteStream(const char *command, SshOutputCallback onOutput, void *userData);
+
+// Execute a remote command, reading stdout straight into out and stderr
+// into errors (may be NULL to drop it). Both are replaced, not appended to.
+// Returns the exit status, or -1 if it couldn't be run.
+int SshExecuteToBuffer(const char *command, SshBuffer *out, SshBuffer *errors);
+
+// Release a buffer's memory (it can be reused afterwards)
+void SshBufferFree(SshBuffer *buffer);
+
 // List files in a remote directory
 // Returns result with newline-separated file paths
 SshResult SshListDirectory(const char *remotePath);
 
+// List a directory's plugins with metadata in one round trip
+// Output lines (names relative to remoteDir):
+//   I <device id>                 (machine-id, or hostname without one)
+//   F <size> <mtime> <name>.so
+//   H <sha256>  <name>.so        (only when withHashes is set)
+// Returns the exit status like SshExecuteToBuffer
+int SshListInventory(const char *remoteDir, bool withHashes, SshBuffer *out, SshBuffer *errors);
+
 // Copy a file to the device
+// Streams the file into `cat` (or `gunzip` when compressing) on the device,
+// or for files up to SSH_AGENT_WRITE_MAX hands it to the agent when it runs,
+// written to <remotePath>.part and renamed into place, and reports real
+// bytes sent and throughput. Streamed copies are checked against the local
+// SHA-256 on the device before the rename; if the link drops they wait for
+// the device and resume from what reached the part file (a mismatch is
+// sent again from the start), up to SSH_TRANSFER_ATTEMPTS times.
 // progressCb is optional, can be NULL
 bool SshCopyToDevice(const char *localPath, const char *remotePath,
                      SshProgressCallback progressCb, void *userData);
 
+// Choose when SshCopyToDevice compresses (default SSH_COMPRESS_AUTO)
+void SshSetCompression(SshCompressMode mode);
+
+// Gzip localPath ahead of time into a host cache keyed by its SHA-256, so
+// a later compressed copy of the same contents starts sending at once.
+// Does nothing when compression is off; the cache is removed by SshShutdown.
+bool SshPrecompress(const char *localPath);
+
+// Make copies on the calling thread give up as soon as *flag is nonzero
+// (NULL to clear). A cancelled copy fails at once without resuming.
+void SshBindCancelFlag(const int *flag);
+
+// Move a file copied earlier with SshCopyToDevice to remotePath, once the
+// device confirms it still hashes to sha256 (one round trip). False on a
+// device without sha256sum, so the caller falls back to a checked copy.
+bool SshPromoteStaged(const char *stagedPath, const char *remotePath, const char *sha256);
+
+// Check whether delta transfers are possible (rsync on host and device)
+// The device check runs once per SshInit
+bool SshDeltaAvailable(void);
+
+// Update a file on the device, sending only the blocks that changed
+// Uses rsync's rolling checksum over the persistent session and falls back
+// to SshCopyToDevice when rsync is missing on either side
+bool SshSyncToDevice(const char *localPath, const char *remotePath,
+                     SshProgressCallback progressCb, void *userData);
+
 // Delete a file on the device
 bool SshDeleteFile(const char *remotePath);
 
@@ -70,4 +258,17 @@ long SshGetFileSize(const char *remotePath);
 // Check if a file exists on device
 bool SshFileExists(const char *remotePath);
 
+// Make the root filesystem writable and create dir (one round trip)
+bool SshPrepareWrite(const char *dir);
+
+// Flush the device's filesystem buffers
+void SshSyncFilesystem(void);
+
+// Send reload request lines to llizardgui-host over SSH_RELOAD_FIFO
+// Lines are only written while the host has the FIFO open for reading
+// (without the agent, waiting at most a second to find out). Returns 1 if
+// sent, 0 if the host isn't listening (no FIFO, or nobody reading it),
+// -1 if the command failed.
+int SshNotifyReload(const char *const *lines, int count);
+
 #endif // SSH_MANAGER_H
@@ -0,0 +1,215 @@
+#include "text_cache.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Text Cache Implementation
+// ============================================================================
+
+#define TABLE_SIZE (TEXT_CACHE_CAPACITY * 2)  // Power of two, at most half full
+#define MAX_AGE_FRAMES 120                    // Unused this long -> evictable
+
+typedef struct {
+    Rectangle src;          // Atlas rectangle
+    Rectangle dst;          // Screen rectangle relative to the text origin
+} TextGlyph;
+
+typedef struct {
+    uint32_t hash;
+    unsigned int fontId;
+    float fontSize;
+    float spacing;
+    unsigned int lastUsed;  // Frame stamp
+    Vector2 size;           // MeasureTextEx result
+    int glyphCount;
+    TextGlyph *glyphs;
+    char text[];
+} TextRun;
+
+static TextRun *g_table[TABLE_SIZE];
+static int g_count = 0;
+static unsigned int g_frame = 0;
+
+// FNV-1a over the text, then the rest of the key
+static uint32_t HashKey(const char *text, unsigned int fontId, float fontSize, float spacing, size_t *len, bool *multiline) {
+    uint32_t hash = 2166136261u;
+    const unsigned char *p = (const unsigned char *)text;
+    for (; *p; p++) {
+        if (*p == '\n') *multiline = true;
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    *len = (size_t)(p - (const unsigned char *)text);
+
+    uint32_t extra[3];
+    extra[0] = fontId;
+    memcpy(&extra[1], &fontSize, sizeof(float));
+    memcpy(&extra[2], &spacing, sizeof(float));
+    for (int i = 0; i < 3; i++) {
+        hash ^= extra[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void FreeRun(TextRun *run) {
+    free(run->glyphs);
+    free(run);
+}
+
+static void Insert(TextRun *run) {
+    uint32_t pos = run->hash & (TABLE_SIZE - 1);
+    while (g_table[pos]) {
+        pos = (pos + 1) & (TABLE_SIZE - 1);
+    }
+    g_table[pos] = run;
+    g_count++;
+}
+
+// Drop runs that haven't been used recently. At most half the capacity of
+// recent ones is kept (in table order), so a full table of live runs
+// doesn't evict again on the very next insert.
+static void Evict(void) {
+    TextRun *keep[TEXT_CACHE_CAPACITY];
+    int kept = 0;
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        TextRun *run = g_table[i];
+        if (!run) continue;
+        if (g_frame - run->lastUsed < MAX_AGE_FRAMES && kept < TEXT_CACHE_CAPACITY / 2) {
+            keep[kept++] = run;
+        } else {
+            FreeRun(run);
+        }
+        g_table[i] = NULL;
+    }
+
+    g_count = 0;
+    for (int i = 0; i < kept; i++) {
+        Insert(keep[i]);
+    }
+}
+
+// Lay out text the way DrawTextEx/MeasureTextEx do
+static TextRun *BuildRun(Font font, const char *text, size_t len, float fontSize, float spacing, uint32_t hash) {
+    TextRun *run = malloc(sizeof(TextRun) + len + 1);
+    if (!run) return NULL;
+    run->glyphs = malloc((len > 0 ? len : 1) * sizeof(TextGlyph));
+    if (!run->glyphs) {
+        free(run);
+        return NULL;
+    }
+
+    memcpy(run->text, text, len + 1);
+    run->hash = hash;
+    run->fontId = font.texture.id;
+    run->fontSize = fontSize;
+    run->spacing = spacing;
+    run->glyphCount = 0;
+
+    float scale = fontSize / font.baseSize;
+    float pad = (float)font.glyphPadding;
+    float offsetX = 0.0f;
+    float measuredWidth = 0.0f;
+    int codepointCount = 0;
+
+    for (size_t i = 0; i < len;) {
+        int bytes = 0;
+        int codepoint = GetCodepointNext(&text[i], &bytes);
+        int index = GetGlyphIndex(font, codepoint);
+        Rectangle rec = font.recs[index];
+        GlyphInfo glyph = font.glyphs[index];
+        i += bytes;
+        codepointCount++;
+
+        if (codepoint != ' ' && codepoint != '\t') {
+            TextGlyph *g = &run->glyphs[run->glyphCount++];
+            g->src = (Rectangle){rec.x - pad, rec.y - pad, rec.width + 2.0f * pad, rec.height + 2.0f * pad};
+            g->dst = (Rectangle){offsetX + glyph.offsetX * scale - pad * scale,
+                                 glyph.offsetY * scale - pad * scale,
+                                 (rec.width + 2.0f * pad) * scale,
+                                 (rec.height + 2.0f * pad) * scale};
+        }
+
+        if (glyph.advanceX == 0) {
+            offsetX += rec.width * scale + spacing;
+            measuredWidth += rec.width + glyph.offsetX;
+        } else {
+            offsetX += glyph.advanceX * scale + spacing;
+            measuredWidth += glyph.advanceX;
+        }
+    }
+
+    run->size.x = codepointCount > 0 ? measuredWidth * scale + (codepointCount - 1) * spacing : 0.0f;
+    run->size.y = codepointCount > 0 ? fontSize : 0.0f;
+    return run;
+}
+
+// Find or build the run for a key (NULL for text the cache doesn't handle)
+static TextRun *GetRun(Font font, const char *text, float fontSize, float spacing) {
+    size_t len = 0;
+    bool multiline = false;
+    uint32_t hash = HashKey(text, font.texture.id, fontSize, spacing, &len, &multiline);
+    if (multiline || len == 0) return NULL;
+
+    uint32_t pos = hash & (TABLE_SIZE - 1);
+    while (g_table[pos]) {
+        TextRun *run = g_table[pos];
+        if (run->hash == hash && run->fontId == font.texture.id &&
+            run->fontSize == fontSize && run->spacing == spacing && strcmp(run->text, text) == 0) {
+            run->lastUsed = g_frame;
+            return run;
+        }
+        pos = (pos + 1) & (TABLE_SIZE - 1);
+    }
+
+    if (g_count >= TEXT_CACHE_CAPACITY) Evict();
+
+    TextRun *run = BuildRun(font, text, len, fontSize, spacing, hash);
+    if (!run) return NULL;
+    run->lastUsed = g_frame;
+    Insert(run);
+    return run;
+}
+
+void TextCacheDraw(Font font, const char *text, Vector2 position, float fontSize, float spacing, Color tint) {
+    if (font.texture.id == 0) font = GetFontDefault();
+    if (!text || !text[0]) return;
+
+    TextRun *run = GetRun(font, text, fontSize, spacing);
+    if (!run) {
+        DrawTextEx(font, text, position, fontSize, spacing, tint);
+        return;
+    }
+
+    for (int i = 0; i < run->glyphCount; i++) {
+        Rectangle dst = run->glyphs[i].dst;
+        dst.x += position.x;
+        dst.y += position.y;
+        DrawTexturePro(font.texture, run->glyphs[i].src, dst, (Vector2){0, 0}, 0.0f, tint);
+    }
+}
+
+Vector2 TextCacheMeasure(Font font, const char *text, float fontSize, float spacing) {
+    // Same fallback as TextCacheDraw, so layout matches what gets drawn
+    if (font.texture.id == 0) font = GetFontDefault();
+    if (!text || !text[0]) return (Vector2){0, 0};
+
+    TextRun *run = GetRun(font, text, fontSize, spacing);
+    if (!run) return MeasureTextEx(font, text, fontSize, spacing);
+    return run->size;
+}
+
+void TextCacheNextFrame(void) {
+    g_frame++;
+}
+
+void TextCacheClear(void) {
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        if (g_table[i]) {
+            FreeRun(g_table[i]);
+            g_table[i] = NULL;
+        }
+    }
+    g_count = 0;
+}
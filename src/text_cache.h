@@ -0,0 +1,32 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include "raylib.h"
+
+// ============================================================================
+// Text Cache - Pre-laid-out glyph runs for strings drawn every frame
+// ============================================================================
+//
+// Drop-in replacements for DrawTextEx/MeasureTextEx. The first call for a
+// (font, text, size, spacing) key decodes the string, looks up each glyph and
+// stores the resulting quads together with the measured extent; later calls
+// with the same key just replay the quads. A changed string is simply a new
+// key. Entries not used for a while are evicted when the table fills up.
+// UI thread only.
+
+// Maximum number of cached runs
+#define TEXT_CACHE_CAPACITY 512
+
+// Draw text (same output as DrawTextEx)
+void TextCacheDraw(Font font, const char *text, Vector2 position, float fontSize, float spacing, Color tint);
+
+// Measure text (same result as MeasureTextEx)
+Vector2 TextCacheMeasure(Font font, const char *text, float fontSize, float spacing);
+
+// Advance the eviction clock; call once per frame
+void TextCacheNextFrame(void);
+
+// Drop every cached run (e.g. after the font changes)
+void TextCacheClear(void);
+
+#endif // TEXT_CACHE_H
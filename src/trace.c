@@ -0,0 +1,282 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+// ============================================================================
+// Trace Implementation
+// ============================================================================
+
+typedef struct {
+    const char *name;
+    const char *category;
+    uint64_t start;                 // ns, CLOCK_MONOTONIC
+    uint64_t duration;
+    int tid;
+    const char *argName;            // NULL if no numeric argument
+    long long argValue;
+    char detail[TRACE_DETAIL_MAX];
+} TraceEvent;
+
+#define TRACE_MAX_THREADS 64
+
+typedef struct {
+    int tid;
+    char name[32];
+} TraceThread;
+
+// Ring of completed spans, in completion order (guarded by g_traceMutex;
+// g_enabled is also read unlocked on every call)
+static bool g_enabled = false;
+static pthread_mutex_t g_traceMutex = PTHREAD_MUTEX_INITIALIZER;
+static TraceEvent *g_events = NULL;
+static size_t g_next = 0;           // Slot the next span goes in
+static size_t g_count = 0;          // Spans held, up to TRACE_MAX_EVENTS
+static size_t g_overwritten = 0;
+static uint64_t g_origin = 0;       // Trace timestamps count from here
+static char g_path[1024] = "";
+static TraceThread g_threads[TRACE_MAX_THREADS];
+static int g_threadCount = 0;
+
+static __thread int t_tid = 0;
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int ThreadId(void) {
+    if (t_tid == 0) t_tid = (int)syscall(SYS_gettid);
+    return t_tid;
+}
+
+bool TraceEnabled(void) {
+    return __atomic_load_n(&g_enabled, __ATOMIC_RELAXED);
+}
+
+bool TraceStart(const char *path) {
+    pthread_mutex_lock(&g_traceMutex);
+    if (path && path[0] && g_path[0] == '\0') {
+        snprintf(g_path, sizeof(g_path), "%s", path);
+    }
+    if (!g_events) {
+        g_events = calloc(TRACE_MAX_EVENTS, sizeof(TraceEvent));
+        if (!g_events) {
+            pthread_mutex_unlock(&g_traceMutex);
+            printf("Trace: Out of memory\n");
+            return false;
+        }
+        g_next = 0;
+        g_count = 0;
+        g_overwritten = 0;
+        g_origin = NowNs();
+        printf("Trace: Recording%s%s\n", g_path[0] ? " to " : "", g_path);
+    }
+    __atomic_store_n(&g_enabled, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_traceMutex);
+    return true;
+}
+
+uint64_t TraceBegin(void) {
+    return TraceEnabled() ? NowNs() : 0;
+}
+
+void TraceEndArgs(const char *name, const char *category, uint64_t start,
+                  const char *argName, long long argValue, const char *detail) {
+    if (start == 0 || !TraceEnabled()) return;
+    uint64_t end = NowNs();
+    int tid = ThreadId();
+
+    pthread_mutex_lock(&g_traceMutex);
+    if (g_events) {
+        TraceEvent *event = &g_events[g_next];
+        event->name = name;
+        event->category = category;
+        event->start = start;
+        event->duration = end - start;
+        event->tid = tid;
+        event->argName = argName;
+        event->argValue = argValue;
+        snprintf(event->detail, sizeof(event->detail), "%s", detail ? detail : "");
+        g_next = (g_next + 1) % TRACE_MAX_EVENTS;
+        if (g_count < TRACE_MAX_EVENTS) {
+            g_count++;
+        } else {
+            g_overwritten++;
+        }
+    }
+    pthread_mutex_unlock(&g_traceMutex);
+}
+
+void TraceEnd(const char *name, const char *category, uint64_t start) {
+    TraceEndArgs(name, category, start, NULL, 0, NULL);
+}
+
+void TraceNameThread(const char *name) {
+    int tid = ThreadId();
+    pthread_mutex_lock(&g_traceMutex);
+    int i = 0;
+    while (i < g_threadCount && g_threads[i].tid != tid) i++;
+    if (i < TRACE_MAX_THREADS) {
+        g_threads[i].tid = tid;
+        snprintf(g_threads[i].name, sizeof(g_threads[i].name), "%s", name);
+        if (i == g_threadCount) g_threadCount++;
+    }
+    pthread_mutex_unlock(&g_traceMutex);
+}
+
+// ============================================================================
+// Chrome trace export
+// ============================================================================
+
+static void WriteJsonString(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// Caller holds g_traceMutex
+static bool WriteTrace(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) return false;
+
+    int pid = (int)getpid();
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"overwritten\": %zu},\n"
+                 "\"traceEvents\": [\n", g_overwritten);
+    fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": 0, "
+                 "\"args\": {\"name\": \"salamander\"}}", pid);
+    for (int i = 0; i < g_threadCount; i++) {
+        fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+                     "\"args\": {\"name\": ", pid, g_threads[i].tid);
+        WriteJsonString(out, g_threads[i].name);
+        fputs("}}", out);
+    }
+
+    size_t first = (g_next + TRACE_MAX_EVENTS - g_count) % TRACE_MAX_EVENTS;
+    for (size_t n = 0; n < g_count; n++) {
+        const TraceEvent *e = &g_events[(first + n) % TRACE_MAX_EVENTS];
+        // Microseconds, as the format expects
+        fputs(",\n{\"name\": ", out);
+        WriteJsonString(out, e->name);
+        fputs(", \"cat\": ", out);
+        WriteJsonString(out, e->category);
+        fprintf(out, ", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %d",
+                (e->start - g_origin) / 1e3, e->duration / 1e3, pid, e->tid);
+        if (e->argName || e->detail[0]) {
+            fputs(", \"args\": {", out);
+            if (e->argName) {
+                WriteJsonString(out, e->argName);
+                fprintf(out, ": %lld%s", e->argValue, e->detail[0] ? ", " : "");
+            }
+            if (e->detail[0]) {
+                fputs("\"detail\": ", out);
+                WriteJsonString(out, e->detail);
+            }
+            fputc('}', out);
+        }
+        fputc('}', out);
+    }
+    fputs("\n]}\n", out);
+    return fclose(out) == 0;
+}
+
+void TraceStop(void) {
+    __atomic_store_n(&g_enabled, false, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&g_traceMutex);
+    if (g_events && g_path[0]) {
+        if (WriteTrace(g_path)) {
+            printf("Trace: Wrote %zu spans to %s\n", g_count, g_path);
+        } else {
+            printf("Trace: Cannot write %s\n", g_path);
+        }
+    }
+    free(g_events);
+    g_events = NULL;
+    g_count = 0;
+    g_next = 0;
+    g_path[0] = '\0';
+    pthread_mutex_unlock(&g_traceMutex);
+}
+
+// ============================================================================
+// Summaries
+// ============================================================================
+
+static bool IsChild(const TraceEvent *e, const char *childCategory) {
+    if (childCategory) return strcmp(e->category, childCategory) == 0;
+    return strcmp(e->category, TRACE_CAT_FRAME) != 0 && strcmp(e->category, TRACE_CAT_UI) != 0 &&
+           strcmp(e->category, TRACE_CAT_OP) != 0;
+}
+
+static int CompareTotals(const void *a, const void *b) {
+    double x = ((const TraceTotal *)a)->totalMs;
+    double y = ((const TraceTotal *)b)->totalMs;
+    return (x < y) - (x > y);
+}
+
+int TraceLastBreakdown(const char *rootCategory, const char *childCategory,
+                       TraceTotal *root, TraceTotal *totals, int maxTotals) {
+    int used = 0;
+    memset(root, 0, sizeof(*root));
+
+    pthread_mutex_lock(&g_traceMutex);
+    if (!g_events) {
+        pthread_mutex_unlock(&g_traceMutex);
+        return 0;
+    }
+
+    // Newest root first; spans are stored as they complete, so its children
+    // come before it, back to the first one that ended before it started
+    size_t n = 0;
+    const TraceEvent *found = NULL;
+    for (; n < g_count; n++) {
+        const TraceEvent *e = &g_events[(g_next + TRACE_MAX_EVENTS - 1 - n) % TRACE_MAX_EVENTS];
+        if (strcmp(e->category, rootCategory) == 0) {
+            found = e;
+            break;
+        }
+    }
+    if (found) {
+        root->name = found->name;
+        root->totalMs = found->duration / 1e6;
+        root->count = 1;
+        uint64_t end = found->start + found->duration;
+        for (n++; n < g_count; n++) {
+            const TraceEvent *e = &g_events[(g_next + TRACE_MAX_EVENTS - 1 - n) % TRACE_MAX_EVENTS];
+            if (e->start + e->duration < found->start) break;
+            if (e->start < found->start || e->start + e->duration > end || !IsChild(e, childCategory)) {
+                continue;
+            }
+            int i = 0;
+            while (i < used && strcmp(totals[i].name, e->name) != 0) i++;
+            if (i == used) {
+                if (used == maxTotals) continue;
+                totals[used].name = e->name;
+                totals[used].totalMs = 0;
+                totals[used].count = 0;
+                used++;
+            }
+            totals[i].totalMs += e->duration / 1e6;
+            totals[i].count++;
+        }
+    }
+    pthread_mutex_unlock(&g_traceMutex);
+
+    qsort(totals, (size_t)used, sizeof(TraceTotal), CompareTotals);
+    return used;
+}
@@ -0,0 +1,84 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// Trace - Scoped timing spans with Chrome trace (about:tracing) export
+// ============================================================================
+//
+// Off by default: every call checks one atomic flag and returns, so spans can
+// stay in hot paths. Once started, completed spans go into a fixed ring of
+// TRACE_MAX_EVENTS (the oldest are overwritten) and TraceStop writes them as
+// Chrome trace JSON, which chrome://tracing and Perfetto open directly.
+// Names and categories are stored by pointer and must be string literals;
+// the optional detail text is copied. Safe from any thread.
+
+#define TRACE_MAX_EVENTS (128 * 1024)
+#define TRACE_DETAIL_MAX 64
+
+// Categories
+#define TRACE_CAT_FRAME "frame"     // One span per UI frame
+#define TRACE_CAT_UI    "ui"        // Phases inside a frame
+#define TRACE_CAT_OP    "op"        // User-visible operations: refresh, batch
+#define TRACE_CAT_SSH   "ssh"       // Sessions, remote commands, transfers
+#define TRACE_CAT_LOCAL "local"     // Local scans, hashing, list merges
+
+// Start recording. path (may be NULL) receives the trace at TraceStop.
+// Calling it again while recording only sets the path if none was given.
+bool TraceStart(const char *path);
+
+// Stop recording, write the trace file if one was given, free the ring
+void TraceStop(void);
+
+bool TraceEnabled(void);
+
+// Timestamp for a span start; 0 when tracing is off (the span is skipped)
+uint64_t TraceBegin(void);
+
+// Record a span that started at start (from TraceBegin)
+void TraceEnd(const char *name, const char *category, uint64_t start);
+
+// Same, with one numeric argument (bytes, counts) and/or a detail string
+void TraceEndArgs(const char *name, const char *category, uint64_t start,
+                  const char *argName, long long argValue, const char *detail);
+
+// Label the calling thread in the trace
+void TraceNameThread(const char *name);
+
+// One span per scope:  TRACE_SCOPE("Local scan", TRACE_CAT_LOCAL);
+typedef struct {
+    const char *name;
+    const char *category;
+    uint64_t start;
+} TraceSpan;
+
+static inline void TraceSpanEnd(TraceSpan *span) {
+    if (span->start) TraceEnd(span->name, span->category, span->start);
+}
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name, category) \
+    TraceSpan TRACE_JOIN(traceSpan_, __LINE__) __attribute__((cleanup(TraceSpanEnd))) = \
+        { (name), (category), TraceBegin() }
+
+// ============================================================================
+// Summaries (for the on-screen overlay)
+// ============================================================================
+
+typedef struct {
+    const char *name;
+    double totalMs;
+    int count;
+} TraceTotal;
+
+// The newest recorded span of rootCategory goes in *root; the spans of
+// childCategory that ran inside it (on any thread) are summed by name into
+// totals, longest first. childCategory NULL takes every category except
+// frame, ui and op. Returns the number of totals (0 if there is no root).
+int TraceLastBreakdown(const char *rootCategory, const char *childCategory,
+                       TraceTotal *root, TraceTotal *totals, int maxTotals);
+
+#endif // TRACE_H
@@ -0,0 +1,17 @@
+#ifndef XXH64_H
+#define XXH64_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// XXH64 - Fast non-cryptographic hash for local change detection
+// ============================================================================
+//
+// Several GB/s in plain C, against roughly 200 MB/s for SHA-256. Only used
+// on the host to tell whether a file's bytes changed; the device compares
+// SHA-256 (sha256sum), so that stays the hash that is sent and stored.
+
+uint64_t Xxh64(const void *data, size_t len, uint64_t seed);
+
+#endif // XXH64_H